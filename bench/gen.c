@@ -0,0 +1,254 @@
+// Writes a random program of a given size and shape to stdout, for the
+// compile benchmarks. The same options and seed always give the same
+// program: the generator has its own random number generator rather than
+// the C library's.
+//
+//   gen [--seed <n>] [--decls <n>] [--statements <n>] [--depth <n>]
+//       [--assign-ratio <0..1>] [--ident-length <min>:<max>]
+//       [--comments <0..1>]
+//
+// --decls variables and constants are declared, interleaved with
+// --statements assignments and prints, of which --assign-ratio are
+// assignments. Every initialiser and right-hand side is an expression of
+// exactly --depth levels of operators. Identifiers are between the two
+// --ident-length bounds long, uniformly, and a line comment precedes each
+// statement with probability --comments.
+//
+// Divisors are positive literals, so the programs never trap.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct options {
+  unsigned long long seed;
+  int decls;
+  int statements;
+  int depth;
+  double assign_ratio;
+  int ident_min;
+  int ident_max;
+  double comments;
+};
+
+struct variable {
+  char *name;
+  bool constant;
+};
+
+static uint64_t state;
+
+// splitmix64.
+static uint64_t next(void) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// In [0, n).
+static int below(int n) { return (int)(next() % (uint64_t)n); }
+
+static bool chance(double p) { return (next() >> 11) * 0x1.0p-53 < p; }
+
+// Random letters and digits, ending in an underscore and the index of the
+// variable. The last underscore separates the two, so every name is unique
+// and none is a keyword.
+static char *identifier(struct options *options, int index) {
+  char suffix[16];
+  int suffix_length = snprintf(suffix, sizeof(suffix), "_%d", index);
+
+  int length = options->ident_min +
+               below(options->ident_max - options->ident_min + 1);
+  if (length < suffix_length + 1)
+    length = suffix_length + 1;
+
+  char *name = malloc(length + 1);
+  if (name == NULL) {
+    fprintf(stderr, "gen: out of memory\n");
+    exit(1);
+  }
+
+  static const char first[] = "abcdefghijklmnopqrstuvwxyz_";
+  static const char rest[] = "abcdefghijklmnopqrstuvwxyz_0123456789";
+  name[0] = first[below(sizeof(first) - 1)];
+  for (int i = 1; i < length - suffix_length; i++)
+    name[i] = rest[below(sizeof(rest) - 1)];
+  memcpy(name + length - suffix_length, suffix, suffix_length + 1);
+
+  return name;
+}
+
+static void leaf(struct variable *variables, int num_variables) {
+  if (num_variables > 0 && chance(0.6)) {
+    printf("%s", variables[below(num_variables)].name);
+  } else {
+    printf("%d", below(1000));
+  }
+}
+
+static void expression(struct variable *variables, int num_variables,
+                       int depth);
+
+// Grouped unless it is a leaf, so that precedence keeps the shape.
+static void operand(struct variable *variables, int num_variables,
+                    int depth) {
+  if (depth > 0)
+    printf("(");
+  expression(variables, num_variables, depth);
+  if (depth > 0)
+    printf(")");
+}
+
+// An expression with exactly depth levels of operators: one operand has
+// depth - 1 and the other any depth below that.
+static void expression(struct variable *variables, int num_variables,
+                       int depth) {
+  if (depth == 0) {
+    leaf(variables, num_variables);
+    return;
+  }
+
+  if (chance(0.1)) {
+    printf("-");
+    operand(variables, num_variables, depth - 1);
+    return;
+  }
+
+  static const char operators[] = "+-*/";
+  char operator = operators[below(4)];
+  bool left_deep = operator == '/' || chance(0.5);
+  int left = left_deep ? depth - 1 : below(depth);
+  int right = left_deep ? below(depth) : depth - 1;
+
+  operand(variables, num_variables, left);
+  printf(" %c ", operator);
+  if (operator == '/') {
+    printf("%d", 1 + below(99));
+  } else {
+    operand(variables, num_variables, right);
+  }
+}
+
+static void comment(struct options *options, int line) {
+  if (chance(options->comments))
+    printf("// Statement %d of the benchmark, generated with seed %llu.\n",
+           line, options->seed);
+}
+
+static void generate(struct options *options) {
+  struct variable *variables =
+      malloc((options->decls + 1) * sizeof(*variables));
+  int *assignable = malloc((options->decls + 1) * sizeof(*assignable));
+  if (variables == NULL || assignable == NULL) {
+    fprintf(stderr, "gen: out of memory\n");
+    exit(1);
+  }
+
+  int num_variables = 0;
+  int num_assignable = 0;
+  int total = options->decls + options->statements;
+
+  for (int line = 0; line < total; line++) {
+    comment(options, line);
+
+    // Declarations are spread evenly, and come first if there is nothing
+    // yet to assign to.
+    int decls_left = options->decls - num_variables;
+    bool declare =
+        decls_left > 0 &&
+        (num_assignable == 0 || below(total - line) < decls_left);
+
+    if (declare) {
+      struct variable *variable = &variables[num_variables];
+      variable->name = identifier(options, num_variables);
+      variable->constant = chance(0.25);
+
+      printf("%s %s: i32 = ", variable->constant ? "const" : "var",
+             variable->name);
+      expression(variables, num_variables, options->depth);
+      printf(";\n");
+
+      if (!variable->constant)
+        assignable[num_assignable++] = num_variables;
+      num_variables++;
+    } else if (chance(options->assign_ratio)) {
+      printf("%s = ", variables[assignable[below(num_assignable)]].name);
+      expression(variables, num_variables, options->depth);
+      printf(";\n");
+    } else {
+      printf("print(");
+      expression(variables, num_variables, options->depth);
+      printf(");\n");
+    }
+  }
+
+  for (int i = 0; i < num_variables; i++)
+    free(variables[i].name);
+  free(variables);
+  free(assignable);
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [--seed <n>] [--decls <n>] [--statements <n>] "
+          "[--depth <n>] [--assign-ratio <0..1>] "
+          "[--ident-length <min>:<max>] [--comments <0..1>]\n",
+          name);
+}
+
+int main(int argc, char *argv[]) {
+  struct options options = {
+      .seed = 1,
+      .decls = 100,
+      .statements = 100,
+      .depth = 3,
+      .assign_ratio = 0.5,
+      .ident_min = 1,
+      .ident_max = 8,
+      .comments = 0,
+  };
+
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 == argc) {
+      usage(argv[0]);
+      return 1;
+    }
+
+    const char *value = argv[++i];
+    if (strcmp(argv[i - 1], "--seed") == 0) {
+      options.seed = strtoull(value, NULL, 10);
+    } else if (strcmp(argv[i - 1], "--decls") == 0) {
+      options.decls = atoi(value);
+    } else if (strcmp(argv[i - 1], "--statements") == 0) {
+      options.statements = atoi(value);
+    } else if (strcmp(argv[i - 1], "--depth") == 0) {
+      options.depth = atoi(value);
+    } else if (strcmp(argv[i - 1], "--assign-ratio") == 0) {
+      options.assign_ratio = atof(value);
+    } else if (strcmp(argv[i - 1], "--ident-length") == 0) {
+      if (sscanf(value, "%d:%d", &options.ident_min, &options.ident_max) !=
+          2) {
+        usage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i - 1], "--comments") == 0) {
+      options.comments = atof(value);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (options.decls < 1 || options.statements < 0 || options.depth < 0 ||
+      options.ident_min < 1 || options.ident_max < options.ident_min) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  state = options.seed;
+  generate(&options);
+  return 0;
+}
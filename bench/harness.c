@@ -0,0 +1,331 @@
+// Times the compiler end to end on each program: every run starts a fresh
+// bin process with its output discarded. Reports the median and 95th
+// percentile wall time, tokens per second at the median and the peak
+// resident set of the compiler process, and writes them as JSON to compare
+// with the results of another build.
+//
+//   harness [--bin <path>] [--runs <n>] [--warmup <n>] [--arg <arg>]...
+//           [--label <text>] [--out <path>] [--baseline <path>] <file>...
+//
+// Each --arg is passed to bin after the program, in order. The JSON has one
+// workload per line, which is what --baseline reads back.
+//
+//   make bench
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../compiler/scanner.h"
+
+#define MAX_ARGS 32
+#define MAX_BASELINE 256
+
+struct options {
+  const char *bin;
+  int runs;
+  int warmup;
+  const char *args[MAX_ARGS];
+  int num_args;
+  const char *label;
+  const char *out;
+  const char *baseline;
+};
+
+struct result {
+  char name[64];
+  long long bytes;
+  long long tokens;
+  long long median;
+  long long p95;
+  long long min;
+  long max_rss;
+};
+
+struct baseline {
+  char name[64];
+  long long median;
+};
+
+static char *read_file(const char *path, long long *size) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "harness: cannot open '%s'\n", path);
+    exit(1);
+  }
+
+  fseek(file, 0L, SEEK_END);
+  *size = ftell(file);
+  rewind(file);
+
+  char *data = malloc(*size + 1);
+  if (data == NULL || (long long)fread(data, 1, *size, file) != *size) {
+    fprintf(stderr, "harness: cannot read '%s'\n", path);
+    exit(1);
+  }
+
+  fclose(file);
+  data[*size] = '\0';
+  return data;
+}
+
+static long long now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static long long count_tokens(const char *src) {
+  scanner_t *scanner = scanner_new(src);
+  long long count = 1;
+  while (scanner_read_token(scanner).type != TOKEN_EOF)
+    count++;
+  scanner_free(&scanner);
+  return count;
+}
+
+// One compile, in nanoseconds, or -1 if it failed. Adds the peak resident
+// set of the process in KiB to *max_rss.
+static long long run(struct options *options, const char *path,
+                     long *max_rss) {
+  const char *argv[MAX_ARGS + 3];
+  argv[0] = options->bin;
+  argv[1] = path;
+  for (int i = 0; i < options->num_args; i++)
+    argv[2 + i] = options->args[i];
+  argv[2 + options->num_args] = NULL;
+
+  long long start = now();
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("harness: fork");
+    exit(1);
+  }
+
+  if (pid == 0) {
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    dup2(null, STDERR_FILENO);
+    execv(options->bin, (char *const *)argv);
+    _exit(127);
+  }
+
+  int status;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) < 0) {
+    perror("harness: wait4");
+    exit(1);
+  }
+  long long time = now() - start;
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    return -1;
+
+  if (usage.ru_maxrss > *max_rss)
+    *max_rss = usage.ru_maxrss;
+  return time;
+}
+
+static int compare(const void *a, const void *b) {
+  long long x = *(const long long *)a;
+  long long y = *(const long long *)b;
+  return (x > y) - (x < y);
+}
+
+static bool bench(struct options *options, const char *path,
+                  struct result *result) {
+  const char *base = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+  snprintf(result->name, sizeof(result->name), "%.*s",
+           (int)(strcspn(base, ".")), base);
+
+  char *src = read_file(path, &result->bytes);
+  result->tokens = count_tokens(src);
+  free(src);
+
+  long long *times = malloc(options->runs * sizeof(*times));
+  if (times == NULL) {
+    fprintf(stderr, "harness: out of memory\n");
+    exit(1);
+  }
+
+  result->max_rss = 0;
+  for (int i = 0; i < options->warmup + options->runs; i++) {
+    long long time = run(options, path, &result->max_rss);
+    if (time < 0) {
+      fprintf(stderr, "harness: '%s %s' failed\n", options->bin, path);
+      free(times);
+      return false;
+    }
+    if (i >= options->warmup)
+      times[i - options->warmup] = time;
+  }
+
+  qsort(times, options->runs, sizeof(*times), compare);
+
+  int n = options->runs;
+  result->median =
+      n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+  // Nearest rank.
+  result->p95 = times[(95 * n + 99) / 100 - 1];
+  result->min = times[0];
+
+  free(times);
+  return true;
+}
+
+// Reads the name and median of each workload of an earlier --out.
+static int read_baseline(const char *path, struct baseline *baseline) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "harness: cannot open '%s'\n", path);
+    exit(1);
+  }
+
+  char line[1024];
+  int count = 0;
+  while (count < MAX_BASELINE && fgets(line, sizeof(line), file)) {
+    char *name = strstr(line, "\"name\": \"");
+    char *median = strstr(line, "\"median_ns\": ");
+    if (name == NULL || median == NULL)
+      continue;
+
+    if (sscanf(name, "\"name\": \"%63[^\"]\"", baseline[count].name) == 1 &&
+        sscanf(median, "\"median_ns\": %lld", &baseline[count].median) == 1)
+      count++;
+  }
+
+  fclose(file);
+  return count;
+}
+
+static struct baseline *find(struct baseline *baseline, int count,
+                             const char *name) {
+  for (int i = 0; i < count; i++) {
+    if (strcmp(baseline[i].name, name) == 0)
+      return &baseline[i];
+  }
+  return NULL;
+}
+
+static void write_json(struct options *options, struct result *results,
+                       int count) {
+  FILE *file = fopen(options->out, "w");
+  if (file == NULL) {
+    fprintf(stderr, "harness: cannot open '%s' for writing\n", options->out);
+    exit(1);
+  }
+
+  fprintf(file, "{\"label\": \"%s\", \"bin\": \"%s\", \"runs\": %d, ",
+          options->label ? options->label : "", options->bin, options->runs);
+  fprintf(file, "\"args\": [");
+  for (int i = 0; i < options->num_args; i++)
+    fprintf(file, "%s\"%s\"", i > 0 ? ", " : "", options->args[i]);
+  fprintf(file, "],\n \"workloads\": [");
+
+  for (int i = 0; i < count; i++) {
+    struct result *result = &results[i];
+    fprintf(file,
+            "%s\n  {\"name\": \"%s\", \"bytes\": %lld, \"tokens\": %lld, "
+            "\"median_ns\": %lld, \"p95_ns\": %lld, \"min_ns\": %lld, "
+            "\"tokens_per_second\": %.0f, \"max_rss_kib\": %ld}",
+            i > 0 ? "," : "", result->name, result->bytes, result->tokens,
+            result->median, result->p95, result->min,
+            result->tokens / (result->median / 1e9), result->max_rss);
+  }
+
+  fprintf(file, "\n]}\n");
+  fclose(file);
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [--bin <path>] [--runs <n>] [--warmup <n>] "
+          "[--arg <arg>]... [--label <text>] [--out <path>] "
+          "[--baseline <path>] <file>...\n",
+          name);
+}
+
+int main(int argc, char *argv[]) {
+  struct options options = {.bin = "./bin", .runs = 20, .warmup = 2};
+
+  int first = 1;
+  for (; first + 1 < argc && strncmp(argv[first], "--", 2) == 0; first += 2) {
+    const char *option = argv[first];
+    const char *value = argv[first + 1];
+
+    if (strcmp(option, "--bin") == 0) {
+      options.bin = value;
+    } else if (strcmp(option, "--runs") == 0) {
+      options.runs = atoi(value);
+    } else if (strcmp(option, "--warmup") == 0) {
+      options.warmup = atoi(value);
+    } else if (strcmp(option, "--arg") == 0 && options.num_args < MAX_ARGS) {
+      options.args[options.num_args++] = value;
+    } else if (strcmp(option, "--label") == 0) {
+      options.label = value;
+    } else if (strcmp(option, "--out") == 0) {
+      options.out = value;
+    } else if (strcmp(option, "--baseline") == 0) {
+      options.baseline = value;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (first >= argc || options.runs <= 0 || options.warmup < 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  struct baseline baseline[MAX_BASELINE];
+  int num_baseline =
+      options.baseline ? read_baseline(options.baseline, baseline) : 0;
+
+  int count = argc - first;
+  struct result *results = malloc(count * sizeof(*results));
+  if (results == NULL) {
+    fprintf(stderr, "harness: out of memory\n");
+    return 1;
+  }
+
+  printf("%-12s %9s %9s %11s %11s %12s %10s", "workload", "bytes", "tokens",
+         "median (ms)", "p95 (ms)", "tokens/s", "RSS (KiB)");
+  printf(options.baseline ? " %13s %8s\n" : "\n", "baseline (ms)", "change");
+
+  bool ok = true;
+  int done = 0;
+  for (int i = first; i < argc; i++) {
+    struct result *result = &results[done];
+    if (!bench(&options, argv[i], result)) {
+      ok = false;
+      continue;
+    }
+    done++;
+
+    printf("%-12s %9lld %9lld %11.3f %11.3f %12.0f %10ld", result->name,
+           result->bytes, result->tokens, result->median / 1e6,
+           result->p95 / 1e6, result->tokens / (result->median / 1e9),
+           result->max_rss);
+
+    struct baseline *before = find(baseline, num_baseline, result->name);
+    if (before) {
+      printf(" %13.3f %+7.1f%%\n", before->median / 1e6,
+             100.0 * (result->median - before->median) / before->median);
+    } else {
+      printf(options.baseline ? " %13s %8s\n" : "\n", "-", "-");
+    }
+  }
+
+  if (options.out)
+    write_json(&options, results, done);
+
+  free(results);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,336 @@
+// Microbenchmarks of single components of the compiler, in nanoseconds per
+// operation, so that a regression shows up in the component that caused it
+// rather than only end to end:
+//
+//   scanner        scanner_read_token over the corpus, per token
+//   symbols        symbol_table_add, and symbol_table_get of names that are
+//                  in the table and names that are not, per call, at several
+//                  load factors (names per bucket) and name lengths
+//   resolve        resolver_generate_table over the parsed corpus, per node
+//   typecheck      typecheck over the resolved corpus, per node
+//
+// The process is pinned to the CPU it starts on. Each benchmark runs
+// WARMUP times untimed, then BATCHES times, each batch repeating the
+// benchmark for at least BATCH_NS; the median and minimum of the batches
+// are reported.
+//
+//   make micro-bench
+//   micro <corpus>
+
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../compiler/ast.h"
+#include "../compiler/parser.h"
+#include "../compiler/resolver.h"
+#include "../compiler/scanner.h"
+#include "../compiler/symbols.h"
+#include "../compiler/typechecker.h"
+
+#define WARMUP 3
+#define BATCHES 31
+#define BATCH_NS 2000000LL
+
+#define SYMBOL_CAPACITY 1024
+
+// A benchmark returns the nanoseconds its timed part took; setup and
+// teardown around it are not counted.
+struct benchmark {
+  long long (*run)(void *arg);
+  void *arg;
+  long long ops;
+};
+
+struct corpus {
+  const char *src;
+  long long tokens;
+  struct ast_node *root;
+  long long nodes;
+  symbol_table_t *table;
+};
+
+struct symbols {
+  // What every name is declared as, as symbol_table_get returns NULL for
+  // names that are not in the table.
+  struct ast_node decl;
+
+  int count;
+  struct scanner_token *names;
+  struct scanner_token *missing;
+  symbol_table_t *table;
+};
+
+static long long now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static char *read_file(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "micro: cannot open '%s'\n", path);
+    exit(1);
+  }
+
+  fseek(file, 0L, SEEK_END);
+  size_t size = ftell(file);
+  rewind(file);
+
+  char *data = malloc(size + 1);
+  if (data == NULL || fread(data, 1, size, file) != size) {
+    fprintf(stderr, "micro: cannot read '%s'\n", path);
+    exit(1);
+  }
+
+  fclose(file);
+  data[size] = '\0';
+  return data;
+}
+
+static void *allocate(size_t size) {
+  void *data = malloc(size);
+  if (data == NULL) {
+    fprintf(stderr, "micro: out of memory\n");
+    exit(1);
+  }
+  return data;
+}
+
+static int compare(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static void measure(const char *name, struct benchmark *benchmark) {
+  for (int i = 0; i < WARMUP; i++)
+    benchmark->run(benchmark->arg);
+
+  // Enough repetitions for each batch to last BATCH_NS.
+  long long once = benchmark->run(benchmark->arg);
+  long long repetitions = once > 0 ? BATCH_NS / once + 1 : 1;
+
+  double batches[BATCHES];
+  for (int i = 0; i < BATCHES; i++) {
+    long long total = 0;
+    for (long long j = 0; j < repetitions; j++)
+      total += benchmark->run(benchmark->arg);
+    batches[i] = (double)total / (repetitions * benchmark->ops);
+  }
+
+  qsort(batches, BATCHES, sizeof(*batches), compare);
+  printf("%-32s %10lld %10.2f %10.2f\n", name, benchmark->ops,
+         batches[BATCHES / 2], batches[0]);
+}
+
+static long long scan(void *arg) {
+  struct corpus *corpus = arg;
+
+  long long start = now();
+  scanner_t *scanner = scanner_new(corpus->src);
+  while (scanner_read_token(scanner).type != TOKEN_EOF)
+    ;
+  scanner_free(&scanner);
+  return now() - start;
+}
+
+static long long resolve(void *arg) {
+  struct corpus *corpus = arg;
+  symbol_table_t *table = symbol_table_new(100);
+
+  long long start = now();
+  if (!resolver_generate_table(corpus->root, table)) {
+    fprintf(stderr, "micro: the corpus does not resolve\n");
+    exit(1);
+  }
+  long long time = now() - start;
+
+  symbol_table_free(&table);
+  return time;
+}
+
+static long long check(void *arg) {
+  struct corpus *corpus = arg;
+
+  long long start = now();
+  if (typecheck(corpus->root, corpus->table) == TYPE_ERROR) {
+    fprintf(stderr, "micro: the corpus does not typecheck\n");
+    exit(1);
+  }
+  return now() - start;
+}
+
+static long long add(void *arg) {
+  struct symbols *symbols = arg;
+  symbol_table_t *table = symbol_table_new(SYMBOL_CAPACITY);
+
+  long long start = now();
+  for (int i = 0; i < symbols->count; i++)
+    symbol_table_add(table, &symbols->names[i], &symbols->decl);
+  long long time = now() - start;
+
+  symbol_table_free(&table);
+  return time;
+}
+
+static long long get(void *arg) {
+  struct symbols *symbols = arg;
+
+  long long start = now();
+  for (int i = 0; i < symbols->count; i++) {
+    if (symbol_table_get(symbols->table, &symbols->names[i]) == NULL)
+      abort();
+  }
+  return now() - start;
+}
+
+static long long miss(void *arg) {
+  struct symbols *symbols = arg;
+
+  long long start = now();
+  for (int i = 0; i < symbols->count; i++) {
+    if (symbol_table_get(symbols->table, &symbols->missing[i]) != NULL)
+      abort();
+  }
+  return now() - start;
+}
+
+// splitmix64, for names that are the same on every run.
+static uint64_t next(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// count distinct names of the given length, all different from each other.
+static struct scanner_token *names(int count, int length, uint64_t *state,
+                                   char *storage) {
+  struct scanner_token *tokens = allocate(count * sizeof(*tokens));
+
+  for (int i = 0; i < count; i++) {
+    char *name = storage + (size_t)i * length;
+    // The counter makes them distinct; the rest is random.
+    int prefix = snprintf(name, length + 1, "%x", (unsigned)i);
+    if (prefix > length) {
+      fprintf(stderr, "micro: names of length %d are too short\n", length);
+      exit(1);
+    }
+    for (int j = prefix; j < length; j++)
+      name[j] = 'a' + next(state) % 26;
+
+    tokens[i] = (struct scanner_token){TOKEN_IDENTIFIER, name, length, 1};
+  }
+
+  return tokens;
+}
+
+static void bench_symbols(double load, int length) {
+  struct symbols symbols;
+  symbols.count = (int)(load * SYMBOL_CAPACITY);
+
+  // The missing names start with 'z', which no counter in hex does.
+  uint64_t state = 1;
+  char *storage = allocate((size_t)symbols.count * length * 2 + 1);
+  symbols.names = names(symbols.count, length, &state, storage);
+  symbols.missing = names(symbols.count, length, &state,
+                          storage + (size_t)symbols.count * length);
+  for (int i = 0; i < symbols.count; i++)
+    ((char *)symbols.missing[i].start)[0] = 'z';
+
+  symbols.table = symbol_table_new(SYMBOL_CAPACITY);
+  for (int i = 0; i < symbols.count; i++)
+    symbol_table_add(symbols.table, &symbols.names[i], &symbols.decl);
+
+  struct benchmark benchmark = {add, &symbols, symbols.count};
+  char name[64];
+  snprintf(name, sizeof(name), "symbols add load=%g len=%d", load, length);
+  measure(name, &benchmark);
+
+  benchmark.run = get;
+  snprintf(name, sizeof(name), "symbols get load=%g len=%d", load, length);
+  measure(name, &benchmark);
+
+  benchmark.run = miss;
+  snprintf(name, sizeof(name), "symbols miss load=%g len=%d", load, length);
+  measure(name, &benchmark);
+
+  symbol_table_free(&symbols.table);
+  free(symbols.names);
+  free(symbols.missing);
+  free(storage);
+}
+
+// Stays on one CPU, so that neither migrations nor another core's caches
+// and frequency show up in the timings.
+static void pin(void) {
+  int cpu = sched_getcpu();
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  if (cpu < 0 || sched_setaffinity(0, sizeof(set), &set) != 0) {
+    fprintf(stderr, "micro: could not pin to a CPU, timings may vary\n");
+    return;
+  }
+  printf("pinned to CPU %d\n", cpu);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <corpus>\n", argv[0]);
+    return 1;
+  }
+
+  pin();
+
+  struct corpus corpus = {.src = read_file(argv[1])};
+  scanner_t *scanner = scanner_new(corpus.src);
+  parser_t *parser = parser_new(scanner);
+  corpus.table = symbol_table_new(100);
+
+  if (!parser_run(parser, &corpus.root) ||
+      !resolver_generate_table(corpus.root, corpus.table)) {
+    fprintf(stderr, "micro: '%s' does not compile\n", argv[1]);
+    return 1;
+  }
+  corpus.nodes = ast_count(corpus.root);
+
+  scanner_t *counter = scanner_new(corpus.src);
+  corpus.tokens = 1;
+  while (scanner_read_token(counter).type != TOKEN_EOF)
+    corpus.tokens++;
+  scanner_free(&counter);
+
+  printf("%-32s %10s %10s %10s\n", "benchmark", "ops", "ns/op", "min");
+
+  struct benchmark benchmark = {scan, &corpus, corpus.tokens};
+  measure("scanner", &benchmark);
+
+  static const double loads[] = {0.5, 1, 4, 16};
+  static const int lengths[] = {4, 16, 64};
+  for (size_t i = 0; i < sizeof(loads) / sizeof(loads[0]); i++) {
+    for (size_t j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++)
+      bench_symbols(loads[i], lengths[j]);
+  }
+
+  benchmark = (struct benchmark){resolve, &corpus, corpus.nodes};
+  measure("resolve", &benchmark);
+
+  benchmark = (struct benchmark){check, &corpus, corpus.nodes};
+  measure("typecheck", &benchmark);
+
+  ast_free(&corpus.root);
+  parser_free(&parser);
+  scanner_free(&scanner);
+  symbol_table_free(&corpus.table);
+  free((char *)corpus.src);
+  return 0;
+}
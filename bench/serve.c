@@ -0,0 +1,284 @@
+// Compares the latency of compiling through a server, bin --serve, with
+// that of cold single-shot runs, on each program, compiled with -c:
+//
+//   cold      a fresh bin process per compile, as make bench times it
+//   client    a fresh bin --connect process per compile, which still starts
+//             a process but finds the compiler running and warm
+//   request   a request on a connection this process keeps open, what a
+//             build system linked against libcompiler.a pays
+//
+// The three are timed in turn on every run, so that drift in the machine
+// affects them alike. Reports the median and 95th percentile wall time of
+// each, in milliseconds, and how many times faster than cold the other two
+// are at the median.
+//
+//   serve [--bin <path>] [--runs <n>] [--warmup <n>] [--socket <path>]
+//         <file>...
+//
+//   make serve-bench
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../compiler/compiler.h"
+#include "../compiler/diagnostics.h"
+#include "../compiler/server.h"
+
+enum mode { MODE_COLD, MODE_CLIENT, MODE_REQUEST, NUM_MODES };
+
+static const char *mode_names[NUM_MODES] = {"cold", "client", "request"};
+
+struct options {
+  const char *bin;
+  int runs;
+  int warmup;
+  const char *socket;
+};
+
+static char *read_file(const char *path, size_t *size) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "serve: cannot open '%s'\n", path);
+    exit(1);
+  }
+
+  fseek(file, 0L, SEEK_END);
+  *size = ftell(file);
+  rewind(file);
+
+  char *data = malloc(*size + 1);
+  if (data == NULL || fread(data, 1, *size, file) != *size) {
+    fprintf(stderr, "serve: cannot read '%s'\n", path);
+    exit(1);
+  }
+
+  fclose(file);
+  data[*size] = '\0';
+  return data;
+}
+
+static long long now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Starts bin with the arguments and its output discarded.
+static pid_t start(const char *const *argv) {
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("serve: fork");
+    exit(1);
+  }
+
+  if (pid == 0) {
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    dup2(null, STDERR_FILENO);
+    execv(argv[0], (char *const *)argv);
+    _exit(127);
+  }
+  return pid;
+}
+
+// One compile in a process of its own, in nanoseconds, or -1 if it failed.
+static long long run(const char *const *argv) {
+  long long begin = now();
+  pid_t pid = start(argv);
+
+  int status;
+  if (waitpid(pid, &status, 0) < 0) {
+    perror("serve: waitpid");
+    exit(1);
+  }
+  long long time = now() - begin;
+
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? time : -1;
+}
+
+// One compile on the connection, in nanoseconds, or -1 if it failed.
+static long long request(int connection, const char *src, size_t size) {
+  struct compiler_options options = {
+      .output = COMPILER_OUTPUT_OBJECT,
+      .opt_level = 1,
+  };
+  struct server_reply reply;
+
+  long long begin = now();
+  if (!server_compile(connection, src, size, &options, &reply))
+    return -1;
+  long long time = now() - begin;
+
+  bool ok = reply.ok;
+  server_reply_free(&reply);
+  return ok ? time : -1;
+}
+
+// Starts the server and waits until it accepts connections.
+static pid_t start_server(struct options *options) {
+  char serve[256];
+  snprintf(serve, sizeof(serve), "--serve=%s", options->socket);
+  const char *argv[] = {options->bin, serve, NULL};
+  pid_t pid = start(argv);
+
+  // server_connect reports every failed attempt.
+  FILE *quiet = fopen("/dev/null", "w");
+  diagnostics_redirect(quiet, stderr);
+
+  int connection = -1;
+  for (int i = 0; i < 500 && connection < 0; i++) {
+    connection = server_connect(options->socket);
+    if (connection < 0)
+      usleep(10000);
+  }
+
+  diagnostics_redirect(NULL, NULL);
+  if (quiet)
+    fclose(quiet);
+  if (connection >= 0) {
+    close(connection);
+    return pid;
+  }
+
+  fprintf(stderr, "serve: '%s --serve' did not start\n", options->bin);
+  kill(pid, SIGTERM);
+  exit(1);
+}
+
+static int compare(const void *a, const void *b) {
+  long long x = *(const long long *)a;
+  long long y = *(const long long *)b;
+  return (x > y) - (x < y);
+}
+
+static long long median(long long *times, int n) {
+  return n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+}
+
+static bool bench(struct options *options, const char *path) {
+  const char *base = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+  char name[64];
+  snprintf(name, sizeof(name), "%.*s", (int)strcspn(base, "."), base);
+
+  size_t size;
+  char *src = read_file(path, &size);
+
+  char connect[256];
+  snprintf(connect, sizeof(connect), "--connect=%s", options->socket);
+  const char *cold[] = {options->bin, path, "-c", "-o", "/dev/null", NULL};
+  const char *client[] = {options->bin, path,      "-c", "-o",
+                          "/dev/null",  connect, NULL};
+
+  int connection = server_connect(options->socket);
+  long long *times = malloc(NUM_MODES * options->runs * sizeof(*times));
+  if (connection < 0 || times == NULL) {
+    fprintf(stderr, "serve: cannot benchmark '%s'\n", path);
+    exit(1);
+  }
+
+  for (int i = 0; i < options->warmup + options->runs; i++) {
+    long long time[NUM_MODES] = {
+        [MODE_COLD] = run(cold),
+        [MODE_CLIENT] = run(client),
+        [MODE_REQUEST] = request(connection, src, size),
+    };
+
+    for (int mode = 0; mode < NUM_MODES; mode++) {
+      if (time[mode] < 0) {
+        fprintf(stderr, "serve: %s compile of '%s' failed\n",
+                mode_names[mode], path);
+        free(times);
+        free(src);
+        close(connection);
+        return false;
+      }
+      if (i >= options->warmup)
+        times[mode * options->runs + i - options->warmup] = time[mode];
+    }
+  }
+
+  int n = options->runs;
+  long long medians[NUM_MODES];
+  printf("%-12s", name);
+  for (int mode = 0; mode < NUM_MODES; mode++) {
+    long long *mode_times = times + mode * n;
+    qsort(mode_times, n, sizeof(*mode_times), compare);
+    medians[mode] = median(mode_times, n);
+    // Nearest rank.
+    printf(" %10.3f %10.3f", medians[mode] / 1e6,
+           mode_times[(95 * n + 99) / 100 - 1] / 1e6);
+  }
+  printf(" %8.1fx %8.1fx\n",
+         (double)medians[MODE_COLD] / medians[MODE_CLIENT],
+         (double)medians[MODE_COLD] / medians[MODE_REQUEST]);
+
+  free(times);
+  free(src);
+  close(connection);
+  return true;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [--bin <path>] [--runs <n>] [--warmup <n>] "
+          "[--socket <path>] <file>...\n",
+          name);
+}
+
+int main(int argc, char *argv[]) {
+  struct options options = {
+      .bin = "./bin",
+      .runs = 50,
+      .warmup = 3,
+      .socket = "build/bench/serve.sock",
+  };
+
+  int first = 1;
+  for (; first + 1 < argc && strncmp(argv[first], "--", 2) == 0; first += 2) {
+    const char *option = argv[first];
+    const char *value = argv[first + 1];
+
+    if (strcmp(option, "--bin") == 0) {
+      options.bin = value;
+    } else if (strcmp(option, "--runs") == 0 && atoi(value) > 0) {
+      options.runs = atoi(value);
+    } else if (strcmp(option, "--warmup") == 0 && atoi(value) >= 0) {
+      options.warmup = atoi(value);
+    } else if (strcmp(option, "--socket") == 0) {
+      options.socket = value;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (first == argc) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  pid_t server = start_server(&options);
+
+  printf("%-12s", "workload");
+  for (int mode = 0; mode < NUM_MODES; mode++)
+    printf(" %7s ms %10s", mode_names[mode], "p95");
+  printf(" %9s %9s\n", "client", "request");
+
+  int status = 0;
+  for (int i = first; i < argc; i++) {
+    if (!bench(&options, argv[i]))
+      status = 1;
+  }
+
+  kill(server, SIGTERM);
+  if (waitpid(server, NULL, 0) < 0 && errno != ECHILD)
+    perror("serve: waitpid");
+  return status;
+}
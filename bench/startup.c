@@ -0,0 +1,194 @@
+// Compares how long the executables bin writes take to start, run and
+// exit, the program being the same, when they are
+//
+//   libc          linked against the C library with cc, the default
+//   freestanding  static and without the C library, --freestanding
+//
+// Each is spawned with posix_spawn and waited for, its output discarded,
+// the two in turn on every run so that drift in the machine affects them
+// alike. Reports the median and 95th percentile wall time of each, in
+// microseconds, and how many times faster the freestanding executable is at
+// the median. Give it a program that prints little, or the time is spent
+// running it rather than starting it.
+//
+//   startup [--bin <path>] [--runs <n>] [--warmup <n>] [--dir <path>]
+//           <file>...
+//
+//   make startup-bench
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+
+extern char **environ;
+
+enum mode { MODE_LIBC, MODE_FREESTANDING, NUM_MODES };
+
+static const char *mode_names[NUM_MODES] = {"libc", "freestanding"};
+
+struct options {
+  const char *bin;
+  int runs;
+  int warmup;
+  const char *dir;
+};
+
+static long long now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Runs argv to completion with its output discarded, returning whether it
+// exited with status 0.
+static bool spawn(const char *const *argv) {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+
+  pid_t pid;
+  int status;
+  bool ok = posix_spawn(&pid, argv[0], &actions, NULL, (char *const *)argv,
+                        environ) == 0 &&
+            waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+            WEXITSTATUS(status) == 0;
+
+  posix_spawn_file_actions_destroy(&actions);
+  return ok;
+}
+
+// One run of the executable, in nanoseconds, or -1 if it failed.
+static long long run(const char *path) {
+  const char *argv[] = {path, NULL};
+  long long begin = now();
+  return spawn(argv) ? now() - begin : -1;
+}
+
+static int compare(const void *a, const void *b) {
+  long long x = *(const long long *)a;
+  long long y = *(const long long *)b;
+  return (x > y) - (x < y);
+}
+
+static long long median(long long *times, int n) {
+  return n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+}
+
+static bool bench(struct options *options, const char *path) {
+  const char *base = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+  char name[64];
+  snprintf(name, sizeof(name), "%.*s", (int)strcspn(base, "."), base);
+
+  char executables[NUM_MODES][512];
+  for (int mode = 0; mode < NUM_MODES; mode++) {
+    snprintf(executables[mode], sizeof(executables[mode]), "%s/%s-%s",
+             options->dir, name, mode_names[mode]);
+  }
+
+  const char *libc[] = {options->bin, path, "-o", executables[MODE_LIBC],
+                        NULL};
+  const char *freestanding[] = {options->bin,
+                                path,
+                                "--freestanding",
+                                "-o",
+                                executables[MODE_FREESTANDING],
+                                NULL};
+  if (!spawn(libc) || !spawn(freestanding)) {
+    fprintf(stderr, "startup: cannot compile '%s'\n", path);
+    return false;
+  }
+
+  long long *times = malloc(NUM_MODES * options->runs * sizeof(*times));
+  if (times == NULL) {
+    fprintf(stderr, "startup: cannot benchmark '%s'\n", path);
+    exit(1);
+  }
+
+  for (int i = 0; i < options->warmup + options->runs; i++) {
+    for (int mode = 0; mode < NUM_MODES; mode++) {
+      long long time = run(executables[mode]);
+      if (time < 0) {
+        fprintf(stderr, "startup: %s executable of '%s' failed\n",
+                mode_names[mode], path);
+        free(times);
+        return false;
+      }
+      if (i >= options->warmup)
+        times[mode * options->runs + i - options->warmup] = time;
+    }
+  }
+
+  int n = options->runs;
+  long long medians[NUM_MODES];
+  printf("%-12s", name);
+  for (int mode = 0; mode < NUM_MODES; mode++) {
+    long long *mode_times = times + mode * n;
+    qsort(mode_times, n, sizeof(*mode_times), compare);
+    medians[mode] = median(mode_times, n);
+    // Nearest rank.
+    printf(" %12.1f %10.1f", medians[mode] / 1e3,
+           mode_times[(95 * n + 99) / 100 - 1] / 1e3);
+  }
+  printf(" %8.1fx\n",
+         (double)medians[MODE_LIBC] / medians[MODE_FREESTANDING]);
+
+  free(times);
+  return true;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [--bin <path>] [--runs <n>] [--warmup <n>] "
+          "[--dir <path>] <file>...\n",
+          name);
+}
+
+int main(int argc, char *argv[]) {
+  struct options options = {
+      .bin = "./bin",
+      .runs = 1000,
+      .warmup = 20,
+      .dir = "build/bench",
+  };
+
+  int first = 1;
+  for (; first + 1 < argc && strncmp(argv[first], "--", 2) == 0; first += 2) {
+    const char *option = argv[first];
+    const char *value = argv[first + 1];
+
+    if (strcmp(option, "--bin") == 0) {
+      options.bin = value;
+    } else if (strcmp(option, "--runs") == 0 && atoi(value) > 0) {
+      options.runs = atoi(value);
+    } else if (strcmp(option, "--warmup") == 0 && atoi(value) >= 0) {
+      options.warmup = atoi(value);
+    } else if (strcmp(option, "--dir") == 0) {
+      options.dir = value;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (first == argc) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  printf("%-12s", "program");
+  for (int mode = 0; mode < NUM_MODES; mode++)
+    printf(" %12s us %7s", mode_names[mode], "p95");
+  printf(" %9s\n", "speedup");
+
+  int status = 0;
+  for (int i = first; i < argc; i++) {
+    if (!bench(&options, argv[i]))
+      status = 1;
+  }
+  return status;
+}
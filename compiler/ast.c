@@ -1,9 +1,11 @@
 #include "ast.h"
 #include "common.h"
+#include "memory.h"
 #include "scanner.h"
 
 struct ast_node *ast_new(enum ast_node_type type) {
-  struct ast_node *node = (struct ast_node *)malloc(sizeof(*node));
+  struct ast_node *node =
+      (struct ast_node *)memory_alloc(MEMORY_AST, sizeof(*node));
   if (node == NULL) {
     ERROR_OUT();
   }
@@ -14,13 +16,18 @@ struct ast_node *ast_new(enum ast_node_type type) {
 }
 
 void ast_free(struct ast_node **root) {
-  assert(root && *root);
+  assert(root);
+
+  // Where the parser gave up on an expression.
+  if (*root == NULL)
+    return;
 
   switch ((*root)->type) {
   case AST_PROGRAM:
     for (int i = 0; i < (*root)->as.program.num_statements; i++) {
       ast_free(&(*root)->as.program.statements[i]);
     }
+    memory_free((*root)->as.program.statements);
     break;
 
   case AST_VARIABLE_DECL:
@@ -59,23 +66,16 @@ void ast_free(struct ast_node **root) {
     UNREACHABLE();
   }
 
-  free(*root);
+  memory_free(*root);
   *root = NULL;
 }
 
 struct ast_node *ast_new_program(struct ast_node **statements,
                                  int num_statements) {
-  if (num_statements > MAX_STATEMENTS) {
-    ERROR_OUT();
-  }
-
   struct ast_node *node = ast_new(AST_PROGRAM);
+  node->as.program.statements = statements;
   node->as.program.num_statements = num_statements;
 
-  for (int i = 0; i < num_statements; i++) {
-    node->as.program.statements[i] = statements[i];
-  }
-
   return node;
 }
 
@@ -88,6 +88,7 @@ struct ast_node *ast_new_variable_decl(struct scanner_token name,
   node->as.variable_decl.type = type;
   node->as.variable_decl.is_constant = is_constant;
   node->as.variable_decl.initialiser = initialiser;
+  node->as.variable_decl.temp = -1;
   return node;
 }
 
@@ -118,6 +119,7 @@ struct ast_node *ast_new_binary_expr(struct scanner_token token,
   node->as.binary_expr.token = token;
   node->as.binary_expr.left = left;
   node->as.binary_expr.right = right;
+  node->as.binary_expr.right_first = false;
   return node;
 }
 
@@ -149,6 +151,67 @@ struct ast_node *ast_new_bool_expr(bool literal) {
   return node;
 }
 
+int ast_count(struct ast_node *root) {
+  if (root == NULL)
+    return 0;
+
+  switch (root->type) {
+  case AST_PROGRAM: {
+    int count = 1;
+    for (int i = 0; i < root->as.program.num_statements; i++) {
+      count += ast_count(root->as.program.statements[i]);
+    }
+    return count;
+  }
+
+  case AST_VARIABLE_DECL:
+    return 1 + ast_count(root->as.variable_decl.initialiser);
+
+  case AST_PRINT_STMT:
+    return 1 + ast_count(root->as.print_stmt.expr);
+
+  case AST_ASSIGNMENT_STMT:
+    return 1 + ast_count(root->as.assignment_stmt.identifier) +
+           ast_count(root->as.assignment_stmt.expr);
+
+  case AST_BINARY_EXPR:
+    return 1 + ast_count(root->as.binary_expr.left) +
+           ast_count(root->as.binary_expr.right);
+
+  case AST_UNARY_EXPR:
+    return 1 + ast_count(root->as.unary_expr.right);
+
+  case AST_GROUPING_EXPR:
+    return 1 + ast_count(root->as.grouping_expr.expr);
+
+  case AST_LITERAL_EXPR:
+  case AST_IDENTIFIER_EXPR:
+    return 1;
+
+  default:
+    UNREACHABLE();
+    return 0;
+  }
+}
+
+bool ast_assigns(struct ast_node *node) {
+  assert(node);
+
+  switch (node->type) {
+  case AST_ASSIGNMENT_STMT:
+    return true;
+  case AST_BINARY_EXPR:
+    return ast_assigns(node->as.binary_expr.left) ||
+           ast_assigns(node->as.binary_expr.right);
+  case AST_UNARY_EXPR:
+    return ast_assigns(node->as.unary_expr.right);
+  case AST_GROUPING_EXPR:
+    return ast_assigns(node->as.grouping_expr.expr);
+  default:
+    return false;
+  }
+}
+
 // TODO: duplication with resolver
 static const char *ast_data_type_to_string(enum ast_data_type type) {
   switch (type) {
@@ -4,8 +4,6 @@
 #include "common.h"
 #include "scanner.h"
 
-#define MAX_STATEMENTS 100
-
 enum ast_node_type {
   AST_PROGRAM,
   AST_VARIABLE_DECL,
@@ -21,7 +19,7 @@ enum ast_node_type {
 enum ast_data_type { TYPE_I32, TYPE_BOOL, TYPE_ERROR };
 
 struct ast_program {
-  struct ast_node *statements[MAX_STATEMENTS];
+  struct ast_node **statements;
   int num_statements;
 };
 
@@ -31,6 +29,9 @@ struct ast_variable_decl {
   bool is_constant;
 
   struct ast_node *initialiser;
+
+  // IR temporary holding the variable, assigned during lowering.
+  int temp;
 };
 
 struct ast_expr_stmt {
@@ -55,6 +56,9 @@ struct ast_binary_expr {
 
   struct ast_node *left;
   struct ast_node *right;
+
+  // Lower the right operand before the left, set by order().
+  bool right_first;
 };
 
 struct ast_unary_expr {
@@ -93,6 +97,7 @@ struct ast_node {
 struct ast_node *ast_new(enum ast_node_type type);
 void ast_free(struct ast_node **root);
 
+// Takes the array of statements, allocated with memory_alloc(MEMORY_AST).
 struct ast_node *ast_new_program(struct ast_node **statements,
                                  int num_statements);
 struct ast_node *ast_new_variable_decl(struct scanner_token name,
@@ -112,6 +117,10 @@ struct ast_node *ast_new_identifier_expr(struct scanner_token name);
 struct ast_node *ast_new_number_expr(int literal);
 struct ast_node *ast_new_bool_expr(bool literal);
 
+int ast_count(struct ast_node *root);
+
+// Whether evaluating the expression assigns to a variable.
+bool ast_assigns(struct ast_node *node);
 void ast_print(struct ast_node *root, int ident);
 int ast_write_mermaid(struct ast_node *root, const char *path);
 
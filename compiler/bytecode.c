@@ -0,0 +1,231 @@
+#include "bytecode.h"
+#include "common.h"
+#include "diagnostics.h"
+#include "ir.h"
+#include "memory.h"
+
+// An instruction before it is written, so the next one can be fused into it.
+struct pending {
+  enum bytecode_op op;
+  int operands[3];
+  int num_operands;
+};
+
+static const struct {
+  const char *name;
+  int num_operands;
+} ops[NUM_BYTECODE_OPS] = {
+    [BC_HALT] = {"halt", 0},
+    [BC_MOVE_I32] = {"move.i32", 2},
+    [BC_MOVE_BOOL] = {"move.bool", 2},
+    [BC_ADD_I32] = {"add.i32", 3},
+    [BC_SUB_I32] = {"sub.i32", 3},
+    [BC_MUL_I32] = {"mul.i32", 3},
+    [BC_DIV_I32] = {"div.i32", 3},
+    [BC_NEG_I32] = {"neg.i32", 2},
+    [BC_PRINT_I32] = {"print.i32", 1},
+    [BC_PRINT_BOOL] = {"print.bool", 1},
+    [BC_MOVE_ADD_I32] = {"move+add.i32", 5},
+    [BC_MOVE_SUB_I32] = {"move+sub.i32", 5},
+    [BC_MOVE_MUL_I32] = {"move+mul.i32", 5},
+    [BC_MOVE_DIV_I32] = {"move+div.i32", 5},
+    [BC_ADD_MOVE_I32] = {"add+move.i32", 5},
+    [BC_SUB_MOVE_I32] = {"sub+move.i32", 5},
+    [BC_MUL_MOVE_I32] = {"mul+move.i32", 5},
+    [BC_DIV_MOVE_I32] = {"div+move.i32", 5},
+    [BC_MOVE_MOVE_I32] = {"move+move.i32", 4},
+};
+
+int bytecode_length(enum bytecode_op op) {
+  assert(op < NUM_BYTECODE_OPS);
+  return 1 + ops[op].num_operands;
+}
+
+static void emit(struct bytecode *code, int unit) {
+  if (code->size == code->capacity) {
+    code->capacity = code->capacity ? code->capacity * 2 : 256;
+    code->code = memory_realloc(MEMORY_BYTECODE, code->code,
+                                code->capacity * sizeof(*code->code));
+    if (code->code == NULL)
+      ERROR_OUT();
+  }
+
+  code->code[code->size++] = (uint16_t)unit;
+}
+
+static int constant(struct bytecode *code, int value) {
+  for (int i = 0; i < code->num_constants; i++) {
+    if (code->constants[i] == value)
+      return code->first_constant + i;
+  }
+
+  if (code->num_constants == code->constants_capacity) {
+    code->constants_capacity =
+        code->constants_capacity ? code->constants_capacity * 2 : 16;
+    code->constants =
+        memory_realloc(MEMORY_BYTECODE, code->constants,
+                       code->constants_capacity * sizeof(*code->constants));
+    if (code->constants == NULL)
+      ERROR_OUT();
+  }
+
+  code->constants[code->num_constants] = value;
+  return code->first_constant + code->num_constants++;
+}
+
+static int operand(struct bytecode *code, struct ir_operand operand) {
+  assert(operand.type != IR_OPERAND_NONE);
+
+  if (operand.type == IR_OPERAND_IMM)
+    return constant(code, operand.value);
+  return operand.value;
+}
+
+static struct pending lower(struct bytecode *code, struct ir_instr *instr) {
+  struct pending pending = {0};
+
+  switch (instr->op) {
+  case IR_COPY:
+    pending.op = instr->type == TYPE_BOOL ? BC_MOVE_BOOL : BC_MOVE_I32;
+    break;
+  case IR_ADD:
+    pending.op = BC_ADD_I32;
+    break;
+  case IR_SUB:
+    pending.op = BC_SUB_I32;
+    break;
+  case IR_MUL:
+    pending.op = BC_MUL_I32;
+    break;
+  case IR_DIV:
+    pending.op = BC_DIV_I32;
+    break;
+  case IR_NEG:
+    pending.op = BC_NEG_I32;
+    break;
+  case IR_PRINT:
+    pending.op = instr->type == TYPE_BOOL ? BC_PRINT_BOOL : BC_PRINT_I32;
+    break;
+  default:
+    UNREACHABLE();
+  }
+
+  if (instr->dst.type != IR_OPERAND_NONE)
+    pending.operands[pending.num_operands++] = operand(code, instr->dst);
+  pending.operands[pending.num_operands++] = operand(code, instr->a);
+  if (instr->b.type != IR_OPERAND_NONE)
+    pending.operands[pending.num_operands++] = operand(code, instr->b);
+
+  assert(pending.num_operands == ops[pending.op].num_operands);
+  return pending;
+}
+
+static bool is_arithmetic(enum bytecode_op op) {
+  return BC_ADD_I32 <= op && op <= BC_DIV_I32;
+}
+
+// The superinstruction doing `first` then `second`, or BC_HALT if none.
+static enum bytecode_op fuse(enum bytecode_op first, enum bytecode_op second) {
+  if (first == BC_MOVE_I32 && is_arithmetic(second))
+    return BC_MOVE_ADD_I32 + (second - BC_ADD_I32);
+  if (is_arithmetic(first) && second == BC_MOVE_I32)
+    return BC_ADD_MOVE_I32 + (first - BC_ADD_I32);
+  if (first == BC_MOVE_I32 && second == BC_MOVE_I32)
+    return BC_MOVE_MOVE_I32;
+  return BC_HALT;
+}
+
+static void write_instr(struct bytecode *code, struct pending *first,
+                        struct pending *second) {
+  emit(code, second ? fuse(first->op, second->op) : first->op);
+  for (int i = 0; i < first->num_operands; i++)
+    emit(code, first->operands[i]);
+
+  if (second) {
+    for (int i = 0; i < second->num_operands; i++)
+      emit(code, second->operands[i]);
+    code->num_superinstrs++;
+  }
+
+  code->num_instrs++;
+}
+
+struct bytecode *bytecode_new(struct ir_program *program) {
+  assert(program);
+
+  struct bytecode *code = memory_calloc(MEMORY_BYTECODE, 1, sizeof(*code));
+  if (code == NULL)
+    ERROR_OUT();
+
+  code->first_constant = program->num_temps;
+
+  // Greedily fuse each instruction with the next when a superinstruction
+  // covers the pair.
+  struct pending previous;
+  bool has_previous = false;
+
+  for (struct ir_instr *instr = program->head; instr; instr = instr->next) {
+    struct pending current = lower(code, instr);
+
+    if (!has_previous) {
+      previous = current;
+      has_previous = true;
+    } else if (fuse(previous.op, current.op) != BC_HALT) {
+      write_instr(code, &previous, &current);
+      has_previous = false;
+    } else {
+      write_instr(code, &previous, NULL);
+      previous = current;
+    }
+  }
+
+  if (has_previous)
+    write_instr(code, &previous, NULL);
+  emit(code, BC_HALT);
+
+  code->num_registers = code->first_constant + code->num_constants;
+  if (code->num_registers > BYTECODE_MAX_REGISTERS) {
+    fprintf(diagnostics_out(),
+            "[error] The program needs %d registers, more than the bytecode "
+            "can address.\n",
+            code->num_registers);
+    bytecode_free(&code);
+    return NULL;
+  }
+
+  return code;
+}
+
+void bytecode_free(struct bytecode **code) {
+  assert(code && *code);
+
+  memory_free((*code)->code);
+  memory_free((*code)->constants);
+  memory_free(*code);
+  *code = NULL;
+}
+
+static void print_register(struct bytecode *code, int reg, FILE *file) {
+  if (reg >= code->first_constant) {
+    fprintf(file, "%d", code->constants[reg - code->first_constant]);
+  } else {
+    fprintf(file, "r%d", reg);
+  }
+}
+
+void bytecode_print(struct bytecode *code, FILE *file) {
+  assert(code && file);
+
+  for (int pc = 0; pc < code->size;) {
+    enum bytecode_op op = code->code[pc];
+
+    fprintf(file, "%4d  %s", pc, ops[op].name);
+    for (int i = 1; i <= ops[op].num_operands; i++) {
+      fprintf(file, i == 1 ? " " : ", ");
+      print_register(code, code->code[pc + i], file);
+    }
+    fprintf(file, "\n");
+
+    pc += bytecode_length(op);
+  }
+}
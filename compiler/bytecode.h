@@ -0,0 +1,72 @@
+#ifndef bytecode_h
+#define bytecode_h
+
+#include <stdint.h>
+
+#include "common.h"
+#include "ir.h"
+
+// Register bytecode lowered from the IR and run by vm_run(). An instruction
+// is a 16-bit opcode followed by its 16-bit register operands. Registers
+// 0 to num_temps - 1 are the IR's temporaries; the IR's immediates are
+// constant registers after them, loaded from `constants` before the program
+// starts, so no instruction takes an immediate.
+
+#define BYTECODE_MAX_REGISTERS 65536
+
+enum bytecode_op {
+  BC_HALT,
+  BC_MOVE_I32,   // a <- b
+  BC_MOVE_BOOL,  // a <- b
+  BC_ADD_I32,    // a <- b + c
+  BC_SUB_I32,    // a <- b - c
+  BC_MUL_I32,    // a <- b * c
+  BC_DIV_I32,    // a <- b / c
+  BC_NEG_I32,    // a <- -b
+  BC_PRINT_I32,  // print a
+  BC_PRINT_BOOL, // print a
+
+  // Superinstructions for the most frequent pairs, operands of the first
+  // instruction followed by those of the second: a move into a temporary
+  // feeding arithmetic, arithmetic whose result is stored to a variable,
+  // and chained copies.
+  BC_MOVE_ADD_I32,
+  BC_MOVE_SUB_I32,
+  BC_MOVE_MUL_I32,
+  BC_MOVE_DIV_I32,
+  BC_ADD_MOVE_I32,
+  BC_SUB_MOVE_I32,
+  BC_MUL_MOVE_I32,
+  BC_DIV_MOVE_I32,
+  BC_MOVE_MOVE_I32,
+
+  NUM_BYTECODE_OPS
+};
+
+struct bytecode {
+  uint16_t *code;
+  int size;
+  int capacity;
+
+  int32_t *constants;
+  int num_constants;
+  int constants_capacity;
+
+  // Temporaries, then constants.
+  int num_registers;
+  int first_constant;
+
+  int num_instrs;
+  int num_superinstrs;
+};
+
+// Returns NULL if the program needs more than BYTECODE_MAX_REGISTERS.
+struct bytecode *bytecode_new(struct ir_program *program);
+void bytecode_free(struct bytecode **code);
+
+// Code units of an instruction, opcode included.
+int bytecode_length(enum bytecode_op op);
+
+void bytecode_print(struct bytecode *code, FILE *file);
+
+#endif
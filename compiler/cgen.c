@@ -0,0 +1,288 @@
+#include <stdint.h>
+
+#include "ast.h"
+#include "cgen.h"
+#include "common.h"
+#include "symbols.h"
+
+// Expressions without assignments are written inline: C leaves the order of
+// their operands unspecified, but without side effects other than a trap it
+// cannot be observed. An expression that assigns is split into statements
+// over numbered temporaries instead, left to right, so every read sees the
+// writes before it and none after.
+
+static const char prelude[] =
+    "#include <inttypes.h>\n"
+    "#include <stdbool.h>\n"
+    "#include <stdint.h>\n"
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "\n"
+    "static inline int32_t add_i32(int32_t a, int32_t b) {\n"
+    "  return (int32_t)((uint32_t)a + (uint32_t)b);\n"
+    "}\n"
+    "\n"
+    "static inline int32_t sub_i32(int32_t a, int32_t b) {\n"
+    "  return (int32_t)((uint32_t)a - (uint32_t)b);\n"
+    "}\n"
+    "\n"
+    "static inline int32_t mul_i32(int32_t a, int32_t b) {\n"
+    "  return (int32_t)((uint32_t)a * (uint32_t)b);\n"
+    "}\n"
+    "\n"
+    "static inline int32_t neg_i32(int32_t a) {\n"
+    "  return (int32_t)(0u - (uint32_t)a);\n"
+    "}\n"
+    "\n"
+    "static inline int32_t div_i32(int32_t a, int32_t b) {\n"
+    "  if (b == 0 || (a == INT32_MIN && b == -1)) {\n"
+    "    fflush(stdout);\n"
+    "    fputs(\"[error] The program trapped on a division.\\n\", stderr);\n"
+    "    exit(1);\n"
+    "  }\n"
+    "  return a / b;\n"
+    "}\n"
+    "\n"
+    "int main(void) {\n";
+
+struct cgen {
+  FILE *file;
+  symbol_table_t *table;
+  int num_temps;
+};
+
+static struct ast_node *lookup(struct cgen *cgen, struct ast_node *node) {
+  assert(node->type == AST_IDENTIFIER_EXPR);
+
+  struct ast_node *decl = symbol_table_get(cgen->table, &node->as.identifier);
+  assert(decl);
+
+  return decl;
+}
+
+static enum ast_data_type expr_type(struct cgen *cgen, struct ast_node *node) {
+  switch (node->type) {
+  case AST_LITERAL_EXPR:
+    return node->as.literal_expr.type;
+  case AST_IDENTIFIER_EXPR:
+    return lookup(cgen, node)->as.variable_decl.type;
+  case AST_ASSIGNMENT_STMT:
+    return expr_type(cgen, node->as.assignment_stmt.identifier);
+  case AST_GROUPING_EXPR:
+    return expr_type(cgen, node->as.grouping_expr.expr);
+  case AST_BINARY_EXPR:
+  case AST_UNARY_EXPR:
+    return TYPE_I32;
+  default:
+    UNREACHABLE();
+    return TYPE_ERROR;
+  }
+}
+
+static const char *c_type(enum ast_data_type type) {
+  return type == TYPE_BOOL ? "bool" : "int32_t";
+}
+
+static const char *helper(enum scanner_token_type op) {
+  switch (op) {
+  case TOKEN_PLUS:
+    return "add_i32";
+  case TOKEN_MINUS:
+    return "sub_i32";
+  case TOKEN_STAR:
+    return "mul_i32";
+  case TOKEN_SLASH:
+    return "div_i32";
+  default:
+    UNREACHABLE();
+    return NULL;
+  }
+}
+
+static void write_variable(struct cgen *cgen, struct scanner_token *name) {
+  fprintf(cgen->file, "v_%.*s", name->length, name->start);
+}
+
+static void write_literal(struct cgen *cgen, struct ast_literal_expr *literal) {
+  if (literal->type == TYPE_BOOL) {
+    fprintf(cgen->file, "%s", literal->as.boolean ? "true" : "false");
+  } else if (literal->as.i32 == INT32_MIN) {
+    fprintf(cgen->file, "INT32_MIN");
+  } else {
+    fprintf(cgen->file, "%d", literal->as.i32);
+  }
+}
+
+// An expression without assignments, inline.
+static void write_expr(struct cgen *cgen, struct ast_node *node) {
+  switch (node->type) {
+  case AST_LITERAL_EXPR:
+    write_literal(cgen, &node->as.literal_expr);
+    break;
+
+  case AST_IDENTIFIER_EXPR:
+    write_variable(cgen, &node->as.identifier);
+    break;
+
+  case AST_GROUPING_EXPR:
+    write_expr(cgen, node->as.grouping_expr.expr);
+    break;
+
+  case AST_UNARY_EXPR:
+    fprintf(cgen->file, "neg_i32(");
+    write_expr(cgen, node->as.unary_expr.right);
+    fprintf(cgen->file, ")");
+    break;
+
+  case AST_BINARY_EXPR:
+    fprintf(cgen->file, "%s(", helper(node->as.binary_expr.token.type));
+    write_expr(cgen, node->as.binary_expr.left);
+    fprintf(cgen->file, ", ");
+    write_expr(cgen, node->as.binary_expr.right);
+    fprintf(cgen->file, ")");
+    break;
+
+  default:
+    UNREACHABLE();
+  }
+}
+
+// Writes the statements computing an expression into a new temporary and
+// returns its number.
+static int write_temp(struct cgen *cgen, struct ast_node *node) {
+  if (!ast_assigns(node)) {
+    int temp = cgen->num_temps++;
+    fprintf(cgen->file, "  %s t%d = ", c_type(expr_type(cgen, node)), temp);
+    write_expr(cgen, node);
+    fprintf(cgen->file, ";\n");
+    return temp;
+  }
+
+  switch (node->type) {
+  case AST_GROUPING_EXPR:
+    return write_temp(cgen, node->as.grouping_expr.expr);
+
+  case AST_UNARY_EXPR: {
+    int right = write_temp(cgen, node->as.unary_expr.right);
+    int temp = cgen->num_temps++;
+    fprintf(cgen->file, "  int32_t t%d = neg_i32(t%d);\n", temp, right);
+    return temp;
+  }
+
+  case AST_BINARY_EXPR: {
+    int left = write_temp(cgen, node->as.binary_expr.left);
+    int right = write_temp(cgen, node->as.binary_expr.right);
+    int temp = cgen->num_temps++;
+    fprintf(cgen->file, "  int32_t t%d = %s(t%d, t%d);\n", temp,
+            helper(node->as.binary_expr.token.type), left, right);
+    return temp;
+  }
+
+  case AST_ASSIGNMENT_STMT: {
+    int value = write_temp(cgen, node->as.assignment_stmt.expr);
+    fprintf(cgen->file, "  ");
+    write_variable(cgen, &node->as.assignment_stmt.identifier->as.identifier);
+    fprintf(cgen->file, " = t%d;\n", value);
+    return value;
+  }
+
+  default:
+    UNREACHABLE();
+    return -1;
+  }
+}
+
+// Writes an expression as the operand of a statement, first splitting it
+// into temporaries if it assigns. Finish with write_value().
+static int prepare_value(struct cgen *cgen, struct ast_node *node) {
+  return ast_assigns(node) ? write_temp(cgen, node) : -1;
+}
+
+static void write_value(struct cgen *cgen, struct ast_node *node, int temp) {
+  if (temp >= 0) {
+    fprintf(cgen->file, "t%d", temp);
+  } else {
+    write_expr(cgen, node);
+  }
+}
+
+static void write_stmt(struct cgen *cgen, struct ast_node *node) {
+  switch (node->type) {
+  case AST_VARIABLE_DECL: {
+    struct ast_variable_decl *decl = &node->as.variable_decl;
+    int temp = prepare_value(cgen, decl->initialiser);
+
+    fprintf(cgen->file, "  %s%s ", decl->is_constant ? "const " : "",
+            c_type(decl->type));
+    write_variable(cgen, &decl->name);
+    fprintf(cgen->file, " = ");
+    write_value(cgen, decl->initialiser, temp);
+    fprintf(cgen->file, ";\n");
+    break;
+  }
+
+  case AST_PRINT_STMT: {
+    struct ast_node *expr = node->as.print_stmt.expr;
+    int temp = prepare_value(cgen, expr);
+
+    if (expr_type(cgen, expr) == TYPE_BOOL) {
+      fprintf(cgen->file, "  puts(");
+      write_value(cgen, expr, temp);
+      fprintf(cgen->file, " ? \"true\" : \"false\");\n");
+    } else {
+      fprintf(cgen->file, "  printf(\"%%\" PRId32 \"\\n\", ");
+      write_value(cgen, expr, temp);
+      fprintf(cgen->file, ");\n");
+    }
+    break;
+  }
+
+  case AST_ASSIGNMENT_STMT: {
+    struct ast_node *expr = node->as.assignment_stmt.expr;
+    int temp = prepare_value(cgen, expr);
+
+    fprintf(cgen->file, "  ");
+    write_variable(cgen, &node->as.assignment_stmt.identifier->as.identifier);
+    fprintf(cgen->file, " = ");
+    write_value(cgen, expr, temp);
+    fprintf(cgen->file, ";\n");
+    break;
+  }
+
+  default:
+    // Evaluated for a trapping division only.
+    if (ast_assigns(node)) {
+      fprintf(cgen->file, "  (void)t%d;\n", write_temp(cgen, node));
+    } else {
+      fprintf(cgen->file, "  (void)");
+      write_expr(cgen, node);
+      fprintf(cgen->file, ";\n");
+    }
+    break;
+  }
+}
+
+void cgen(struct ast_node *root, symbol_table_t *table, FILE *file) {
+  assert(root && root->type == AST_PROGRAM);
+  assert(table && file);
+
+  struct cgen cgen = {file, table, 0};
+
+  fputs(prelude, file);
+
+  struct ast_program *program = &root->as.program;
+  for (int i = 0; i < program->num_statements; i++)
+    write_stmt(&cgen, program->statements[i]);
+
+  // Variables the program never reads would otherwise draw warnings.
+  for (int i = 0; i < program->num_statements; i++) {
+    struct ast_node *node = program->statements[i];
+    if (node->type == AST_VARIABLE_DECL) {
+      fprintf(file, "  (void)");
+      write_variable(&cgen, &node->as.variable_decl.name);
+      fprintf(file, ";\n");
+    }
+  }
+
+  fprintf(file, "  return 0;\n}\n");
+}
@@ -0,0 +1,14 @@
+#ifndef cgen_h
+#define cgen_h
+
+#include "ast.h"
+#include "common.h"
+#include "symbols.h"
+
+// Translates a type-checked program into a C99 translation unit whose main
+// prints what the program prints. Arithmetic wraps through unsigned casts
+// and a trapping division exits with status 1, as under --run, so the result
+// can be compiled by any C99 compiler at any optimisation level.
+void cgen(struct ast_node *root, symbol_table_t *table, FILE *file);
+
+#endif
@@ -6,11 +6,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#define ERROR_OUT()                                                            \
-  do {                                                                         \
-    printf("Error at line %d in %s.\n", __LINE__, __FILE__);                   \
-    exit(EXIT_FAILURE);                                                        \
-  } while (0)
+// For failures the compiler cannot continue from, such as running out of
+// memory. Ends the process, unless the calling thread is in a memory region
+// that handles errors (memory.h).
+#define ERROR_OUT() error_out(__FILE__, __LINE__)
+
+_Noreturn void error_out(const char *file, int line);
 
 #define UNREACHABLE() assert(!"Unreachable")
 
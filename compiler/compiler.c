@@ -0,0 +1,192 @@
+#include <setjmp.h>
+#include <string.h>
+
+#include "ast.h"
+#include "bytecode.h"
+#include "cgen.h"
+#include "common.h"
+#include "compiler.h"
+#include "diagnostics.h"
+#include "ir.h"
+#include "isel.h"
+#include "memory.h"
+#include "object.h"
+#include "output.h"
+#include "parser.h"
+#include "passes.h"
+#include "resolver.h"
+#include "scanner.h"
+#include "symbols.h"
+#include "typechecker.h"
+#include "vm.h"
+#include "x86.h"
+
+struct compiler_context_t {
+  // What the compile in progress allocated.
+  struct memory_region region;
+
+  // Memory streams of the last compile, from the C library.
+  char *output;
+  size_t output_size;
+  char *diagnostics;
+  size_t diagnostics_size;
+
+  // What the program prints under COMPILER_OUTPUT_RUN, on its way to
+  // output.
+  struct output program_output;
+};
+
+compiler_context_t *compiler_context_new(void) {
+  // Outside whatever region the caller is in, as it outlives the compile.
+  struct memory_region *region = memory_enter(NULL);
+  compiler_context_t *context =
+      memory_calloc(MEMORY_CONTEXT, 1, sizeof(*context));
+  memory_enter(region);
+
+  if (context == NULL)
+    return NULL;
+
+  memory_region_init(&context->region);
+  return context;
+}
+
+void compiler_context_free(compiler_context_t **context) {
+  assert(context && *context);
+
+  free((*context)->output);
+  free((*context)->diagnostics);
+  memory_free(*context);
+  *context = NULL;
+}
+
+// The pipeline, in the context's region. Everything it allocates is
+// released with the region afterwards, so it frees nothing itself.
+static bool run(compiler_context_t *context, const char *src, size_t size,
+                const struct compiler_options *options, FILE *output) {
+  pass_manager_t *manager = pass_manager_new(options->opt_level);
+  for (int i = 0; i < options->num_passes; i++) {
+    const struct compiler_pass *pass = &options->passes[i];
+    if (!pass_manager_set_enabled(manager, pass->name, pass->enabled)) {
+      fprintf(diagnostics_out(), "[error] Unknown pass '%s'.\n", pass->name);
+      return false;
+    }
+  }
+
+  // The scanner stops at a NUL.
+  char *source = memory_alloc(MEMORY_SOURCE, size + 1);
+  if (source == NULL)
+    ERROR_OUT();
+  memcpy(source, src, size);
+  source[size] = '\0';
+
+  parser_t *parser = parser_new(scanner_new(source));
+  symbol_table_t *table = symbol_table_new(100);
+  if (table == NULL)
+    ERROR_OUT();
+  struct ast_node *root = NULL;
+
+  if (!parser_run(parser, &root) || !resolver_generate_table(root, table) ||
+      typecheck(root, table) == TYPE_ERROR)
+    return false;
+
+  pass_manager_run_ast(manager, root);
+
+  if (options->output == COMPILER_OUTPUT_C) {
+    cgen(root, table, output);
+    return true;
+  }
+
+  struct ir_program *program = ir_new(root, table);
+  pass_manager_run_ir(manager, program);
+
+  if (options->output == COMPILER_OUTPUT_RUN) {
+    struct bytecode *code = bytecode_new(program);
+    if (code == NULL)
+      return false;
+
+    output_init(&context->program_output, output);
+    bool ok = vm_run(code, &context->program_output);
+    output_flush(&context->program_output);
+
+    if (!ok)
+      fprintf(diagnostics_out(),
+              "[error] The program trapped on a division.\n");
+    return ok;
+  }
+
+  struct x86_program *machine = isel(program);
+  pass_manager_run_x86(manager, machine);
+  x86_frame(machine);
+
+  switch (options->output) {
+  case COMPILER_OUTPUT_OBJECT:
+    return object_emit(machine, output);
+  case COMPILER_OUTPUT_EXECUTABLE:
+    return object_emit_executable(machine, output);
+  case COMPILER_OUTPUT_ASSEMBLY:
+    x86_emit(machine, output);
+    return true;
+  default:
+    UNREACHABLE();
+    return false;
+  }
+}
+
+bool compiler_compile(compiler_context_t *context, const char *src,
+                      size_t size, const struct compiler_options *options) {
+  assert(context && src && options);
+
+  free(context->output);
+  free(context->diagnostics);
+  context->output = NULL;
+  context->output_size = 0;
+  context->diagnostics = NULL;
+  context->diagnostics_size = 0;
+
+  FILE *output = open_memstream(&context->output, &context->output_size);
+  FILE *diagnostics =
+      open_memstream(&context->diagnostics, &context->diagnostics_size);
+  if (output == NULL || diagnostics == NULL) {
+    if (output)
+      fclose(output);
+    if (diagnostics)
+      fclose(diagnostics);
+    return false;
+  }
+
+  diagnostics_redirect(diagnostics, diagnostics);
+  struct memory_region *previous = memory_enter(&context->region);
+  jmp_buf on_error;
+  context->region.on_error = &on_error;
+
+  bool ok = false;
+  if (setjmp(on_error) == 0) {
+    ok = run(context, src, size, options, output);
+  } else {
+    fprintf(diagnostics, "[error] Out of memory at line %d in %s.\n",
+            context->region.line, context->region.file);
+  }
+
+  context->region.on_error = NULL;
+  memory_region_release(&context->region);
+  memory_enter(previous);
+  diagnostics_redirect(NULL, NULL);
+
+  fclose(output);
+  fclose(diagnostics);
+  return ok;
+}
+
+const char *compiler_output(compiler_context_t *context, size_t *size) {
+  assert(context && size);
+
+  *size = context->output_size;
+  return context->output ? context->output : "";
+}
+
+const char *compiler_diagnostics(compiler_context_t *context, size_t *size) {
+  assert(context && size);
+
+  *size = context->diagnostics_size;
+  return context->diagnostics ? context->diagnostics : "";
+}
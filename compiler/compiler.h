@@ -0,0 +1,56 @@
+#ifndef compiler_h
+#define compiler_h
+
+#include "common.h"
+
+// The compiler as a library, libcompiler.a, for programs that compile many
+// sources in process. A context holds what a compile leaves behind, its
+// output and diagnostics, and owns the memory of the compile while it runs:
+// whatever the compile allocated is released when it returns, also when it
+// failed halfway. Nothing ends the process; running out of memory fails the
+// compile. Each thread can compile with a context of its own at the same
+// time.
+
+enum compiler_output {
+  COMPILER_OUTPUT_OBJECT,     // a relocatable ELF object, as -c
+  COMPILER_OUTPUT_EXECUTABLE, // a static executable, as --freestanding
+  COMPILER_OUTPUT_ASSEMBLY,   // as -S
+  COMPILER_OUTPUT_C,          // as --emit=c
+  COMPILER_OUTPUT_RUN,        // what the program prints, as --interpret
+};
+
+// A pass turned on or off over the pipeline of the -O level, as --enable
+// and --disable.
+struct compiler_pass {
+  const char *name;
+  bool enabled;
+};
+
+struct compiler_options {
+  enum compiler_output output;
+  int opt_level;
+
+  // Applied in order.
+  const struct compiler_pass *passes;
+  int num_passes;
+};
+
+typedef struct compiler_context_t compiler_context_t;
+
+// NULL if out of memory.
+compiler_context_t *compiler_context_new(void);
+void compiler_context_free(compiler_context_t **context);
+
+// Compiles size bytes of source. Returns false if the options or the
+// program have errors, the program trapped while it ran, or memory ran out;
+// the diagnostics say which.
+bool compiler_compile(compiler_context_t *context, const char *src,
+                      size_t size, const struct compiler_options *options);
+
+// Of the last compile, valid until the next one or until the context is
+// freed, and empty before the first. Both end in a NUL that size does not
+// count.
+const char *compiler_output(compiler_context_t *context, size_t *size);
+const char *compiler_diagnostics(compiler_context_t *context, size_t *size);
+
+#endif
@@ -0,0 +1,56 @@
+#include "common.h"
+#include "dce.h"
+#include "ir.h"
+#include "memory.h"
+
+// Backward liveness over the straight-line program: an instruction whose
+// destination is not read before being redefined or the program ends is
+// removed, unless it is a division that may still trap.
+
+static bool has_side_effect(struct ir_instr *instr) {
+  switch (instr->op) {
+  case IR_PRINT:
+    return true;
+  case IR_DIV:
+    return instr->b.type != IR_OPERAND_IMM || instr->b.value == 0 ||
+           instr->b.value == -1;
+  default:
+    return false;
+  }
+}
+
+static void use(struct ir_operand operand, bool *live) {
+  if (operand.type == IR_OPERAND_TEMP)
+    live[operand.value] = true;
+}
+
+void dce(struct ir_program *program) {
+  assert(program);
+
+  bool *live =
+      memory_calloc(MEMORY_PASSES, program->num_temps + 1, sizeof(*live));
+  if (live == NULL)
+    ERROR_OUT();
+
+  struct ir_instr *instr = program->tail;
+  while (instr) {
+    struct ir_instr *prev = instr->prev;
+
+    bool needed = has_side_effect(instr) ||
+                  (instr->dst.type == IR_OPERAND_TEMP && live[instr->dst.value]);
+
+    if (!needed) {
+      ir_remove(program, instr);
+    } else {
+      if (instr->dst.type == IR_OPERAND_TEMP)
+        live[instr->dst.value] = false;
+
+      use(instr->a, live);
+      use(instr->b, live);
+    }
+
+    instr = prev;
+  }
+
+  memory_free(live);
+}
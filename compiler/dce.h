@@ -0,0 +1,8 @@
+#ifndef dce_h
+#define dce_h
+
+#include "ir.h"
+
+void dce(struct ir_program *program);
+
+#endif
@@ -0,0 +1,13 @@
+#include "diagnostics.h"
+
+static _Thread_local FILE *out;
+static _Thread_local FILE *err;
+
+FILE *diagnostics_out(void) { return out ? out : stdout; }
+
+FILE *diagnostics_err(void) { return err ? err : stderr; }
+
+void diagnostics_redirect(FILE *new_out, FILE *new_err) {
+  out = new_out;
+  err = new_err;
+}
@@ -0,0 +1,17 @@
+#ifndef diagnostics_h
+#define diagnostics_h
+
+#include "common.h"
+
+// Where the compiler reports errors in the program and in writing its
+// output: stdout and stderr, unless the calling thread redirected them. A
+// batch compile gives each file streams of its own, so that the messages of
+// files compiled at the same time do not mix.
+
+FILE *diagnostics_out(void);
+FILE *diagnostics_err(void);
+
+// For the calling thread only. NULL restores stdout or stderr.
+void diagnostics_redirect(FILE *out, FILE *err);
+
+#endif
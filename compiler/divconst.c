@@ -0,0 +1,116 @@
+#include "divconst.h"
+#include "common.h"
+
+// Granlund & Montgomery, "Division by Invariant Integers using
+// Multiplication" (1994), in the formulation of Hacker's Delight 10-1. The
+// plan is always computed for |divisor| and the quotient negated afterwards,
+// which is exact because truncating division is symmetric about zero.
+static void magic(unsigned int ad, int *multiplier, int *shift) {
+  const unsigned int two31 = 0x80000000u;
+
+  unsigned int anc = two31 - 1 - two31 % ad;
+  unsigned int q1 = two31 / anc;
+  unsigned int r1 = two31 - q1 * anc;
+  unsigned int q2 = two31 / ad;
+  unsigned int r2 = two31 - q2 * ad;
+  unsigned int delta;
+  int p = 31;
+
+  do {
+    p++;
+
+    q1 *= 2;
+    r1 *= 2;
+    if (r1 >= anc) {
+      q1++;
+      r1 -= anc;
+    }
+
+    q2 *= 2;
+    r2 *= 2;
+    if (r2 >= ad) {
+      q2++;
+      r2 -= ad;
+    }
+
+    delta = ad - r2;
+  } while (q1 < delta || (q1 == delta && r1 == 0));
+
+  *multiplier = (int)(q2 + 1);
+  *shift = p - 32;
+}
+
+struct divconst_plan divconst_plan(int divisor) {
+  struct divconst_plan plan = {.strategy = DIVCONST_IDIV,
+                               .divisor = divisor,
+                               .multiplier = 0,
+                               .shift = 0,
+                               .negate = false};
+
+  if (divisor == 0 || divisor == -1) {
+    return plan;
+  }
+
+  if (divisor == 1) {
+    plan.strategy = DIVCONST_IDENTITY;
+    return plan;
+  }
+
+  unsigned int ad =
+      divisor < 0 ? 0u - (unsigned int)divisor : (unsigned int)divisor;
+  plan.negate = divisor < 0;
+
+  if ((ad & (ad - 1)) == 0) {
+    plan.strategy = DIVCONST_POW2;
+    plan.shift = __builtin_ctz(ad);
+    return plan;
+  }
+
+  plan.strategy = DIVCONST_MAGIC;
+  magic(ad, &plan.multiplier, &plan.shift);
+  return plan;
+}
+
+// Evaluates the exact instruction sequence the backend emits for the plan.
+// Shifts of negative values are arithmetic, matching sarl.
+int divconst_eval(const struct divconst_plan *plan, int dividend) {
+  assert(plan);
+
+  unsigned int n = (unsigned int)dividend;
+  int q;
+
+  switch (plan->strategy) {
+  case DIVCONST_IDIV:
+    assert(plan->divisor != 0);
+    return dividend / plan->divisor;
+
+  case DIVCONST_IDENTITY:
+    return dividend;
+
+  case DIVCONST_POW2: {
+    // sarl $k-1; shrl $32-k; addl n; sarl $k
+    int k = plan->shift;
+    unsigned int bias = (unsigned int)(dividend >> (k - 1)) >> (32 - k);
+    q = (int)(n + bias) >> k;
+    break;
+  }
+
+  case DIVCONST_MAGIC: {
+    // imull (high half); addl n if M < 0; sarl $s; add the sign bit
+    long long product = (long long)plan->multiplier * dividend;
+    unsigned int hi = (unsigned int)(product >> 32);
+    if (plan->multiplier < 0)
+      hi += n;
+
+    q = (int)hi >> plan->shift;
+    q = (int)((unsigned int)q + ((unsigned int)q >> 31));
+    break;
+  }
+
+  default:
+    UNREACHABLE();
+    return 0;
+  }
+
+  return plan->negate ? (int)(0u - (unsigned int)q) : q;
+}
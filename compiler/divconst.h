@@ -0,0 +1,30 @@
+#ifndef divconst_h
+#define divconst_h
+
+#include "common.h"
+
+// Strategies for lowering signed i32 division by a compile-time constant.
+// The sequences are described in docs/CODEGEN.md.
+enum divconst_strategy {
+  DIVCONST_IDIV,     // 0 and -1 keep idivl so they trap like the original.
+  DIVCONST_IDENTITY, // n / 1
+  DIVCONST_POW2,     // n / +-2^k via sar with a rounding fix-up
+  DIVCONST_MAGIC,    // multiply-high, shift and sign correction
+};
+
+struct divconst_plan {
+  enum divconst_strategy strategy;
+  int divisor;
+
+  // DIVCONST_MAGIC: signed multiplier and post-shift.
+  // DIVCONST_POW2: shift holds k where |divisor| == 2^k.
+  int multiplier;
+  int shift;
+
+  bool negate;
+};
+
+struct divconst_plan divconst_plan(int divisor);
+int divconst_eval(const struct divconst_plan *plan, int dividend);
+
+#endif
@@ -0,0 +1,461 @@
+#include <string.h>
+
+#include "encode.h"
+#include "common.h"
+#include "memory.h"
+#include "x86.h"
+
+// Machine code for the subset of x86-64 instruction selection produces, in
+// the forms GAS would pick: the 8-bit immediate and displacement variants
+// whenever the value fits, %rbp-relative stack slots and %rip-relative
+// symbols and constants. Each instruction is
+//
+//   [66] [REX] opcode [ModRM [SIB] [displacement]] [immediate]
+//
+// where the 66 prefix selects the 128-bit form of the vector instructions
+// and REX carries the 64-bit operand size (W) and the fourth bit of the
+// ModRM reg (R), SIB index (X) and ModRM r/m or SIB base (B) registers.
+
+#define REX_W 0x8
+#define REX_R 0x4
+#define REX_X 0x2
+#define REX_B 0x1
+
+// ModRM reg field extensions of the grouped opcodes.
+enum extension {
+  EXT_ADD = 0,
+  EXT_SUB = 5,
+  EXT_XOR = 6,
+  EXT_NEG = 3,
+  EXT_IMUL1 = 5,
+  EXT_IDIV = 7,
+  EXT_SHL = 4,
+  EXT_SHR = 5,
+  EXT_SAR = 7,
+};
+
+// A rip-relative reference to a constant, resolved once main is encoded and
+// the constants are laid out after it.
+struct constant_field {
+  int offset;
+  int constant;
+};
+
+struct encoder {
+  struct x86_program *program;
+  struct encode_output *output;
+
+  struct constant_field *fields;
+  int num_fields;
+  int fields_capacity;
+};
+
+static void byte(struct encoder *encoder, int value) {
+  struct encode_output *output = encoder->output;
+
+  if (output->text_size == output->text_capacity) {
+    output->text_capacity =
+        output->text_capacity ? output->text_capacity * 2 : 256;
+    output->text =
+        memory_realloc(MEMORY_ENCODE, output->text, output->text_capacity);
+    if (output->text == NULL)
+      ERROR_OUT();
+  }
+
+  output->text[output->text_size++] = (unsigned char)value;
+}
+
+static void dword(struct encoder *encoder, int value) {
+  unsigned bits = (unsigned)value;
+  for (int i = 0; i < 4; i++)
+    byte(encoder, (bits >> (8 * i)) & 0xff);
+}
+
+static void reloc(struct encoder *encoder, enum x86_symbol symbol) {
+  struct encode_output *output = encoder->output;
+
+  if (output->num_relocs == output->relocs_capacity) {
+    output->relocs_capacity =
+        output->relocs_capacity ? output->relocs_capacity * 2 : 16;
+    output->relocs =
+        memory_realloc(MEMORY_ENCODE, output->relocs,
+                       output->relocs_capacity * sizeof(*output->relocs));
+    if (output->relocs == NULL)
+      ERROR_OUT();
+  }
+
+  output->relocs[output->num_relocs++] =
+      (struct encode_reloc){output->text_size, symbol};
+  dword(encoder, 0);
+}
+
+static void constant_field(struct encoder *encoder, int constant) {
+  if (encoder->num_fields == encoder->fields_capacity) {
+    encoder->fields_capacity =
+        encoder->fields_capacity ? encoder->fields_capacity * 2 : 16;
+    encoder->fields =
+        memory_realloc(MEMORY_ENCODE, encoder->fields,
+                       encoder->fields_capacity * sizeof(*encoder->fields));
+    if (encoder->fields == NULL)
+      ERROR_OUT();
+  }
+
+  encoder->fields[encoder->num_fields++] =
+      (struct constant_field){encoder->output->text_size, constant};
+  dword(encoder, 0);
+}
+
+static bool fits_int8(int value) { return -128 <= value && value <= 127; }
+
+static int low(int reg) { return reg & 7; }
+static int high(int reg) { return (reg >> 3) & 1; }
+
+static int slot_offset(struct encoder *encoder, struct x86_operand operand) {
+  return -(encoder->program->slot_base + 4 * (operand.value + 1));
+}
+
+static void rex(struct encoder *encoder, int size, int reg, int index,
+                struct x86_operand rm) {
+  int bits = 0;
+  if (size == 8)
+    bits |= REX_W;
+  if (high(reg))
+    bits |= REX_R;
+  if (high(index))
+    bits |= REX_X;
+  if ((rm.type == X86_REG || rm.type == X86_XMM) && high(rm.value))
+    bits |= REX_B;
+
+  if (bits)
+    byte(encoder, 0x40 | bits);
+}
+
+// ModRM and whatever follows it for a register, stack slot or symbol r/m
+// operand.
+static void modrm(struct encoder *encoder, int reg, struct x86_operand rm) {
+  switch (rm.type) {
+  case X86_REG:
+  case X86_XMM:
+    byte(encoder, 0xc0 | low(reg) << 3 | low(rm.value));
+    break;
+
+  case X86_STACK: {
+    int offset = slot_offset(encoder, rm);
+    if (fits_int8(offset)) {
+      byte(encoder, 0x40 | low(reg) << 3 | REG_RBP);
+      byte(encoder, offset);
+    } else {
+      byte(encoder, 0x80 | low(reg) << 3 | REG_RBP);
+      dword(encoder, offset);
+    }
+    break;
+  }
+
+  case X86_SYMBOL:
+    byte(encoder, low(reg) << 3 | 0x5);
+    reloc(encoder, rm.value);
+    break;
+
+  case X86_CONSTANT:
+    byte(encoder, low(reg) << 3 | 0x5);
+    constant_field(encoder, rm.value);
+    break;
+
+  default:
+    UNREACHABLE();
+  }
+}
+
+static void op_rm(struct encoder *encoder, int size, int opcode, int reg,
+                  struct x86_operand rm) {
+  rex(encoder, size, reg, 0, rm);
+  if (opcode > 0xff)
+    byte(encoder, opcode >> 8);
+  byte(encoder, opcode & 0xff);
+  modrm(encoder, reg, rm);
+}
+
+// op r/m, reg when the destination is memory, op reg, r/m otherwise.
+static void alu(struct encoder *encoder, struct x86_instr *instr,
+                int to_rm, int to_reg, enum extension extension) {
+  if (instr->src.type == X86_IMM) {
+    int imm = instr->src.value;
+    if (fits_int8(imm)) {
+      op_rm(encoder, instr->size, 0x83, extension, instr->dst);
+      byte(encoder, imm);
+    } else if (instr->dst.type == X86_REG && instr->dst.value == REG_RAX) {
+      // Short form with %eax implied, one byte below the ModRM form.
+      rex(encoder, instr->size, 0, 0, instr->dst);
+      byte(encoder, to_rm + 4);
+      dword(encoder, imm);
+    } else {
+      op_rm(encoder, instr->size, 0x81, extension, instr->dst);
+      dword(encoder, imm);
+    }
+    return;
+  }
+
+  if (instr->src.type == X86_REG) {
+    op_rm(encoder, instr->size, to_rm, instr->src.value, instr->dst);
+  } else {
+    assert(instr->dst.type == X86_REG);
+    op_rm(encoder, instr->size, to_reg, instr->dst.value, instr->src);
+  }
+}
+
+// 66 [REX] 0f opcode ModRM: the 128-bit integer instructions, whose
+// opcode is one (0f xx) or two bytes (0f 38 xx, 0f 3a xx) after the escape.
+static void sse(struct encoder *encoder, int opcode, int reg,
+                struct x86_operand rm) {
+  byte(encoder, 0x66);
+  rex(encoder, 4, reg, 0, rm);
+  byte(encoder, 0x0f);
+  if (opcode > 0xff)
+    byte(encoder, opcode >> 8);
+  byte(encoder, opcode & 0xff);
+  modrm(encoder, reg, rm);
+}
+
+static void mov(struct encoder *encoder, struct x86_instr *instr) {
+  if (instr->src.type != X86_IMM) {
+    alu(encoder, instr, 0x89, 0x8b, 0);
+    return;
+  }
+
+  assert(instr->size == 4);
+  if (instr->dst.type == X86_REG) {
+    rex(encoder, 4, 0, 0, instr->dst);
+    byte(encoder, 0xb8 + low(instr->dst.value));
+  } else {
+    op_rm(encoder, 4, 0xc7, 0, instr->dst);
+  }
+  dword(encoder, instr->src.value);
+}
+
+static void lea(struct encoder *encoder, struct x86_instr *instr) {
+  assert(instr->dst.type == X86_REG);
+  int dst = instr->dst.value;
+
+  if (instr->src.type == X86_SYMBOL) {
+    op_rm(encoder, instr->size, 0x8d, dst, instr->src);
+    return;
+  }
+
+  assert(instr->src.type == X86_REG && instr->index.type == X86_REG);
+  int base = instr->src.value;
+  int index = instr->index.value;
+  assert(index != REG_RSP);
+
+  int scale = 0;
+  while ((1 << scale) < instr->imm)
+    scale++;
+  assert((1 << scale) == instr->imm);
+
+  rex(encoder, instr->size, dst, index, X86_REG(base));
+  byte(encoder, 0x8d);
+
+  // A base of %rbp or %r13 without a displacement would mean no base.
+  bool needs_disp = low(base) == REG_RBP;
+  byte(encoder, (needs_disp ? 0x40 : 0x00) | low(dst) << 3 | 0x4);
+  byte(encoder, scale << 6 | low(index) << 3 | low(base));
+  if (needs_disp)
+    byte(encoder, 0);
+}
+
+static void instr(struct encoder *encoder, struct x86_instr *instr) {
+  switch (instr->op) {
+  case X86_MOV:
+    mov(encoder, instr);
+    return;
+
+  case X86_ADD:
+    alu(encoder, instr, 0x01, 0x03, EXT_ADD);
+    return;
+
+  case X86_SUB:
+    alu(encoder, instr, 0x29, 0x2b, EXT_SUB);
+    return;
+
+  case X86_XOR:
+    alu(encoder, instr, 0x31, 0x33, EXT_XOR);
+    return;
+
+  case X86_TEST:
+    // test is symmetric; the register goes in the reg field.
+    if (instr->src.type == X86_REG) {
+      op_rm(encoder, instr->size, 0x85, instr->src.value, instr->dst);
+    } else {
+      assert(instr->dst.type == X86_REG);
+      op_rm(encoder, instr->size, 0x85, instr->dst.value, instr->src);
+    }
+    return;
+
+  case X86_IMUL:
+    assert(instr->dst.type == X86_REG);
+    op_rm(encoder, instr->size, 0x0faf, instr->dst.value, instr->src);
+    return;
+
+  case X86_IMUL3:
+    assert(instr->dst.type == X86_REG);
+    if (fits_int8(instr->imm)) {
+      op_rm(encoder, instr->size, 0x6b, instr->dst.value, instr->src);
+      byte(encoder, instr->imm);
+    } else {
+      op_rm(encoder, instr->size, 0x69, instr->dst.value, instr->src);
+      dword(encoder, instr->imm);
+    }
+    return;
+
+  case X86_CMOVNE:
+    assert(instr->dst.type == X86_REG);
+    op_rm(encoder, instr->size, 0x0f45, instr->dst.value, instr->src);
+    return;
+
+  case X86_IMUL1:
+    op_rm(encoder, instr->size, 0xf7, EXT_IMUL1, instr->src);
+    return;
+
+  case X86_IDIV:
+    op_rm(encoder, instr->size, 0xf7, EXT_IDIV, instr->src);
+    return;
+
+  case X86_NEG:
+    op_rm(encoder, instr->size, 0xf7, EXT_NEG, instr->dst);
+    return;
+
+  case X86_SHL:
+  case X86_SAR:
+  case X86_SHR: {
+    assert(instr->src.type == X86_IMM);
+    enum extension extension = instr->op == X86_SHL   ? EXT_SHL
+                               : instr->op == X86_SAR ? EXT_SAR
+                                                      : EXT_SHR;
+    if (instr->src.value == 1) {
+      op_rm(encoder, instr->size, 0xd1, extension, instr->dst);
+    } else {
+      op_rm(encoder, instr->size, 0xc1, extension, instr->dst);
+      byte(encoder, instr->src.value);
+    }
+    return;
+  }
+
+  case X86_LEA:
+    lea(encoder, instr);
+    return;
+
+  case X86_CDQ:
+    byte(encoder, 0x99);
+    return;
+
+  case X86_CALL:
+    assert(instr->src.type == X86_SYMBOL);
+    byte(encoder, 0xe8);
+    reloc(encoder, instr->src.value);
+    return;
+
+  case X86_PUSH:
+    assert(instr->src.type == X86_REG);
+    rex(encoder, 4, 0, 0, instr->src);
+    byte(encoder, 0x50 + low(instr->src.value));
+    return;
+
+  case X86_POP:
+    assert(instr->dst.type == X86_REG);
+    rex(encoder, 4, 0, 0, instr->dst);
+    byte(encoder, 0x58 + low(instr->dst.value));
+    return;
+
+  case X86_RET:
+    byte(encoder, 0xc3);
+    return;
+
+  case X86_MOVD:
+    if (instr->dst.type == X86_XMM) {
+      sse(encoder, 0x6e, instr->dst.value, instr->src);
+    } else {
+      assert(instr->src.type == X86_XMM);
+      sse(encoder, 0x7e, instr->src.value, instr->dst);
+    }
+    return;
+
+  case X86_MOVDQA:
+    assert(instr->dst.type == X86_XMM);
+    sse(encoder, 0x6f, instr->dst.value, instr->src);
+    return;
+
+  case X86_PINSRD:
+    assert(instr->dst.type == X86_XMM);
+    sse(encoder, 0x3a22, instr->dst.value, instr->src);
+    byte(encoder, instr->imm);
+    return;
+
+  case X86_PEXTRD:
+    assert(instr->src.type == X86_XMM);
+    sse(encoder, 0x3a16, instr->src.value, instr->dst);
+    byte(encoder, instr->imm);
+    return;
+
+  case X86_PSHUFD:
+    assert(instr->dst.type == X86_XMM);
+    sse(encoder, 0x70, instr->dst.value, instr->src);
+    byte(encoder, instr->imm);
+    return;
+
+  case X86_PADDD:
+    sse(encoder, 0xfe, instr->dst.value, instr->src);
+    return;
+
+  case X86_PSUBD:
+    sse(encoder, 0xfa, instr->dst.value, instr->src);
+    return;
+
+  case X86_PMULLD:
+    sse(encoder, 0x3840, instr->dst.value, instr->src);
+    return;
+
+  default:
+    UNREACHABLE();
+  }
+}
+
+void encode(struct x86_program *program, struct encode_output *output) {
+  assert(program && output);
+
+  *output = (struct encode_output){0};
+  struct encoder encoder = {program, output, NULL, 0, 0};
+
+  for (struct x86_instr *i = program->head; i; i = i->next) {
+    instr(&encoder, i);
+  }
+
+  if (program->num_constants == 0)
+    return;
+
+  // int3 up to the 16-byte alignment the vector instructions need, as
+  // x86_emit() asks of GAS.
+  while (output->text_size % 16 != 0)
+    byte(&encoder, 0xcc);
+
+  int constants = output->text_size;
+  for (int i = 0; i < program->num_constants; i++) {
+    for (int lane = 0; lane < X86_LANES; lane++)
+      dword(&encoder, program->constants[i].lanes[lane]);
+  }
+
+  // No vector instruction has an immediate after its displacement, so the
+  // field ends the instruction.
+  for (int i = 0; i < encoder.num_fields; i++) {
+    struct constant_field *field = &encoder.fields[i];
+    int value = constants + field->constant * 16 - (field->offset + 4);
+    memcpy(output->text + field->offset, &value, sizeof(value));
+  }
+  memory_free(encoder.fields);
+}
+
+void encode_free(struct encode_output *output) {
+  assert(output);
+
+  memory_free(output->text);
+  memory_free(output->relocs);
+  *output = (struct encode_output){0};
+}
@@ -0,0 +1,29 @@
+#ifndef encode_h
+#define encode_h
+
+#include "x86.h"
+
+// A 4-byte field in the machine code that the linker fills in with the
+// address of a symbol relative to the end of the field.
+struct encode_reloc {
+  int offset;
+  enum x86_symbol symbol;
+};
+
+struct encode_output {
+  unsigned char *text;
+  int text_size;
+  int text_capacity;
+
+  struct encode_reloc *relocs;
+  int num_relocs;
+  int relocs_capacity;
+};
+
+// Encodes a program whose frame has been laid out into x86-64 machine code.
+// Calls into the print runtime are left to relocations. The constants of
+// vector instructions follow the code, 16-byte aligned, within text_size.
+void encode(struct x86_program *program, struct encode_output *output);
+void encode_free(struct encode_output *output);
+
+#endif
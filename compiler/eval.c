@@ -0,0 +1,170 @@
+#include <limits.h>
+#include <string.h>
+
+#include "ast.h"
+#include "common.h"
+#include "eval.h"
+#include "memory.h"
+#include "output.h"
+
+struct value {
+  enum ast_data_type type;
+
+  union {
+    int i32;
+    bool boolean;
+  } as;
+};
+
+struct variable {
+  struct scanner_token *name;
+  struct value value;
+};
+
+struct evaluator {
+  // One per declaration, so at most one per statement.
+  struct variable *variables;
+  int num_variables;
+  bool trapped;
+};
+
+static struct value i32(int value) {
+  return (struct value){.type = TYPE_I32, .as.i32 = value};
+}
+
+static struct variable *lookup(struct evaluator *evaluator,
+                               struct scanner_token *name) {
+  for (int i = 0; i < evaluator->num_variables; i++) {
+    struct scanner_token *other = evaluator->variables[i].name;
+    if (other->length == name->length &&
+        memcmp(other->start, name->start, name->length) == 0)
+      return &evaluator->variables[i];
+  }
+
+  UNREACHABLE();
+  return NULL;
+}
+
+// Arithmetic wraps, as in the generated code.
+static struct value binary(struct evaluator *evaluator,
+                           enum scanner_token_type op, int left, int right) {
+  switch (op) {
+  case TOKEN_PLUS:
+    return i32((int)((unsigned)left + (unsigned)right));
+  case TOKEN_MINUS:
+    return i32((int)((unsigned)left - (unsigned)right));
+  case TOKEN_STAR:
+    return i32((int)((unsigned)left * (unsigned)right));
+  case TOKEN_SLASH:
+    if (right == 0 || (left == INT_MIN && right == -1)) {
+      evaluator->trapped = true;
+      return i32(0);
+    }
+    return i32(left / right);
+  default:
+    UNREACHABLE();
+    return i32(0);
+  }
+}
+
+static struct value eval_expr(struct evaluator *evaluator,
+                              struct ast_node *node) {
+  switch (node->type) {
+  case AST_LITERAL_EXPR: {
+    struct ast_literal_expr *literal = &node->as.literal_expr;
+    if (literal->type == TYPE_BOOL)
+      return (struct value){.type = TYPE_BOOL,
+                            .as.boolean = literal->as.boolean};
+    return i32(literal->as.i32);
+  }
+
+  case AST_IDENTIFIER_EXPR:
+    return lookup(evaluator, &node->as.identifier)->value;
+
+  case AST_GROUPING_EXPR:
+    return eval_expr(evaluator, node->as.grouping_expr.expr);
+
+  case AST_UNARY_EXPR: {
+    struct value right = eval_expr(evaluator, node->as.unary_expr.right);
+    return i32((int)-(unsigned)right.as.i32);
+  }
+
+  case AST_BINARY_EXPR: {
+    // Left to right, whatever order() chose for the generated code.
+    struct value left = eval_expr(evaluator, node->as.binary_expr.left);
+    if (evaluator->trapped)
+      return left;
+
+    struct value right = eval_expr(evaluator, node->as.binary_expr.right);
+    if (evaluator->trapped)
+      return right;
+
+    return binary(evaluator, node->as.binary_expr.token.type, left.as.i32,
+                  right.as.i32);
+  }
+
+  case AST_ASSIGNMENT_STMT: {
+    struct ast_assignment_stmt *assignment = &node->as.assignment_stmt;
+    struct value value = eval_expr(evaluator, assignment->expr);
+    if (!evaluator->trapped)
+      lookup(evaluator, &assignment->identifier->as.identifier)->value = value;
+    return value;
+  }
+
+  default:
+    UNREACHABLE();
+    return i32(0);
+  }
+}
+
+static void eval_stmt(struct evaluator *evaluator, struct ast_node *node,
+                      struct output *output) {
+  switch (node->type) {
+  case AST_VARIABLE_DECL: {
+    struct ast_variable_decl *decl = &node->as.variable_decl;
+    struct value value = eval_expr(evaluator, decl->initialiser);
+
+    evaluator->variables[evaluator->num_variables++] =
+        (struct variable){&decl->name, value};
+    break;
+  }
+
+  case AST_PRINT_STMT: {
+    struct value value = eval_expr(evaluator, node->as.print_stmt.expr);
+    if (evaluator->trapped)
+      break;
+
+    if (value.type == TYPE_BOOL) {
+      output_bool(output, value.as.boolean);
+    } else {
+      output_i32(output, value.as.i32);
+    }
+    break;
+  }
+
+  default:
+    eval_expr(evaluator, node);
+    break;
+  }
+}
+
+bool eval(struct ast_node *root, struct output *output) {
+  assert(root && root->type == AST_PROGRAM);
+  assert(output);
+
+  struct ast_program *program = &root->as.program;
+  struct evaluator evaluator = {
+      .variables = memory_alloc(MEMORY_VM, (program->num_statements + 1) *
+                                               sizeof(*evaluator.variables)),
+      .num_variables = 0,
+      .trapped = false,
+  };
+  if (evaluator.variables == NULL)
+    ERROR_OUT();
+
+  for (int i = 0; i < program->num_statements && !evaluator.trapped; i++)
+    eval_stmt(&evaluator, program->statements[i], output);
+
+  memory_free(evaluator.variables);
+  return !evaluator.trapped;
+}
@@ -0,0 +1,14 @@
+#ifndef eval_h
+#define eval_h
+
+#include "ast.h"
+#include "common.h"
+#include "output.h"
+
+// Reference evaluator: interprets a type-checked AST directly, with a switch
+// per node and variables looked up by name. Independent of the IR and every
+// backend, so their output can be checked against it. Returns false if a
+// division traps.
+bool eval(struct ast_node *root, struct output *output);
+
+#endif
@@ -0,0 +1,83 @@
+#include <limits.h>
+
+#include "common.h"
+#include "fold.h"
+#include "ir.h"
+#include "memory.h"
+
+// Forward constant propagation and folding. Programs are straight-line, so
+// the value a temporary holds at each point is known exactly from the
+// definitions before it. Arithmetic wraps modulo 2^32; divisions that would
+// trap are left for the program to execute.
+
+static bool fold_instr(struct ir_instr *instr, int *result) {
+  unsigned int a = (unsigned int)instr->a.value;
+  unsigned int b = (unsigned int)instr->b.value;
+
+  switch (instr->op) {
+  case IR_COPY:
+    *result = instr->a.value;
+    return true;
+  case IR_NEG:
+    *result = (int)(0u - a);
+    return true;
+  case IR_ADD:
+    *result = (int)(a + b);
+    return true;
+  case IR_SUB:
+    *result = (int)(a - b);
+    return true;
+  case IR_MUL:
+    *result = (int)(a * b);
+    return true;
+  case IR_DIV:
+    if (instr->b.value == 0 ||
+        (instr->a.value == INT_MIN && instr->b.value == -1))
+      return false;
+    *result = instr->a.value / instr->b.value;
+    return true;
+  default:
+    return false;
+  }
+}
+
+static void propagate(struct ir_operand *operand, bool *known, int *values) {
+  if (operand->type == IR_OPERAND_TEMP && known[operand->value])
+    *operand = IR_IMM(values[operand->value]);
+}
+
+void fold(struct ir_program *program) {
+  assert(program);
+
+  bool *known =
+      memory_calloc(MEMORY_PASSES, program->num_temps + 1, sizeof(*known));
+  int *values =
+      memory_calloc(MEMORY_PASSES, program->num_temps + 1, sizeof(*values));
+  if (known == NULL || values == NULL)
+    ERROR_OUT();
+
+  for (struct ir_instr *instr = program->head; instr; instr = instr->next) {
+    propagate(&instr->a, known, values);
+    propagate(&instr->b, known, values);
+
+    if (instr->dst.type != IR_OPERAND_TEMP)
+      continue;
+
+    int result;
+    bool constant = instr->a.type == IR_OPERAND_IMM &&
+                    instr->b.type != IR_OPERAND_TEMP &&
+                    fold_instr(instr, &result);
+
+    known[instr->dst.value] = constant;
+    if (!constant)
+      continue;
+
+    values[instr->dst.value] = result;
+    instr->op = IR_COPY;
+    instr->a = IR_IMM(result);
+    instr->b = IR_NONE();
+  }
+
+  memory_free(known);
+  memory_free(values);
+}
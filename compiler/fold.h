@@ -0,0 +1,8 @@
+#ifndef fold_h
+#define fold_h
+
+#include "ir.h"
+
+void fold(struct ir_program *program);
+
+#endif
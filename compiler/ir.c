@@ -0,0 +1,490 @@
+#include "ir.h"
+#include "ast.h"
+#include "common.h"
+#include "memory.h"
+#include "symbols.h"
+
+static int ir_new_temp(struct ir_program *program, enum ast_data_type type,
+                       const char *name, int name_length) {
+  if (program->num_temps == program->temps_capacity) {
+    program->temps_capacity =
+        program->temps_capacity ? program->temps_capacity * 2 : 16;
+    program->temps =
+        memory_realloc(MEMORY_IR, program->temps,
+                       program->temps_capacity * sizeof(*program->temps));
+    if (program->temps == NULL)
+      ERROR_OUT();
+  }
+
+  struct ir_temp *temp = &program->temps[program->num_temps];
+  temp->type = type;
+  temp->name = name;
+  temp->name_length = name_length;
+
+  return program->num_temps++;
+}
+
+static struct ir_instr *ir_append(struct ir_program *program,
+                                  enum ir_opcode op, enum ast_data_type type,
+                                  struct ir_operand dst, struct ir_operand a,
+                                  struct ir_operand b) {
+  struct ir_instr *instr = memory_alloc(MEMORY_IR, sizeof(*instr));
+  if (instr == NULL)
+    ERROR_OUT();
+
+  instr->op = op;
+  instr->type = type;
+  instr->pack = IR_PACK_NONE;
+  instr->dst = dst;
+  instr->a = a;
+  instr->b = b;
+  instr->next = NULL;
+  instr->prev = program->tail;
+
+  if (program->tail) {
+    program->tail->next = instr;
+  } else {
+    program->head = instr;
+  }
+  program->tail = instr;
+  program->num_instrs++;
+
+  return instr;
+}
+
+static struct ast_node *lookup(symbol_table_t *table, struct ast_node *node) {
+  assert(node->type == AST_IDENTIFIER_EXPR);
+
+  struct ast_node *decl = symbol_table_get(table, &node->as.identifier);
+  assert(decl && decl->as.variable_decl.temp >= 0);
+
+  return decl;
+}
+
+static enum ast_data_type expr_type(struct ast_node *node,
+                                    symbol_table_t *table) {
+  switch (node->type) {
+  case AST_LITERAL_EXPR:
+    return node->as.literal_expr.type;
+  case AST_IDENTIFIER_EXPR:
+    return lookup(table, node)->as.variable_decl.type;
+  case AST_ASSIGNMENT_STMT:
+    return expr_type(node->as.assignment_stmt.identifier, table);
+  case AST_GROUPING_EXPR:
+    return expr_type(node->as.grouping_expr.expr, table);
+  case AST_BINARY_EXPR:
+  case AST_UNARY_EXPR:
+    return TYPE_I32;
+  default:
+    UNREACHABLE();
+    return TYPE_ERROR;
+  }
+}
+
+static enum ir_opcode binary_opcode(enum scanner_token_type op) {
+  switch (op) {
+  case TOKEN_PLUS:
+    return IR_ADD;
+  case TOKEN_MINUS:
+    return IR_SUB;
+  case TOKEN_STAR:
+    return IR_MUL;
+  case TOKEN_SLASH:
+    return IR_DIV;
+  default:
+    UNREACHABLE();
+    return IR_ADD;
+  }
+}
+
+static struct ir_operand lower_expr(struct ir_program *program,
+                                    struct ast_node *node,
+                                    symbol_table_t *table) {
+  assert(node);
+
+  switch (node->type) {
+  case AST_LITERAL_EXPR:
+    if (node->as.literal_expr.type == TYPE_BOOL)
+      return IR_IMM(node->as.literal_expr.as.boolean);
+    return IR_IMM(node->as.literal_expr.as.i32);
+
+  case AST_IDENTIFIER_EXPR:
+    return IR_TEMP(lookup(table, node)->as.variable_decl.temp);
+
+  case AST_GROUPING_EXPR:
+    return lower_expr(program, node->as.grouping_expr.expr, table);
+
+  case AST_UNARY_EXPR: {
+    struct ir_operand right =
+        lower_expr(program, node->as.unary_expr.right, table);
+    struct ir_operand dst = IR_TEMP(ir_new_temp(program, TYPE_I32, NULL, 0));
+
+    ir_append(program, IR_NEG, TYPE_I32, dst, right, IR_NONE());
+    return dst;
+  }
+
+  case AST_BINARY_EXPR: {
+    struct ast_binary_expr *expr = &node->as.binary_expr;
+    struct ir_operand left;
+    struct ir_operand right;
+
+    if (expr->right_first) {
+      // Set by order(), only when neither side assigns.
+      right = lower_expr(program, expr->right, table);
+      left = lower_expr(program, expr->left, table);
+    } else {
+      left = lower_expr(program, expr->left, table);
+
+      // A variable read on the left must not observe an assignment made
+      // while evaluating the right.
+      if (left.type == IR_OPERAND_TEMP && left.value < program->num_vars &&
+          ast_assigns(expr->right)) {
+        struct ir_operand copy =
+            IR_TEMP(ir_new_temp(program, TYPE_I32, NULL, 0));
+        ir_append(program, IR_COPY, TYPE_I32, copy, left, IR_NONE());
+        left = copy;
+      }
+
+      right = lower_expr(program, expr->right, table);
+    }
+
+    struct ir_operand dst = IR_TEMP(ir_new_temp(program, TYPE_I32, NULL, 0));
+
+    ir_append(program, binary_opcode(expr->token.type), TYPE_I32, dst, left,
+              right);
+    return dst;
+  }
+
+  case AST_ASSIGNMENT_STMT: {
+    struct ast_node *decl = lookup(table, node->as.assignment_stmt.identifier);
+    struct ir_operand value =
+        lower_expr(program, node->as.assignment_stmt.expr, table);
+    struct ir_operand dst = IR_TEMP(decl->as.variable_decl.temp);
+
+    ir_append(program, IR_COPY, decl->as.variable_decl.type, dst, value,
+              IR_NONE());
+    return dst;
+  }
+
+  default:
+    UNREACHABLE();
+    return IR_NONE();
+  }
+}
+
+static void lower_stmt(struct ir_program *program, struct ast_node *node,
+                       symbol_table_t *table) {
+  assert(node);
+
+  switch (node->type) {
+  case AST_VARIABLE_DECL: {
+    struct ir_operand value =
+        lower_expr(program, node->as.variable_decl.initialiser, table);
+
+    ir_append(program, IR_COPY, node->as.variable_decl.type,
+              IR_TEMP(node->as.variable_decl.temp), value, IR_NONE());
+    break;
+  }
+
+  case AST_PRINT_STMT: {
+    struct ir_operand value =
+        lower_expr(program, node->as.print_stmt.expr, table);
+    ir_append(program, IR_PRINT, expr_type(node->as.print_stmt.expr, table),
+              IR_NONE(), value, IR_NONE());
+    break;
+  }
+
+  default:
+    lower_expr(program, node, table);
+    break;
+  }
+}
+
+struct ir_program *ir_new(struct ast_node *root, symbol_table_t *table) {
+  assert(root && root->type == AST_PROGRAM);
+  assert(table);
+
+  struct ir_program *program = memory_alloc(MEMORY_IR, sizeof(*program));
+  if (program == NULL)
+    ERROR_OUT();
+
+  program->head = NULL;
+  program->tail = NULL;
+  program->num_instrs = 0;
+  program->temps = NULL;
+  program->num_temps = 0;
+  program->temps_capacity = 0;
+  program->num_vars = 0;
+  program->num_packs = 0;
+  program->num_rejected_packs = 0;
+
+  // Variables are numbered first so that num_vars partitions the temps.
+  for (int i = 0; i < root->as.program.num_statements; i++) {
+    struct ast_node *stmt = root->as.program.statements[i];
+    if (stmt->type != AST_VARIABLE_DECL)
+      continue;
+
+    stmt->as.variable_decl.temp = ir_new_temp(
+        program, stmt->as.variable_decl.type, stmt->as.variable_decl.name.start,
+        stmt->as.variable_decl.name.length);
+    program->num_vars++;
+  }
+
+  for (int i = 0; i < root->as.program.num_statements; i++) {
+    lower_stmt(program, root->as.program.statements[i], table);
+  }
+
+  return program;
+}
+
+void ir_free(struct ir_program **program) {
+  assert(program && *program);
+
+  struct ir_instr *instr = (*program)->head;
+  while (instr) {
+    struct ir_instr *next = instr->next;
+    memory_free(instr);
+    instr = next;
+  }
+
+  memory_free((*program)->temps);
+  memory_free(*program);
+  *program = NULL;
+}
+
+void ir_unlink(struct ir_program *program, struct ir_instr *instr) {
+  assert(program && instr);
+
+  if (instr->prev) {
+    instr->prev->next = instr->next;
+  } else {
+    program->head = instr->next;
+  }
+
+  if (instr->next) {
+    instr->next->prev = instr->prev;
+  } else {
+    program->tail = instr->prev;
+  }
+
+  instr->prev = NULL;
+  instr->next = NULL;
+  program->num_instrs--;
+}
+
+void ir_insert_before(struct ir_program *program, struct ir_instr *next,
+                      struct ir_instr *instr) {
+  assert(program && instr);
+
+  instr->next = next;
+  instr->prev = next ? next->prev : program->tail;
+
+  if (instr->prev) {
+    instr->prev->next = instr;
+  } else {
+    program->head = instr;
+  }
+
+  if (next) {
+    next->prev = instr;
+  } else {
+    program->tail = instr;
+  }
+
+  program->num_instrs++;
+}
+
+void ir_remove(struct ir_program *program, struct ir_instr *instr) {
+  assert(program && instr);
+
+  ir_unlink(program, instr);
+  memory_free(instr);
+}
+
+static const char *opcode_to_string(enum ir_opcode op) {
+  switch (op) {
+  case IR_COPY:
+    return "copy";
+  case IR_ADD:
+    return "add";
+  case IR_SUB:
+    return "sub";
+  case IR_MUL:
+    return "mul";
+  case IR_DIV:
+    return "div";
+  case IR_NEG:
+    return "neg";
+  case IR_PRINT:
+    return "print";
+  default:
+    UNREACHABLE();
+    return NULL;
+  }
+}
+
+static int operand_count(enum ir_opcode op) {
+  switch (op) {
+  case IR_COPY:
+  case IR_NEG:
+  case IR_PRINT:
+    return 1;
+  default:
+    return 2;
+  }
+}
+
+static bool verify_use(struct ir_program *program, bool *defined, int index,
+                       struct ir_operand operand) {
+  if (operand.type == IR_OPERAND_IMM)
+    return true;
+
+  if (operand.type != IR_OPERAND_TEMP || operand.value < 0 ||
+      operand.value >= program->num_temps) {
+    fprintf(stderr, "[error] IR instruction %d has an invalid operand.\n",
+            index);
+    return false;
+  }
+
+  if (!defined[operand.value]) {
+    fprintf(stderr, "[error] IR instruction %d uses t%d before definition.\n",
+            index, operand.value);
+    return false;
+  }
+
+  return true;
+}
+
+// The lanes of a pack are i32 additions, subtractions or multiplications
+// with the same opcode, and none starts another pack.
+static bool verify_pack(struct ir_instr *instr) {
+  if (instr->op != IR_ADD && instr->op != IR_SUB && instr->op != IR_MUL)
+    return false;
+
+  struct ir_instr *lane = instr;
+  for (int i = 0; i < IR_PACK_WIDTH; i++, lane = lane->next) {
+    if (lane == NULL || lane->op != instr->op || lane->type != TYPE_I32 ||
+        (i > 0 && lane->pack != IR_PACK_NONE))
+      return false;
+  }
+
+  return true;
+}
+
+bool ir_verify(struct ir_program *program) {
+  assert(program);
+
+  bool *defined =
+      memory_calloc(MEMORY_IR, program->num_temps + 1, sizeof(*defined));
+  if (defined == NULL)
+    ERROR_OUT();
+
+  bool ok = true;
+  int index = 0;
+  struct ir_instr *prev = NULL;
+
+  for (struct ir_instr *instr = program->head; instr && ok;
+       prev = instr, instr = instr->next, index++) {
+    if (instr->prev != prev) {
+      fprintf(stderr, "[error] IR instruction %d has a broken link.\n", index);
+      ok = false;
+      break;
+    }
+
+    ok = verify_use(program, defined, index, instr->a);
+    if (ok && operand_count(instr->op) == 2) {
+      ok = verify_use(program, defined, index, instr->b);
+    } else if (ok && instr->b.type != IR_OPERAND_NONE) {
+      fprintf(stderr, "[error] IR instruction %d has a stray operand.\n",
+              index);
+      ok = false;
+    }
+
+    if (!ok)
+      break;
+
+    if (instr->pack != IR_PACK_NONE && !verify_pack(instr)) {
+      fprintf(stderr, "[error] IR instruction %d starts an invalid pack.\n",
+              index);
+      ok = false;
+      break;
+    }
+
+    if (instr->op == IR_PRINT) {
+      if (instr->dst.type != IR_OPERAND_NONE) {
+        fprintf(stderr, "[error] IR print %d has a destination.\n", index);
+        ok = false;
+      }
+      continue;
+    }
+
+    if (instr->dst.type != IR_OPERAND_TEMP || instr->dst.value < 0 ||
+        instr->dst.value >= program->num_temps) {
+      fprintf(stderr, "[error] IR instruction %d has an invalid destination.\n",
+              index);
+      ok = false;
+    } else if (instr->dst.value >= program->num_vars &&
+               defined[instr->dst.value]) {
+      fprintf(stderr, "[error] IR instruction %d redefines t%d.\n", index,
+              instr->dst.value);
+      ok = false;
+    } else {
+      defined[instr->dst.value] = true;
+    }
+  }
+
+  if (ok && (prev != program->tail || index != program->num_instrs)) {
+    fprintf(stderr, "[error] IR instruction list is inconsistent.\n");
+    ok = false;
+  }
+
+  memory_free(defined);
+  return ok;
+}
+
+static void print_operand(struct ir_program *program, struct ir_operand operand,
+                          FILE *file) {
+  switch (operand.type) {
+  case IR_OPERAND_IMM:
+    fprintf(file, "%d", operand.value);
+    break;
+  case IR_OPERAND_TEMP: {
+    struct ir_temp *temp = &program->temps[operand.value];
+    if (temp->name) {
+      fprintf(file, "%.*s", temp->name_length, temp->name);
+    } else {
+      fprintf(file, "t%d", operand.value);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void ir_print(struct ir_program *program, FILE *file) {
+  assert(program && file);
+
+  for (struct ir_instr *instr = program->head; instr; instr = instr->next) {
+    if (instr->dst.type != IR_OPERAND_NONE) {
+      print_operand(program, instr->dst, file);
+      fprintf(file, " <- ");
+    }
+
+    fprintf(file, "%s.%s ", opcode_to_string(instr->op),
+            instr->type == TYPE_BOOL ? "bool" : "i32");
+    print_operand(program, instr->a, file);
+
+    if (operand_count(instr->op) == 2) {
+      fprintf(file, ", ");
+      print_operand(program, instr->b, file);
+    }
+
+    if (instr->pack != IR_PACK_NONE) {
+      fprintf(file, "  ; pack of %d%s", IR_PACK_WIDTH,
+              instr->pack == IR_PACK_ROOT ? ", root" : "");
+    }
+
+    fprintf(file, "\n");
+  }
+}
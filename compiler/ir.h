@@ -0,0 +1,92 @@
+#ifndef ir_h
+#define ir_h
+
+#include "ast.h"
+#include "common.h"
+#include "symbols.h"
+
+// Linear three-address IR for straight-line programs. Temporaries below
+// num_vars hold declared variables and may be assigned more than once; every
+// other temporary is defined exactly once.
+
+enum ir_opcode {
+  IR_COPY,  // dst <- a
+  IR_ADD,   // dst <- a + b
+  IR_SUB,   // dst <- a - b
+  IR_MUL,   // dst <- a * b
+  IR_DIV,   // dst <- a / b
+  IR_NEG,   // dst <- -a
+  IR_PRINT, // print a
+};
+
+enum ir_operand_type { IR_OPERAND_NONE, IR_OPERAND_TEMP, IR_OPERAND_IMM };
+
+// Set by slp() on the first of IR_PACK_WIDTH adjacent i32 instructions with
+// the same opcode that the backend may execute as one vector instruction,
+// lane i being the i-th. An inner pack's results are read only by the
+// packs after it; a root pack's are read as scalars.
+enum ir_pack { IR_PACK_NONE, IR_PACK_INNER, IR_PACK_ROOT };
+
+#define IR_PACK_WIDTH 4
+
+struct ir_operand {
+  enum ir_operand_type type;
+  int value;
+};
+
+struct ir_instr {
+  enum ir_opcode op;
+  enum ast_data_type type;
+  enum ir_pack pack;
+
+  struct ir_operand dst;
+  struct ir_operand a;
+  struct ir_operand b;
+
+  struct ir_instr *prev;
+  struct ir_instr *next;
+};
+
+struct ir_temp {
+  enum ast_data_type type;
+
+  // Source name for variables, NULL for temporaries.
+  const char *name;
+  int name_length;
+};
+
+struct ir_program {
+  struct ir_instr *head;
+  struct ir_instr *tail;
+  int num_instrs;
+
+  struct ir_temp *temps;
+  int num_temps;
+  int temps_capacity;
+  int num_vars;
+
+  // Filled in by slp(): packs formed, and trees of packs rejected as slower
+  // than the scalar instructions.
+  int num_packs;
+  int num_rejected_packs;
+};
+
+#define IR_TEMP(n) ((struct ir_operand){.type = IR_OPERAND_TEMP, .value = (n)})
+#define IR_IMM(n) ((struct ir_operand){.type = IR_OPERAND_IMM, .value = (n)})
+#define IR_NONE() ((struct ir_operand){.type = IR_OPERAND_NONE, .value = 0})
+
+struct ir_program *ir_new(struct ast_node *root, symbol_table_t *table);
+void ir_free(struct ir_program **program);
+
+void ir_remove(struct ir_program *program, struct ir_instr *instr);
+
+// Takes an instruction out of the list without freeing it, and puts one back
+// before `next`, or at the end when `next` is NULL.
+void ir_unlink(struct ir_program *program, struct ir_instr *instr);
+void ir_insert_before(struct ir_program *program, struct ir_instr *next,
+                      struct ir_instr *instr);
+
+bool ir_verify(struct ir_program *program);
+void ir_print(struct ir_program *program, FILE *file);
+
+#endif
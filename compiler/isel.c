@@ -0,0 +1,389 @@
+#include "isel.h"
+#include "common.h"
+#include "divconst.h"
+#include "ir.h"
+#include "memory.h"
+#include "mulconst.h"
+#include "x86.h"
+
+// Instruction selection. Every IR temporary becomes the virtual register of
+// the same number; extra virtual registers are created for intermediate
+// values. Instructions that pin registers (idivl, one-operand imull, calls)
+// move their operands through the physical registers explicitly so that the
+// allocator sees exactly where each register is busy.
+//
+// Packs formed by slp() are selected as one vector instruction on %xmm
+// registers, which the allocator never sees: the lanes of a tree of packs
+// are adjacent, so its registers are live only within the instructions
+// selected for it and no call clobbers them. Immediate operands become
+// constants in memory.
+
+_Static_assert(IR_PACK_WIDTH == X86_LANES, "a pack fills an %xmm register");
+
+struct vectors {
+  // Per temporary: register * IR_PACK_WIDTH + lane holding an inner pack's
+  // result, or -1.
+  int *lanes;
+  bool used[X86_NUM_XMM];
+};
+
+static struct x86_operand operand(struct ir_operand operand) {
+  switch (operand.type) {
+  case IR_OPERAND_TEMP:
+    return X86_VREG(operand.value);
+  case IR_OPERAND_IMM:
+    return X86_IMM(operand.value);
+  default:
+    UNREACHABLE();
+    return X86_NONE();
+  }
+}
+
+// Instructions that cannot take an immediate get it through a register.
+static struct x86_operand in_vreg(struct x86_program *program,
+                                  struct x86_operand value) {
+  if (value.type == X86_VREG)
+    return value;
+
+  struct x86_operand vreg = X86_VREG(x86_new_vreg(program));
+  x86_emit_op(program, X86_MOV, value, vreg);
+  return vreg;
+}
+
+static void select_binary(struct x86_program *program, enum x86_opcode op,
+                          struct x86_operand dst, struct x86_operand a,
+                          struct x86_operand b) {
+  assert(!(b.type == X86_VREG && b.value == dst.value));
+
+  x86_emit_op(program, X86_MOV, a, dst);
+  x86_emit_op(program, op, b, dst);
+}
+
+static void select_mulconst(struct x86_program *program,
+                            const struct mulconst_entry *entry,
+                            struct x86_operand dst, struct x86_operand a) {
+  struct x86_operand values[MULCONST_MAX_OPS + 1];
+  values[0] = a;
+
+  for (int i = 0; i < entry->num_ops; i++) {
+    const struct mulconst_op *op = &entry->ops[i];
+    struct x86_operand value = i + 1 == entry->num_ops
+                                   ? dst
+                                   : X86_VREG(x86_new_vreg(program));
+
+    switch (op->kind) {
+    case MULCONST_SHL:
+      x86_emit_op(program, X86_MOV, values[op->a], value);
+      x86_emit_op(program, X86_SHL, X86_IMM(op->imm), value);
+      break;
+    case MULCONST_ADD:
+      select_binary(program, X86_ADD, value, values[op->a], values[op->b]);
+      break;
+    case MULCONST_SUB:
+      select_binary(program, X86_SUB, value, values[op->a], values[op->b]);
+      break;
+    case MULCONST_LEA: {
+      struct x86_instr *lea =
+          x86_emit_op(program, X86_LEA, values[op->a], value);
+      lea->index = values[op->b];
+      lea->imm = op->imm;
+      break;
+    }
+    default:
+      UNREACHABLE();
+    }
+
+    values[i + 1] = value;
+  }
+}
+
+static void select_mul(struct x86_program *program, struct x86_operand dst,
+                       struct x86_operand a, struct x86_operand b) {
+  if (a.type == X86_IMM) {
+    struct x86_operand tmp = a;
+    a = b;
+    b = tmp;
+  }
+
+  if (b.type != X86_IMM) {
+    select_binary(program, X86_IMUL, dst, a, b);
+    return;
+  }
+
+  a = in_vreg(program, a);
+
+  if (b.value == 0) {
+    x86_emit_op(program, X86_MOV, X86_IMM(0), dst);
+    return;
+  }
+
+  if (b.value == 1) {
+    x86_emit_op(program, X86_MOV, a, dst);
+    return;
+  }
+
+  if (b.value == -1) {
+    x86_emit_op(program, X86_MOV, a, dst);
+    x86_emit_op(program, X86_NEG, X86_NONE(), dst);
+    return;
+  }
+
+  const struct mulconst_entry *entry = mulconst_lookup(b.value);
+  if (entry) {
+    select_mulconst(program, entry, dst, a);
+    return;
+  }
+
+  struct x86_instr *imul = x86_emit_op(program, X86_IMUL3, a, dst);
+  imul->imm = b.value;
+}
+
+static void select_idiv(struct x86_program *program, struct x86_operand dst,
+                        struct x86_operand a, struct x86_operand b) {
+  b = in_vreg(program, b);
+
+  x86_emit_op(program, X86_MOV, a, X86_REG(REG_RAX));
+  x86_emit_op(program, X86_CDQ, X86_NONE(), X86_NONE());
+  x86_emit_op(program, X86_IDIV, b, X86_NONE());
+  x86_emit_op(program, X86_MOV, X86_REG(REG_RAX), dst);
+}
+
+// See docs/CODEGEN.md for the sequences.
+static void select_div(struct x86_program *program, struct x86_operand dst,
+                       struct x86_operand a, struct x86_operand b) {
+  if (b.type != X86_IMM) {
+    select_idiv(program, dst, a, b);
+    return;
+  }
+
+  struct divconst_plan plan = divconst_plan(b.value);
+
+  switch (plan.strategy) {
+  case DIVCONST_IDIV:
+    select_idiv(program, dst, a, b);
+    return;
+
+  case DIVCONST_IDENTITY:
+    x86_emit_op(program, X86_MOV, a, dst);
+    return;
+
+  case DIVCONST_POW2: {
+    a = in_vreg(program, a);
+
+    x86_emit_op(program, X86_MOV, a, dst);
+    if (plan.shift > 1)
+      x86_emit_op(program, X86_SAR, X86_IMM(plan.shift - 1), dst);
+    x86_emit_op(program, X86_SHR, X86_IMM(32 - plan.shift), dst);
+    x86_emit_op(program, X86_ADD, a, dst);
+    x86_emit_op(program, X86_SAR, X86_IMM(plan.shift), dst);
+    break;
+  }
+
+  case DIVCONST_MAGIC: {
+    a = in_vreg(program, a);
+    struct x86_operand sign = X86_VREG(x86_new_vreg(program));
+
+    x86_emit_op(program, X86_MOV, X86_IMM(plan.multiplier), X86_REG(REG_RAX));
+    x86_emit_op(program, X86_IMUL1, a, X86_NONE());
+    x86_emit_op(program, X86_MOV, X86_REG(REG_RDX), dst);
+    if (plan.multiplier < 0)
+      x86_emit_op(program, X86_ADD, a, dst);
+    if (plan.shift > 0)
+      x86_emit_op(program, X86_SAR, X86_IMM(plan.shift), dst);
+    x86_emit_op(program, X86_MOV, dst, sign);
+    x86_emit_op(program, X86_SHR, X86_IMM(31), sign);
+    x86_emit_op(program, X86_ADD, sign, dst);
+    break;
+  }
+
+  default:
+    UNREACHABLE();
+  }
+
+  if (plan.negate)
+    x86_emit_op(program, X86_NEG, X86_NONE(), dst);
+}
+
+static void select_print(struct x86_program *program, enum ast_data_type type,
+                         struct x86_operand value) {
+  enum x86_symbol function = type == TYPE_I32 ? SYM_PRINT_I32 : SYM_PRINT_BOOL;
+  x86_emit_op(program, X86_MOV, value, X86_REG(REG_RDI));
+  struct x86_instr *call =
+      x86_emit_op(program, X86_CALL, X86_SYMBOL(function), X86_NONE());
+  call->imm = 1;
+}
+
+static int new_xmm(struct vectors *vectors) {
+  for (int i = 0; i < X86_NUM_XMM; i++) {
+    if (!vectors->used[i]) {
+      vectors->used[i] = true;
+      return i;
+    }
+  }
+
+  // slp() bounds the packs of a tree far below this.
+  UNREACHABLE();
+  return -1;
+}
+
+// Operand k of the lanes: the register holding the result of an earlier pack
+// if every lane's operand is the same lane of it, a constant if every lane's
+// is an immediate, or else a register filled from the scalars, broadcasting
+// a value all lanes share.
+static struct x86_operand select_lanes(struct x86_program *program,
+                                       struct vectors *vectors,
+                                       struct ir_instr **lanes, int k) {
+  struct ir_operand values[IR_PACK_WIDTH];
+  int immediates[IR_PACK_WIDTH];
+  bool same = true;
+  bool constant = true;
+  bool packed = true;
+
+  for (int i = 0; i < IR_PACK_WIDTH; i++) {
+    values[i] = k == 0 ? lanes[i]->a : lanes[i]->b;
+    immediates[i] = values[i].value;
+    same = same && values[i].type == values[0].type &&
+           values[i].value == values[0].value;
+    constant = constant && values[i].type == IR_OPERAND_IMM;
+    packed = packed && values[i].type == IR_OPERAND_TEMP &&
+             vectors->lanes[values[i].value] >= 0 &&
+             vectors->lanes[values[i].value] ==
+                 vectors->lanes[values[0].value] + i;
+  }
+
+  if (packed && vectors->lanes[values[0].value] % IR_PACK_WIDTH == 0)
+    return X86_XMM(vectors->lanes[values[0].value] / IR_PACK_WIDTH);
+
+  if (constant)
+    return X86_CONSTANT(x86_new_constant(program, immediates));
+
+  struct x86_operand xmm = X86_XMM(new_xmm(vectors));
+  x86_emit_op(program, X86_MOVD, in_vreg(program, operand(values[0])), xmm);
+
+  if (same) {
+    struct x86_instr *shuffle = x86_emit_op(program, X86_PSHUFD, xmm, xmm);
+    shuffle->imm = 0;
+    return xmm;
+  }
+
+  for (int i = 1; i < IR_PACK_WIDTH; i++) {
+    struct x86_operand value = in_vreg(program, operand(values[i]));
+    struct x86_instr *insert = x86_emit_op(program, X86_PINSRD, value, xmm);
+    insert->imm = i;
+  }
+  return xmm;
+}
+
+// Selects the pack starting at `leader` and returns its last lane.
+static struct ir_instr *select_pack(struct x86_program *program,
+                                    struct vectors *vectors,
+                                    struct ir_instr *leader) {
+  struct ir_instr *lanes[IR_PACK_WIDTH];
+  lanes[0] = leader;
+  for (int i = 1; i < IR_PACK_WIDTH; i++)
+    lanes[i] = lanes[i - 1]->next;
+
+  struct x86_operand a = select_lanes(program, vectors, lanes, 0);
+  if (a.type == X86_CONSTANT) {
+    struct x86_operand xmm = X86_XMM(new_xmm(vectors));
+    x86_emit_op(program, X86_MOVDQA, a, xmm);
+    a = xmm;
+  }
+
+  // A constant stays in memory as the source operand.
+  struct x86_operand b = select_lanes(program, vectors, lanes, 1);
+
+  enum x86_opcode op = leader->op == IR_ADD   ? X86_PADDD
+                       : leader->op == IR_SUB ? X86_PSUBD
+                                              : X86_PMULLD;
+  x86_emit_op(program, op, b, a);
+  if (b.type == X86_XMM)
+    vectors->used[b.value] = false;
+
+  if (leader->pack == IR_PACK_INNER) {
+    for (int i = 0; i < IR_PACK_WIDTH; i++)
+      vectors->lanes[lanes[i]->dst.value] = a.value * IR_PACK_WIDTH + i;
+    return lanes[IR_PACK_WIDTH - 1];
+  }
+
+  x86_emit_op(program, X86_MOVD, a, operand(lanes[0]->dst));
+  for (int i = 1; i < IR_PACK_WIDTH; i++) {
+    struct x86_instr *extract =
+        x86_emit_op(program, X86_PEXTRD, a, operand(lanes[i]->dst));
+    extract->imm = i;
+  }
+  vectors->used[a.value] = false;
+  return lanes[IR_PACK_WIDTH - 1];
+}
+
+struct x86_program *isel(struct ir_program *ir) {
+  assert(ir);
+
+  struct x86_program *program = x86_new();
+  program->num_vregs = ir->num_temps;
+
+  struct vectors vectors = {.lanes = NULL};
+  if (ir->num_packs > 0) {
+    vectors.lanes =
+        memory_alloc(MEMORY_ISEL, ir->num_temps * sizeof(*vectors.lanes));
+    if (vectors.lanes == NULL)
+      ERROR_OUT();
+    for (int i = 0; i < ir->num_temps; i++)
+      vectors.lanes[i] = -1;
+  }
+
+  for (struct ir_instr *instr = ir->head; instr; instr = instr->next) {
+    if (instr->pack != IR_PACK_NONE) {
+      instr = select_pack(program, &vectors, instr);
+      continue;
+    }
+
+    struct x86_operand a = operand(instr->a);
+
+    if (instr->op == IR_PRINT) {
+      select_print(program, instr->type, a);
+      continue;
+    }
+
+    struct x86_operand dst = operand(instr->dst);
+
+    switch (instr->op) {
+    case IR_COPY:
+      x86_emit_op(program, X86_MOV, a, dst);
+      break;
+
+    case IR_NEG:
+      x86_emit_op(program, X86_MOV, a, dst);
+      x86_emit_op(program, X86_NEG, X86_NONE(), dst);
+      break;
+
+    case IR_ADD: {
+      struct x86_operand b = operand(instr->b);
+      if (a.type == X86_IMM) {
+        select_binary(program, X86_ADD, dst, b, a);
+      } else {
+        select_binary(program, X86_ADD, dst, a, b);
+      }
+      break;
+    }
+
+    case IR_SUB:
+      select_binary(program, X86_SUB, dst, a, operand(instr->b));
+      break;
+
+    case IR_MUL:
+      select_mul(program, dst, a, operand(instr->b));
+      break;
+
+    case IR_DIV:
+      select_div(program, dst, a, operand(instr->b));
+      break;
+
+    default:
+      UNREACHABLE();
+    }
+  }
+
+  memory_free(vectors.lanes);
+  return program;
+}
@@ -0,0 +1,9 @@
+#ifndef isel_h
+#define isel_h
+
+#include "ir.h"
+#include "x86.h"
+
+struct x86_program *isel(struct ir_program *ir);
+
+#endif
@@ -0,0 +1,147 @@
+#include <setjmp.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include "common.h"
+#include "diagnostics.h"
+#include "encode.h"
+#include "jit.h"
+#include "output.h"
+#include "x86.h"
+
+// Layout of the mapping:
+//
+//   main       the encoded program
+//   stubs      `jmp *0(%rip)` followed by the address of a host function,
+//              one per function symbol, as the host may be more than 2 GiB
+//              away from a rel32 call
+//
+// The host functions stand in for runtime/print.s and write to the output
+// passed to jit_run rather than their own buffer.
+//
+// The mapping is written while PROT_READ | PROT_WRITE and only then made
+// PROT_READ | PROT_EXEC, so it is never writable and executable at once.
+
+#define STUB_SIZE 14
+
+// Where the host functions write, for the duration of jit_run.
+static struct output *host_output;
+static sigjmp_buf trap;
+
+static void host_print_i32(int value) { output_i32(host_output, value); }
+
+static void host_print_bool(int value) { output_bool(host_output, value); }
+
+static void host_print_flush(void) { output_flush(host_output); }
+
+// call() catches the trap itself.
+static void host_print_init(void) {}
+
+static void *host_function(enum x86_symbol symbol) {
+  switch (symbol) {
+  case SYM_PRINT_I32:
+    return (void *)host_print_i32;
+  case SYM_PRINT_BOOL:
+    return (void *)host_print_bool;
+  case SYM_PRINT_FLUSH:
+    return (void *)host_print_flush;
+  case SYM_PRINT_INIT:
+    return (void *)host_print_init;
+  default:
+    UNREACHABLE();
+    return NULL;
+  }
+}
+
+static void on_trap(int signal) {
+  (void)signal;
+  siglongjmp(trap, 1);
+}
+
+// Division by zero and INT_MIN / -1 raise SIGFPE inside the program; return
+// from it instead of taking the compiler down. Returns false if it trapped.
+static bool call(void *entry) {
+  struct sigaction action = {.sa_handler = on_trap};
+  struct sigaction previous;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGFPE, &action, &previous);
+
+  bool trapped = sigsetjmp(trap, 1) != 0;
+  if (!trapped)
+    ((int (*)(void))entry)();
+
+  sigaction(SIGFPE, &previous, NULL);
+  return !trapped;
+}
+
+static long long now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+bool jit_run(struct x86_program *program, struct output *output,
+             struct jit_stats *stats) {
+  assert(program && output && stats);
+
+  long long start = now();
+
+  struct encode_output code;
+  encode(program, &code);
+
+  size_t stubs = (code.text_size + 7) & ~(size_t)7;
+  size_t size = stubs + NUM_SYMBOLS * STUB_SIZE;
+
+  unsigned char *memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    fprintf(diagnostics_out(),
+            "[error] Could not map memory for the program.\n");
+    encode_free(&code);
+    return false;
+  }
+
+  memcpy(memory, code.text, code.text_size);
+
+  for (int i = 0; i < NUM_SYMBOLS; i++) {
+    static const unsigned char jmp[6] = {0xff, 0x25, 0, 0, 0, 0};
+    void *target = host_function(i);
+    memcpy(memory + stubs + i * STUB_SIZE, jmp, sizeof(jmp));
+    memcpy(memory + stubs + i * STUB_SIZE + sizeof(jmp), &target,
+           sizeof(target));
+  }
+
+  // Relative to the end of the 4-byte field.
+  for (int i = 0; i < code.num_relocs; i++) {
+    struct encode_reloc *reloc = &code.relocs[i];
+    int value =
+        (int)(stubs + reloc->symbol * STUB_SIZE - (reloc->offset + 4));
+    memcpy(memory + reloc->offset, &value, sizeof(value));
+  }
+
+  encode_free(&code);
+
+  if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+    fprintf(diagnostics_out(),
+            "[error] Could not make the program executable.\n");
+    munmap(memory, size);
+    return false;
+  }
+
+  long long loaded = now();
+  host_output = output;
+
+  bool trapped = !call(memory);
+  output_flush(output);
+
+  stats->load = loaded - start;
+  stats->execute = now() - loaded;
+
+  munmap(memory, size);
+
+  if (trapped)
+    fprintf(stderr, "[error] The program trapped on a division.\n");
+  return !trapped;
+}
@@ -0,0 +1,25 @@
+#ifndef jit_h
+#define jit_h
+
+#include "common.h"
+#include "output.h"
+#include "x86.h"
+
+// Time spent in jit_run, in nanoseconds.
+struct jit_stats {
+  long long load;
+  long long execute;
+};
+
+// Encodes the program into an executable mapping and calls it in-process.
+// The print runtime's functions are bound to host functions writing to the
+// output, which is flushed when the program returns. Returns false if the
+// memory cannot be mapped or the program traps.
+//
+// Part of the driver rather than libcompiler.a: the output is held in a
+// global and SIGFPE handled for the whole process while the program runs,
+// so only one program may run at a time.
+bool jit_run(struct x86_program *program, struct output *output,
+             struct jit_stats *stats);
+
+#endif
@@ -0,0 +1,227 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "common.h"
+#include "memory.h"
+
+// In front of every block, padded so that the block keeps malloc's
+// alignment, which leaves room for the links.
+union header {
+  struct {
+    size_t size;
+    enum memory_subsystem subsystem;
+
+    // In the list of its region, or both NULL.
+    struct memory_link link;
+  } block;
+  max_align_t align;
+};
+
+static const char *names[NUM_MEMORY_SUBSYSTEMS] = {
+    [MEMORY_SOURCE] = "source",     [MEMORY_SCANNER] = "scanner",
+    [MEMORY_PARSER] = "parser",     [MEMORY_AST] = "ast",
+    [MEMORY_SYMBOLS] = "symbols",   [MEMORY_PASSES] = "passes",
+    [MEMORY_IR] = "ir",             [MEMORY_ISEL] = "isel",
+    [MEMORY_X86] = "x86",           [MEMORY_REGALLOC] = "regalloc",
+    [MEMORY_ENCODE] = "encode",     [MEMORY_OBJECT] = "object",
+    [MEMORY_BYTECODE] = "bytecode", [MEMORY_VM] = "vm",
+    [MEMORY_TRACE] = "trace",       [MEMORY_BATCH] = "batch",
+    [MEMORY_CONTEXT] = "context",   [MEMORY_SERVER] = "server",
+};
+
+// Per thread, so that threads compiling at the same time neither contend
+// for the counters nor race on them.
+static _Thread_local struct memory_stats stats[NUM_MEMORY_SUBSYSTEMS];
+static _Thread_local long long live;
+static _Thread_local long long peak;
+static _Thread_local long long phase_peak;
+
+// The region new blocks go to.
+static _Thread_local struct memory_region *current;
+
+static void account(enum memory_subsystem subsystem, long long change) {
+  struct memory_stats *subsystem_stats = &stats[subsystem];
+
+  subsystem_stats->live += change;
+  if (subsystem_stats->live > subsystem_stats->peak)
+    subsystem_stats->peak = subsystem_stats->live;
+
+  live += change;
+  if (live > peak)
+    peak = live;
+  if (live > phase_peak)
+    phase_peak = live;
+}
+
+static void *block(union header *header, enum memory_subsystem subsystem,
+                   size_t size) {
+  header->block.size = size;
+  header->block.subsystem = subsystem;
+
+  stats[subsystem].calls++;
+  stats[subsystem].bytes += size;
+  account(subsystem, size);
+
+  return header + 1;
+}
+
+static void unlink_block(struct memory_link *link) {
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+}
+
+void *memory_alloc(enum memory_subsystem subsystem, size_t size) {
+  assert(0 <= subsystem && subsystem < NUM_MEMORY_SUBSYSTEMS);
+
+  if (size > (size_t)-1 - sizeof(union header))
+    return NULL;
+
+  union header *header = malloc(sizeof(*header) + size);
+  if (header == NULL)
+    return NULL;
+
+  struct memory_link *link = &header->block.link;
+  if (current) {
+    link->prev = &current->blocks;
+    link->next = current->blocks.next;
+    link->next->prev = link;
+    current->blocks.next = link;
+  } else {
+    *link = (struct memory_link){NULL, NULL};
+  }
+
+  return block(header, subsystem, size);
+}
+
+void *memory_calloc(enum memory_subsystem subsystem, size_t count,
+                    size_t size) {
+  if (size != 0 && count > ((size_t)-1 - sizeof(union header)) / size)
+    return NULL;
+
+  void *pointer = memory_alloc(subsystem, count * size);
+  if (pointer != NULL)
+    memset(pointer, 0, count * size);
+
+  return pointer;
+}
+
+void *memory_realloc(enum memory_subsystem subsystem, void *pointer,
+                     size_t size) {
+  if (pointer == NULL)
+    return memory_alloc(subsystem, size);
+  if (size > (size_t)-1 - sizeof(union header))
+    return NULL;
+
+  union header *header = (union header *)pointer - 1;
+  assert(header->block.subsystem == subsystem);
+  size_t old_size = header->block.size;
+
+  header = realloc(header, sizeof(*header) + size);
+  if (header == NULL)
+    return NULL;
+
+  // Its neighbours still point to where it was.
+  struct memory_link *link = &header->block.link;
+  if (link->next) {
+    link->prev->next = link;
+    link->next->prev = link;
+  }
+
+  account(subsystem, -(long long)old_size);
+  return block(header, subsystem, size);
+}
+
+void memory_free(void *pointer) {
+  if (pointer == NULL)
+    return;
+
+  union header *header = (union header *)pointer - 1;
+  if (header->block.link.next)
+    unlink_block(&header->block.link);
+
+  account(header->block.subsystem, -(long long)header->block.size);
+  free(header);
+}
+
+void memory_region_init(struct memory_region *region) {
+  assert(region);
+
+  region->blocks = (struct memory_link){&region->blocks, &region->blocks};
+  region->on_error = NULL;
+  region->file = NULL;
+  region->line = 0;
+}
+
+struct memory_region *memory_enter(struct memory_region *region) {
+  struct memory_region *previous = current;
+  current = region;
+  return previous;
+}
+
+void memory_region_release(struct memory_region *region) {
+  assert(region);
+
+  struct memory_link *link = region->blocks.next;
+  while (link != &region->blocks) {
+    struct memory_link *next = link->next;
+    union header *header =
+        (union header *)((char *)link - offsetof(union header, block.link));
+
+    account(header->block.subsystem, -(long long)header->block.size);
+    free(header);
+    link = next;
+  }
+
+  region->blocks = (struct memory_link){&region->blocks, &region->blocks};
+}
+
+_Noreturn void error_out(const char *file, int line) {
+  if (current && current->on_error) {
+    current->file = file;
+    current->line = line;
+    longjmp(*current->on_error, 1);
+  }
+
+  printf("Error at line %d in %s.\n", line, file);
+  exit(EXIT_FAILURE);
+}
+
+struct memory_stats memory_stats(enum memory_subsystem subsystem) {
+  assert(0 <= subsystem && subsystem < NUM_MEMORY_SUBSYSTEMS);
+
+  return stats[subsystem];
+}
+
+long long memory_live(void) { return live; }
+
+long long memory_peak(void) { return phase_peak; }
+
+void memory_reset_peak(void) { phase_peak = live; }
+
+const char *memory_subsystem_name(enum memory_subsystem subsystem) {
+  assert(0 <= subsystem && subsystem < NUM_MEMORY_SUBSYSTEMS);
+
+  return names[subsystem];
+}
+
+void memory_report(FILE *file) {
+  assert(file);
+
+  struct memory_stats total = {0, 0, live, peak};
+
+  fprintf(file, "%-14s %10s %14s %14s %14s\n", "subsystem", "calls", "bytes",
+          "peak live", "live");
+
+  for (int i = 0; i < NUM_MEMORY_SUBSYSTEMS; i++) {
+    if (stats[i].calls == 0)
+      continue;
+
+    fprintf(file, "%-14s %10lld %14lld %14lld %14lld\n", names[i],
+            stats[i].calls, stats[i].bytes, stats[i].peak, stats[i].live);
+    total.calls += stats[i].calls;
+    total.bytes += stats[i].bytes;
+  }
+
+  fprintf(file, "%-14s %10lld %14lld %14lld %14lld\n", "total", total.calls,
+          total.bytes, total.peak, total.live);
+}
@@ -0,0 +1,95 @@
+#ifndef memory_h
+#define memory_h
+
+#include <setjmp.h>
+
+#include "common.h"
+
+// Every allocation of the compiler goes through these, so that --mem-stats
+// can tell which structures the memory goes to. They behave like malloc,
+// calloc, realloc and free, returning NULL when out of memory; each block
+// remembers its size and subsystem in a header in front of it.
+//
+// The counts are those of the calling thread: a block freed by another
+// thread than the one that allocated it counts against the freeing one.
+
+enum memory_subsystem {
+  MEMORY_SOURCE,
+  MEMORY_SCANNER,
+  MEMORY_PARSER,
+  MEMORY_AST,
+  MEMORY_SYMBOLS,
+  MEMORY_PASSES,
+  MEMORY_IR,
+  MEMORY_ISEL,
+  MEMORY_X86,
+  MEMORY_REGALLOC,
+  MEMORY_ENCODE,
+  MEMORY_OBJECT,
+  MEMORY_BYTECODE,
+  MEMORY_VM,
+  MEMORY_TRACE,
+  MEMORY_BATCH,
+  MEMORY_CONTEXT,
+  MEMORY_SERVER,
+  NUM_MEMORY_SUBSYSTEMS,
+};
+
+struct memory_stats {
+  // Calls that allocated or resized, and the bytes they asked for.
+  long long calls;
+  long long bytes;
+
+  // Bytes allocated and not yet freed, and the most there ever were.
+  long long live;
+  long long peak;
+};
+
+struct memory_link {
+  struct memory_link *prev;
+  struct memory_link *next;
+};
+
+// Owns every block allocated on a thread while it is entered, so that a
+// compile that stops halfway can still release all it allocated; a block
+// leaves its region when it is freed. While on_error is set, ERROR_OUT()
+// jumps there instead of ending the process, with file and line set to
+// where it was called.
+struct memory_region {
+  struct memory_link blocks;
+  jmp_buf *on_error;
+  const char *file;
+  int line;
+};
+
+// Each returns NULL if the C library's allocator does, or if the size with
+// the block's header does not fit in a size_t.
+void *memory_alloc(enum memory_subsystem subsystem, size_t size);
+void *memory_calloc(enum memory_subsystem subsystem, size_t count,
+                    size_t size);
+void *memory_realloc(enum memory_subsystem subsystem, void *pointer,
+                     size_t size);
+void memory_free(void *pointer);
+
+struct memory_stats memory_stats(enum memory_subsystem subsystem);
+
+// Over all subsystems. The peak is since the last memory_reset_peak.
+long long memory_live(void);
+long long memory_peak(void);
+void memory_reset_peak(void);
+
+void memory_region_init(struct memory_region *region);
+
+// Makes region the owner of the calling thread's allocations from now on,
+// or none if it is NULL. Returns the one before.
+struct memory_region *memory_enter(struct memory_region *region);
+
+// Frees every block still in the region.
+void memory_region_release(struct memory_region *region);
+
+const char *memory_subsystem_name(enum memory_subsystem subsystem);
+
+// A table of every subsystem that allocated.
+void memory_report(FILE *file);
+
+#endif
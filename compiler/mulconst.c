@@ -0,0 +1,54 @@
+#include "mulconst.h"
+#include "common.h"
+#include "mulconst_table.h"
+
+const struct mulconst_entry *mulconst_lookup(int constant) {
+  int lo = 0;
+  int hi = (int)(sizeof(mulconst_table) / sizeof(mulconst_table[0])) - 1;
+
+  while (lo <= hi) {
+    int mid = lo + (hi - lo) / 2;
+
+    if (mulconst_table[mid].constant == constant)
+      return &mulconst_table[mid];
+
+    if (mulconst_table[mid].constant < constant) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  return NULL;
+}
+
+// Arithmetic is done on unsigned values so it wraps like the emitted code.
+int mulconst_eval(const struct mulconst_entry *entry, int x) {
+  assert(entry);
+
+  unsigned int values[MULCONST_MAX_OPS + 1];
+  values[0] = (unsigned int)x;
+
+  for (int i = 0; i < entry->num_ops; i++) {
+    const struct mulconst_op *op = &entry->ops[i];
+
+    switch (op->kind) {
+    case MULCONST_SHL:
+      values[i + 1] = values[op->a] << op->imm;
+      break;
+    case MULCONST_ADD:
+      values[i + 1] = values[op->a] + values[op->b];
+      break;
+    case MULCONST_SUB:
+      values[i + 1] = values[op->a] - values[op->b];
+      break;
+    case MULCONST_LEA:
+      values[i + 1] = values[op->a] + values[op->b] * (unsigned int)op->imm;
+      break;
+    default:
+      UNREACHABLE();
+    }
+  }
+
+  return (int)values[entry->num_ops];
+}
@@ -0,0 +1,34 @@
+#ifndef mulconst_h
+#define mulconst_h
+
+#include "common.h"
+
+#define MULCONST_MAX_OPS 4
+
+enum mulconst_op_kind {
+  MULCONST_SHL, // v = a << imm
+  MULCONST_ADD, // v = a + b
+  MULCONST_SUB, // v = a - b
+  MULCONST_LEA, // v = a + b * imm, imm in {1, 2, 4, 8}
+};
+
+// Operands index the values of the sequence: 0 is the multiplicand and k is
+// the result of ops[k - 1]. The product is the last value.
+struct mulconst_op {
+  enum mulconst_op_kind kind;
+  int a;
+  int b;
+  int imm;
+};
+
+struct mulconst_entry {
+  int constant;
+  int latency;
+  int num_ops;
+  struct mulconst_op ops[MULCONST_MAX_OPS];
+};
+
+const struct mulconst_entry *mulconst_lookup(int constant);
+int mulconst_eval(const struct mulconst_entry *entry, int x);
+
+#endif
@@ -0,0 +1,232 @@
+// Generated by tools/superopt.c - do not edit.
+// superopt --min -128 --max 1024 --max-latency 2 --max-insns 3
+#ifndef mulconst_table_h
+#define mulconst_table_h
+
+#include "mulconst.h"
+
+static const struct mulconst_entry mulconst_table[] = {
+    {-128, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_SHL, 0, 0, 8}, {MULCONST_SUB, 1, 2, 0}}},
+    {-127, 2, 2, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 0, 1, 0}}},
+    {-126, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 1, 2, 0}}},
+    {-125, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_SUB, 2, 1, 0}}},
+    {-124, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 1, 2, 0}}},
+    {-123, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_SUB, 2, 1, 0}}},
+    {-120, 2, 3, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 1, 2, 0}}},
+    {-119, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 2, 1, 0}}},
+    {-112, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 1, 2, 0}}},
+    {-96, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 1, 2, 0}}},
+    {-64, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 1, 2, 0}}},
+    {-63, 2, 2, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_SUB, 0, 1, 0}}},
+    {-62, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 6}, {MULCONST_SUB, 1, 2, 0}}},
+    {-61, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_SUB, 2, 1, 0}}},
+    {-60, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SHL, 0, 0, 6}, {MULCONST_SUB, 1, 2, 0}}},
+    {-59, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_SUB, 2, 1, 0}}},
+    {-56, 2, 3, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_SHL, 0, 0, 6}, {MULCONST_SUB, 1, 2, 0}}},
+    {-55, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 2, 1, 0}}},
+    {-48, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_SHL, 0, 0, 6}, {MULCONST_SUB, 1, 2, 0}}},
+    {-32, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_SHL, 0, 0, 6}, {MULCONST_SUB, 1, 2, 0}}},
+    {-31, 2, 2, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_SUB, 0, 1, 0}}},
+    {-30, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 5}, {MULCONST_SUB, 1, 2, 0}}},
+    {-29, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_SUB, 2, 1, 0}}},
+    {-28, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SHL, 0, 0, 5}, {MULCONST_SUB, 1, 2, 0}}},
+    {-27, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_SUB, 2, 1, 0}}},
+    {-24, 2, 3, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_SHL, 0, 0, 5}, {MULCONST_SUB, 1, 2, 0}}},
+    {-23, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 2, 1, 0}}},
+    {-16, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_SHL, 0, 0, 5}, {MULCONST_SUB, 1, 2, 0}}},
+    {-15, 2, 2, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_SUB, 0, 1, 0}}},
+    {-14, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 4}, {MULCONST_SUB, 1, 2, 0}}},
+    {-13, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_SUB, 2, 1, 0}}},
+    {-12, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SHL, 0, 0, 4}, {MULCONST_SUB, 1, 2, 0}}},
+    {-11, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_SUB, 2, 1, 0}}},
+    {-9, 2, 3, {{MULCONST_SUB, 0, 0, 0}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 1, 2, 0}}},
+    {-8, 2, 2, {{MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 0, 1, 0}}},
+    {-7, 2, 2, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_SUB, 0, 1, 0}}},
+    {-6, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 3}, {MULCONST_SUB, 1, 2, 0}}},
+    {-5, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 1, 2, 0}}},
+    {-4, 2, 2, {{MULCONST_LEA, 0, 0, 4}, {MULCONST_SUB, 0, 1, 0}}},
+    {-3, 2, 2, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SUB, 0, 1, 0}}},
+    {-2, 2, 2, {{MULCONST_LEA, 0, 0, 2}, {MULCONST_SUB, 0, 1, 0}}},
+    {-1, 2, 2, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SUB, 0, 1, 0}}},
+    {0, 1, 1, {{MULCONST_SUB, 0, 0, 0}}},
+    {2, 1, 1, {{MULCONST_SHL, 0, 0, 1}}},
+    {3, 1, 1, {{MULCONST_LEA, 0, 0, 2}}},
+    {4, 1, 1, {{MULCONST_SHL, 0, 0, 2}}},
+    {5, 1, 1, {{MULCONST_LEA, 0, 0, 4}}},
+    {6, 2, 2, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_LEA, 1, 0, 4}}},
+    {7, 2, 2, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_SUB, 1, 0, 0}}},
+    {8, 1, 1, {{MULCONST_SHL, 0, 0, 3}}},
+    {9, 1, 1, {{MULCONST_LEA, 0, 0, 8}}},
+    {10, 2, 2, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_LEA, 1, 0, 8}}},
+    {11, 2, 2, {{MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 0, 8}}},
+    {12, 2, 2, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_LEA, 1, 0, 8}}},
+    {13, 2, 2, {{MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 0, 1, 4}}},
+    {14, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 4}, {MULCONST_SUB, 2, 1, 0}}},
+    {15, 2, 2, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_SUB, 1, 0, 0}}},
+    {16, 1, 1, {{MULCONST_SHL, 0, 0, 4}}},
+    {17, 2, 2, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_LEA, 0, 1, 8}}},
+    {18, 2, 2, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_LEA, 1, 1, 8}}},
+    {19, 2, 2, {{MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 0, 1, 2}}},
+    {20, 2, 2, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_LEA, 1, 1, 4}}},
+    {21, 2, 2, {{MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 0, 1, 4}}},
+    {22, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 4}}},
+    {23, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 1, 2, 0}}},
+    {24, 2, 2, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_LEA, 1, 1, 2}}},
+    {25, 2, 2, {{MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 0, 1, 8}}},
+    {26, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 2, 8}}},
+    {27, 2, 2, {{MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 1, 8}}},
+    {28, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SHL, 0, 0, 5}, {MULCONST_SUB, 2, 1, 0}}},
+    {29, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_SUB, 1, 2, 0}}},
+    {30, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 5}, {MULCONST_SUB, 2, 1, 0}}},
+    {31, 2, 2, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_SUB, 1, 0, 0}}},
+    {32, 1, 1, {{MULCONST_SHL, 0, 0, 5}}},
+    {33, 2, 2, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_LEA, 0, 1, 8}}},
+    {34, 2, 2, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 1, 0, 2}}},
+    {35, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 2, 1, 8}}},
+    {36, 2, 2, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_LEA, 1, 1, 8}}},
+    {37, 2, 2, {{MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 0, 1, 4}}},
+    {38, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 4}}},
+    {39, 2, 3, {{MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 4}}},
+    {40, 2, 2, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_LEA, 1, 1, 4}}},
+    {41, 2, 2, {{MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 0, 1, 8}}},
+    {42, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 8}}},
+    {43, 2, 3, {{MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 8}}},
+    {44, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 8}}},
+    {45, 2, 2, {{MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 1, 8}}},
+    {48, 2, 2, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_LEA, 1, 1, 2}}},
+    {49, 2, 3, {{MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 2, 1, 8}}},
+    {50, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 2}}},
+    {52, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 4}}},
+    {55, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 1, 2, 0}}},
+    {56, 2, 3, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_SHL, 0, 0, 6}, {MULCONST_SUB, 2, 1, 0}}},
+    {59, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_SUB, 1, 2, 0}}},
+    {60, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SHL, 0, 0, 6}, {MULCONST_SUB, 2, 1, 0}}},
+    {61, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_SUB, 1, 2, 0}}},
+    {62, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 6}, {MULCONST_SUB, 2, 1, 0}}},
+    {63, 2, 2, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_SUB, 1, 0, 0}}},
+    {64, 1, 1, {{MULCONST_SHL, 0, 0, 6}}},
+    {65, 2, 2, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_LEA, 0, 1, 8}}},
+    {66, 2, 2, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 1, 0, 2}}},
+    {67, 2, 3, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 2, 1, 8}}},
+    {68, 2, 2, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 1, 0, 4}}},
+    {69, 2, 3, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 2, 1, 8}}},
+    {70, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 2, 2}}},
+    {72, 2, 2, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_LEA, 1, 1, 8}}},
+    {73, 2, 2, {{MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 0, 1, 8}}},
+    {74, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 8}}},
+    {75, 2, 3, {{MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 8}}},
+    {76, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 8}}},
+    {77, 2, 3, {{MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 8}}},
+    {80, 2, 2, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_LEA, 1, 1, 4}}},
+    {81, 2, 2, {{MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 1, 8}}},
+    {82, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 2}}},
+    {84, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 4}}},
+    {88, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 8}}},
+    {96, 2, 2, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 1, 1, 2}}},
+    {100, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 4}}},
+    {104, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 8}}},
+    {112, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 2, 1, 0}}},
+    {119, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 1, 2, 0}}},
+    {120, 2, 3, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 2, 1, 0}}},
+    {123, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_SUB, 1, 2, 0}}},
+    {124, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 2, 1, 0}}},
+    {125, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_SUB, 1, 2, 0}}},
+    {126, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 2, 1, 0}}},
+    {127, 2, 2, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_SUB, 1, 0, 0}}},
+    {128, 1, 1, {{MULCONST_SHL, 0, 0, 7}}},
+    {129, 2, 2, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_LEA, 0, 1, 8}}},
+    {130, 2, 2, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 1, 0, 2}}},
+    {131, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 2, 1, 8}}},
+    {132, 2, 2, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 1, 0, 4}}},
+    {133, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 2, 1, 8}}},
+    {134, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 2, 2}}},
+    {136, 2, 2, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 1, 0, 8}}},
+    {137, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 2, 1, 8}}},
+    {138, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 2}}},
+    {140, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 2, 4}}},
+    {144, 2, 2, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_LEA, 1, 1, 8}}},
+    {146, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 2}}},
+    {148, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 4}}},
+    {152, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 2, 8}}},
+    {160, 2, 2, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 1, 1, 4}}},
+    {164, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 4}}},
+    {168, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 8}}},
+    {192, 2, 2, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 1, 1, 2}}},
+    {200, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 8}}},
+    {224, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_SHL, 0, 0, 8}, {MULCONST_SUB, 2, 1, 0}}},
+    {240, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_SHL, 0, 0, 8}, {MULCONST_SUB, 2, 1, 0}}},
+    {247, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 1, 2, 0}}},
+    {248, 2, 3, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_SHL, 0, 0, 8}, {MULCONST_SUB, 2, 1, 0}}},
+    {251, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_SUB, 1, 2, 0}}},
+    {252, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SHL, 0, 0, 8}, {MULCONST_SUB, 2, 1, 0}}},
+    {253, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_SUB, 1, 2, 0}}},
+    {254, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 8}, {MULCONST_SUB, 2, 1, 0}}},
+    {255, 2, 2, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_SUB, 1, 0, 0}}},
+    {256, 1, 1, {{MULCONST_SHL, 0, 0, 8}}},
+    {257, 2, 2, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 0, 1, 8}}},
+    {258, 2, 2, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 1, 0, 2}}},
+    {259, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 2, 1, 8}}},
+    {260, 2, 2, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 1, 0, 4}}},
+    {261, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 2, 1, 8}}},
+    {262, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 2, 2}}},
+    {264, 2, 2, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 1, 0, 8}}},
+    {265, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 2, 1, 8}}},
+    {266, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 2}}},
+    {268, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 2, 4}}},
+    {272, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 2, 1, 8}}},
+    {274, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 2}}},
+    {276, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 4}}},
+    {280, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 2, 8}}},
+    {288, 2, 2, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_LEA, 1, 1, 8}}},
+    {292, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 4}}},
+    {296, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 8}}},
+    {320, 2, 2, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 1, 1, 4}}},
+    {328, 2, 3, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 8}}},
+    {384, 2, 2, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 1, 1, 2}}},
+    {448, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_SHL, 0, 0, 9}, {MULCONST_SUB, 2, 1, 0}}},
+    {480, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_SHL, 0, 0, 9}, {MULCONST_SUB, 2, 1, 0}}},
+    {496, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_SHL, 0, 0, 9}, {MULCONST_SUB, 2, 1, 0}}},
+    {503, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 1, 2, 0}}},
+    {504, 2, 3, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_SHL, 0, 0, 9}, {MULCONST_SUB, 2, 1, 0}}},
+    {507, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_SUB, 1, 2, 0}}},
+    {508, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SHL, 0, 0, 9}, {MULCONST_SUB, 2, 1, 0}}},
+    {509, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_SUB, 1, 2, 0}}},
+    {510, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 9}, {MULCONST_SUB, 2, 1, 0}}},
+    {511, 2, 2, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_SUB, 1, 0, 0}}},
+    {512, 1, 1, {{MULCONST_SHL, 0, 0, 9}}},
+    {513, 2, 2, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 1, 8}}},
+    {514, 2, 2, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 1, 0, 2}}},
+    {515, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 2, 1, 8}}},
+    {516, 2, 2, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 1, 0, 4}}},
+    {517, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 2, 1, 8}}},
+    {518, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 2, 2}}},
+    {520, 2, 2, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 1, 0, 8}}},
+    {521, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 2, 1, 8}}},
+    {522, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 2}}},
+    {524, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 2, 4}}},
+    {528, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 2, 1, 8}}},
+    {530, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 2}}},
+    {532, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 4}}},
+    {536, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_LEA, 1, 2, 8}}},
+    {544, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 2, 1, 8}}},
+    {548, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 4}}},
+    {552, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_LEA, 1, 2, 8}}},
+    {576, 2, 2, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_LEA, 1, 1, 8}}},
+    {584, 2, 3, {{MULCONST_SHL, 0, 0, 9}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_LEA, 1, 2, 8}}},
+    {640, 2, 2, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_LEA, 1, 1, 4}}},
+    {768, 2, 2, {{MULCONST_SHL, 0, 0, 8}, {MULCONST_LEA, 1, 1, 2}}},
+    {896, 2, 3, {{MULCONST_SHL, 0, 0, 7}, {MULCONST_SHL, 0, 0, 10}, {MULCONST_SUB, 2, 1, 0}}},
+    {960, 2, 3, {{MULCONST_SHL, 0, 0, 6}, {MULCONST_SHL, 0, 0, 10}, {MULCONST_SUB, 2, 1, 0}}},
+    {992, 2, 3, {{MULCONST_SHL, 0, 0, 5}, {MULCONST_SHL, 0, 0, 10}, {MULCONST_SUB, 2, 1, 0}}},
+    {1008, 2, 3, {{MULCONST_SHL, 0, 0, 4}, {MULCONST_SHL, 0, 0, 10}, {MULCONST_SUB, 2, 1, 0}}},
+    {1015, 2, 3, {{MULCONST_SHL, 0, 0, 10}, {MULCONST_LEA, 0, 0, 8}, {MULCONST_SUB, 1, 2, 0}}},
+    {1016, 2, 3, {{MULCONST_SHL, 0, 0, 3}, {MULCONST_SHL, 0, 0, 10}, {MULCONST_SUB, 2, 1, 0}}},
+    {1019, 2, 3, {{MULCONST_SHL, 0, 0, 10}, {MULCONST_LEA, 0, 0, 4}, {MULCONST_SUB, 1, 2, 0}}},
+    {1020, 2, 3, {{MULCONST_SHL, 0, 0, 2}, {MULCONST_SHL, 0, 0, 10}, {MULCONST_SUB, 2, 1, 0}}},
+    {1021, 2, 3, {{MULCONST_SHL, 0, 0, 10}, {MULCONST_LEA, 0, 0, 2}, {MULCONST_SUB, 1, 2, 0}}},
+    {1022, 2, 3, {{MULCONST_SHL, 0, 0, 1}, {MULCONST_SHL, 0, 0, 10}, {MULCONST_SUB, 2, 1, 0}}},
+    {1023, 2, 2, {{MULCONST_SHL, 0, 0, 10}, {MULCONST_SUB, 1, 0, 0}}},
+    {1024, 1, 1, {{MULCONST_SHL, 0, 0, 10}}},
+};
+
+#endif
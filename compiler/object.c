@@ -0,0 +1,423 @@
+#include <elf.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "diagnostics.h"
+#include "encode.h"
+#include "memory.h"
+#include "object.h"
+#include "runtime_code.h"
+#include "x86.h"
+
+// Layout of an object, in file order:
+//
+//   ELF header
+//   .text        machine code of main, then the print runtime
+//                (runtime/print.s) 16-byte aligned
+//   .bss         the runtime's output buffer, no file contents
+//   .rela.text   the runtime's references to .bss
+//   .symtab      null, section symbols of .text and .bss, the runtime's
+//                functions, then main
+//   .strtab
+//   .shstrtab
+//   section headers
+//
+// The calls from main into the runtime are resolved here, as `as` does for
+// local labels in the same section, so the object links on its own.
+
+enum section {
+  SECTION_NULL,
+  SECTION_TEXT,
+  SECTION_BSS,
+  SECTION_RELA_TEXT,
+  SECTION_NOTE_GNU_STACK,
+  SECTION_SYMTAB,
+  SECTION_STRTAB,
+  SECTION_SHSTRTAB,
+  NUM_SECTIONS
+};
+
+static const char *section_names[NUM_SECTIONS] = {
+    "",        ".text",   ".bss",     ".rela.text", ".note.GNU-stack",
+    ".symtab", ".strtab", ".shstrtab"};
+
+// Symbol table indices; the runtime's functions follow SYMBOL_BSS in
+// x86_symbol order.
+enum {
+  SYMBOL_NULL,
+  SYMBOL_TEXT,
+  SYMBOL_BSS,
+  SYMBOL_MAIN = SYMBOL_BSS + 1 + NUM_SYMBOLS,
+  NUM_OBJECT_SYMBOLS
+};
+
+struct buffer {
+  unsigned char *data;
+  size_t size;
+  size_t capacity;
+};
+
+static size_t append(struct buffer *buffer, const void *data, size_t size) {
+  if (buffer->size + size > buffer->capacity) {
+    while (buffer->size + size > buffer->capacity)
+      buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 1024;
+
+    buffer->data =
+        memory_realloc(MEMORY_OBJECT, buffer->data, buffer->capacity);
+    if (buffer->data == NULL)
+      ERROR_OUT();
+  }
+
+  size_t offset = buffer->size;
+  if (size > 0)
+    memcpy(buffer->data + offset, data, size);
+  buffer->size += size;
+  return offset;
+}
+
+static size_t append_string(struct buffer *buffer, const char *string) {
+  return append(buffer, string, strlen(string) + 1);
+}
+
+static void align(struct buffer *buffer, size_t alignment) {
+  static const unsigned char zeros[16] = {0};
+  append(buffer, zeros, (alignment - buffer->size % alignment) % alignment);
+}
+
+// Pads code with int3, as `.p2align 4, 0xcc` in runtime/print.s.
+static void align_code(struct buffer *buffer) {
+  static const unsigned char int3[16] = {0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc,
+                                         0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc,
+                                         0xcc, 0xcc, 0xcc, 0xcc};
+  append(buffer, int3, (16 - buffer->size % 16) % 16);
+}
+
+static int runtime_function(enum x86_symbol symbol) {
+  switch (symbol) {
+  case SYM_PRINT_I32:
+    return RUNTIME_PRINT_I32;
+  case SYM_PRINT_BOOL:
+    return RUNTIME_PRINT_BOOL;
+  case SYM_PRINT_FLUSH:
+    return RUNTIME_PRINT_FLUSH;
+  case SYM_PRINT_INIT:
+    return RUNTIME_PRINT_INIT;
+  default:
+    UNREACHABLE();
+    return 0;
+  }
+}
+
+// Points the calls of the code at `main` in `buffer` to the runtime at
+// `runtime`, relative to the end of their 4-byte fields.
+static void link_calls(struct buffer *buffer, struct encode_output *code,
+                       size_t main, size_t runtime) {
+  for (int i = 0; i < code->num_relocs; i++) {
+    struct encode_reloc *reloc = &code->relocs[i];
+    long long target = runtime + runtime_function(reloc->symbol);
+    int value = (int)(target - (long long)(main + reloc->offset + 4));
+    memcpy(buffer->data + main + reloc->offset, &value, sizeof(value));
+  }
+}
+
+static bool write_file(const char *path, struct buffer *file, int mode) {
+  bool ok = false;
+
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+  if (fd >= 0) {
+    ok = write(fd, file->data, file->size) == (ssize_t)file->size;
+    ok = close(fd) == 0 && ok;
+  }
+
+  if (!ok)
+    fprintf(diagnostics_out(), "[error] Could not write '%s'.\n", path);
+  return ok;
+}
+
+// The relocatable object, in a buffer the caller frees.
+static struct buffer build_object(struct x86_program *program) {
+  struct encode_output code;
+  encode(program, &code);
+
+  struct buffer text = {0};
+  append(&text, code.text, code.text_size);
+  align_code(&text);
+  size_t runtime =
+      append(&text, runtime_print_code, sizeof(runtime_print_code));
+  link_calls(&text, &code, 0, runtime);
+
+  struct buffer strtab = {0};
+  append_string(&strtab, "");
+
+  Elf64_Sym symbols[NUM_OBJECT_SYMBOLS];
+  symbols[SYMBOL_NULL] = (Elf64_Sym){0};
+  symbols[SYMBOL_TEXT] = (Elf64_Sym){
+      .st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION),
+      .st_shndx = SECTION_TEXT,
+  };
+  symbols[SYMBOL_BSS] = (Elf64_Sym){
+      .st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION),
+      .st_shndx = SECTION_BSS,
+  };
+  for (int i = 0; i < NUM_SYMBOLS; i++) {
+    symbols[SYMBOL_BSS + 1 + i] = (Elf64_Sym){
+        .st_name = append_string(&strtab, x86_symbol_name(i)),
+        .st_info = ELF64_ST_INFO(STB_LOCAL, STT_NOTYPE),
+        .st_shndx = SECTION_TEXT,
+        .st_value = runtime + runtime_function(i),
+    };
+  }
+  symbols[SYMBOL_MAIN] = (Elf64_Sym){
+      .st_name = append_string(&strtab, "main"),
+      .st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC),
+      .st_shndx = SECTION_TEXT,
+      .st_size = code.text_size,
+  };
+
+  struct buffer shstrtab = {0};
+  size_t section_name_offsets[NUM_SECTIONS];
+  for (int i = 0; i < NUM_SECTIONS; i++)
+    section_name_offsets[i] = append_string(&shstrtab, section_names[i]);
+
+  // The file itself.
+  struct buffer file = {0};
+  Elf64_Shdr sections[NUM_SECTIONS] = {{0}};
+
+  Elf64_Ehdr header = {0};
+  append(&file, &header, sizeof(header));
+
+  align(&file, 16);
+  sections[SECTION_TEXT] = (Elf64_Shdr){
+      .sh_type = SHT_PROGBITS,
+      .sh_flags = SHF_ALLOC | SHF_EXECINSTR,
+      .sh_offset = append(&file, text.data, text.size),
+      .sh_size = text.size,
+      .sh_addralign = 16,
+  };
+
+  sections[SECTION_BSS] = (Elf64_Shdr){
+      .sh_type = SHT_NOBITS,
+      .sh_flags = SHF_ALLOC | SHF_WRITE,
+      .sh_offset = file.size,
+      .sh_size = RUNTIME_PRINT_BSS_SIZE,
+      .sh_addralign = 16,
+  };
+
+  int num_relocs = sizeof(runtime_print_relocs) / sizeof(*runtime_print_relocs);
+  align(&file, 8);
+  sections[SECTION_RELA_TEXT] = (Elf64_Shdr){
+      .sh_type = SHT_RELA,
+      .sh_flags = SHF_INFO_LINK,
+      .sh_offset = file.size,
+      .sh_size = num_relocs * sizeof(Elf64_Rela),
+      .sh_link = SECTION_SYMTAB,
+      .sh_info = SECTION_TEXT,
+      .sh_addralign = 8,
+      .sh_entsize = sizeof(Elf64_Rela),
+  };
+
+  for (int i = 0; i < num_relocs; i++) {
+    Elf64_Rela rela = {
+        .r_offset = runtime + runtime_print_relocs[i].offset,
+        .r_info = ELF64_R_INFO(SYMBOL_BSS, R_X86_64_PC32),
+        .r_addend = runtime_print_relocs[i].addend,
+    };
+    append(&file, &rela, sizeof(rela));
+  }
+
+  sections[SECTION_NOTE_GNU_STACK] = (Elf64_Shdr){
+      .sh_type = SHT_PROGBITS,
+      .sh_offset = file.size,
+      .sh_addralign = 1,
+  };
+
+  sections[SECTION_SYMTAB] = (Elf64_Shdr){
+      .sh_type = SHT_SYMTAB,
+      .sh_offset = append(&file, symbols, sizeof(symbols)),
+      .sh_size = sizeof(symbols),
+      .sh_link = SECTION_STRTAB,
+      .sh_info = SYMBOL_MAIN, // first global
+      .sh_addralign = 8,
+      .sh_entsize = sizeof(Elf64_Sym),
+  };
+
+  sections[SECTION_STRTAB] = (Elf64_Shdr){
+      .sh_type = SHT_STRTAB,
+      .sh_offset = append(&file, strtab.data, strtab.size),
+      .sh_size = strtab.size,
+      .sh_addralign = 1,
+  };
+
+  sections[SECTION_SHSTRTAB] = (Elf64_Shdr){
+      .sh_type = SHT_STRTAB,
+      .sh_offset = append(&file, shstrtab.data, shstrtab.size),
+      .sh_size = shstrtab.size,
+      .sh_addralign = 1,
+  };
+
+  for (int i = 0; i < NUM_SECTIONS; i++)
+    sections[i].sh_name = section_name_offsets[i];
+
+  align(&file, 8);
+  size_t section_headers =
+      append(&file, sections, NUM_SECTIONS * sizeof(Elf64_Shdr));
+
+  header = (Elf64_Ehdr){
+      .e_ident = {ELFMAG0, ELFMAG1, ELFMAG2, ELFMAG3, ELFCLASS64, ELFDATA2LSB,
+                  EV_CURRENT, ELFOSABI_SYSV},
+      .e_type = ET_REL,
+      .e_machine = EM_X86_64,
+      .e_version = EV_CURRENT,
+      .e_shoff = section_headers,
+      .e_ehsize = sizeof(Elf64_Ehdr),
+      .e_shentsize = sizeof(Elf64_Shdr),
+      .e_shnum = NUM_SECTIONS,
+      .e_shstrndx = SECTION_SHSTRTAB,
+  };
+  memcpy(file.data, &header, sizeof(header));
+
+  memory_free(shstrtab.data);
+  memory_free(strtab.data);
+  memory_free(text.data);
+  encode_free(&code);
+
+  return file;
+}
+
+// Writes the buffer the file was built in and frees it.
+static bool emit(struct buffer *file, FILE *stream) {
+  bool ok = fwrite(file->data, 1, file->size, stream) == file->size;
+  memory_free(file->data);
+  return ok;
+}
+
+bool object_write(struct x86_program *program, const char *path) {
+  assert(program && path);
+
+  struct buffer file = build_object(program);
+  bool ok = write_file(path, &file, 0666);
+  memory_free(file.data);
+  return ok;
+}
+
+bool object_emit(struct x86_program *program, FILE *stream) {
+  assert(program && stream);
+
+  struct buffer file = build_object(program);
+  return emit(&file, stream);
+}
+
+// Layout of a freestanding executable, loaded at EXECUTABLE_BASE:
+//
+//   ELF header, program headers
+//   runtime/start.s   _start
+//   main              at the `main` label that ends runtime/start.s
+//   runtime/print.s   16-byte aligned
+//
+// all in one read-only executable segment, plus a zero-filled writable one
+// on the next page for the print runtime's .bss. Relocations are resolved
+// here, so the executable has none.
+
+#define EXECUTABLE_BASE 0x400000
+#define PAGE_SIZE 0x1000
+
+enum segment { SEGMENT_CODE, SEGMENT_BSS, SEGMENT_STACK, NUM_SEGMENTS };
+
+_Static_assert(RUNTIME_MAIN == sizeof(runtime_start_code),
+               "main must directly follow the runtime");
+
+// The executable, in a buffer the caller frees.
+static struct buffer build_executable(struct x86_program *program) {
+  struct encode_output code;
+  encode(program, &code);
+
+  struct buffer file = {0};
+  Elf64_Ehdr header = {0};
+  Elf64_Phdr segments[NUM_SEGMENTS] = {{0}};
+
+  append(&file, &header, sizeof(header));
+  size_t segments_offset = append(&file, segments, sizeof(segments));
+
+  align(&file, 16);
+  size_t start = append(&file, runtime_start_code, sizeof(runtime_start_code));
+  size_t main = append(&file, code.text, code.text_size);
+  align_code(&file);
+  size_t runtime =
+      append(&file, runtime_print_code, sizeof(runtime_print_code));
+  link_calls(&file, &code, main, runtime);
+
+  // File offsets and addresses differ by EXECUTABLE_BASE in both segments.
+  size_t bss = (file.size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+  int num_relocs = sizeof(runtime_print_relocs) / sizeof(*runtime_print_relocs);
+  for (int i = 0; i < num_relocs; i++) {
+    size_t field = runtime + runtime_print_relocs[i].offset;
+    int value = (int)((long long)bss + runtime_print_relocs[i].addend -
+                      (long long)field);
+    memcpy(file.data + field, &value, sizeof(value));
+  }
+
+  segments[SEGMENT_CODE] = (Elf64_Phdr){
+      .p_type = PT_LOAD,
+      .p_flags = PF_R | PF_X,
+      .p_offset = 0,
+      .p_vaddr = EXECUTABLE_BASE,
+      .p_paddr = EXECUTABLE_BASE,
+      .p_filesz = file.size,
+      .p_memsz = file.size,
+      .p_align = PAGE_SIZE,
+  };
+
+  segments[SEGMENT_BSS] = (Elf64_Phdr){
+      .p_type = PT_LOAD,
+      .p_flags = PF_R | PF_W,
+      .p_offset = 0,
+      .p_vaddr = EXECUTABLE_BASE + bss,
+      .p_paddr = EXECUTABLE_BASE + bss,
+      .p_filesz = 0,
+      .p_memsz = RUNTIME_PRINT_BSS_SIZE,
+      .p_align = PAGE_SIZE,
+  };
+
+  segments[SEGMENT_STACK] = (Elf64_Phdr){
+      .p_type = PT_GNU_STACK,
+      .p_flags = PF_R | PF_W,
+      .p_align = 16,
+  };
+
+  header = (Elf64_Ehdr){
+      .e_ident = {ELFMAG0, ELFMAG1, ELFMAG2, ELFMAG3, ELFCLASS64, ELFDATA2LSB,
+                  EV_CURRENT, ELFOSABI_SYSV},
+      .e_type = ET_EXEC,
+      .e_machine = EM_X86_64,
+      .e_version = EV_CURRENT,
+      .e_entry = EXECUTABLE_BASE + start + RUNTIME_START,
+      .e_phoff = segments_offset,
+      .e_ehsize = sizeof(Elf64_Ehdr),
+      .e_phentsize = sizeof(Elf64_Phdr),
+      .e_phnum = NUM_SEGMENTS,
+  };
+  memcpy(file.data, &header, sizeof(header));
+  memcpy(file.data + segments_offset, segments, sizeof(segments));
+
+  encode_free(&code);
+
+  return file;
+}
+
+bool object_write_executable(struct x86_program *program, const char *path) {
+  assert(program && path);
+
+  struct buffer file = build_executable(program);
+  bool ok = write_file(path, &file, 0777);
+  memory_free(file.data);
+  return ok;
+}
+
+bool object_emit_executable(struct x86_program *program, FILE *stream) {
+  assert(program && stream);
+
+  struct buffer file = build_executable(program);
+  return emit(&file, stream);
+}
@@ -0,0 +1,21 @@
+#ifndef object_h
+#define object_h
+
+#include "common.h"
+#include "x86.h"
+
+// Encodes a program whose frame has been laid out and writes it as a
+// relocatable ELF64 object defining main, followed by the print runtime: the
+// object `as` would produce from x86_emit()'s output.
+bool object_write(struct x86_program *program, const char *path);
+
+// Writes a static executable that needs no C library: runtime/start.s
+// provides _start, which calls main and exits, and runtime/print.s the
+// output as in an object.
+bool object_write_executable(struct x86_program *program, const char *path);
+
+// The same, written to a stream. Return false if it cannot be written.
+bool object_emit(struct x86_program *program, FILE *stream);
+bool object_emit_executable(struct x86_program *program, FILE *stream);
+
+#endif
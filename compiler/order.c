@@ -0,0 +1,142 @@
+#include "order.h"
+#include "ast.h"
+#include "common.h"
+#include "divconst.h"
+
+// A leaf needs no register of its own: literals become immediates and
+// variables already live in one. A binary expression whose operands need l
+// and r registers needs max(l, r) if they differ, evaluating the heavier one
+// first, and l + 1 otherwise.
+//
+// Division by anything but a power of two pins %eax and %edx, so nothing
+// evaluated before it can stay in them. It is labelled as needing at least
+// three registers so that it is evaluated while as few values as possible
+// are live.
+//
+// For + and * the heavier operand is swapped to the left, which is the one
+// the selected two-address instruction overwrites. - and / keep their
+// operands and only change the order in which they are lowered. Subtrees
+// containing an assignment are never reordered: the other operand may read
+// the variable.
+
+#define DIV_REGISTERS 3
+
+static int max(int a, int b) { return a > b ? a : b; }
+
+struct label {
+  int registers;
+  bool assigns;
+};
+
+static bool literal_value(struct ast_node *node, int *value) {
+  switch (node->type) {
+  case AST_LITERAL_EXPR:
+    *value = node->as.literal_expr.as.i32;
+    return true;
+
+  case AST_GROUPING_EXPR:
+    return literal_value(node->as.grouping_expr.expr, value);
+
+  case AST_UNARY_EXPR:
+    if (!literal_value(node->as.unary_expr.right, value))
+      return false;
+    *value = (int)(0u - (unsigned)*value);
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+static bool pins_registers(struct ast_node *node) {
+  if (node->as.binary_expr.token.type != TOKEN_SLASH)
+    return false;
+
+  int divisor;
+  if (!literal_value(node->as.binary_expr.right, &divisor))
+    return true;
+
+  enum divconst_strategy strategy = divconst_plan(divisor).strategy;
+  return strategy != DIVCONST_IDENTITY && strategy != DIVCONST_POW2;
+}
+
+static struct label label(struct ast_node *node) {
+  assert(node);
+
+  switch (node->type) {
+  case AST_LITERAL_EXPR:
+  case AST_IDENTIFIER_EXPR:
+    return (struct label){0, false};
+
+  case AST_GROUPING_EXPR:
+    return label(node->as.grouping_expr.expr);
+
+  case AST_ASSIGNMENT_STMT: {
+    struct label value = label(node->as.assignment_stmt.expr);
+    return (struct label){value.registers, true};
+  }
+
+  case AST_UNARY_EXPR: {
+    struct label right = label(node->as.unary_expr.right);
+    return (struct label){max(right.registers, 1), right.assigns};
+  }
+
+  case AST_BINARY_EXPR: {
+    struct ast_binary_expr *expr = &node->as.binary_expr;
+    struct label left = label(expr->left);
+    struct label right = label(expr->right);
+
+    struct label result = {0, left.assigns || right.assigns};
+    if (left.registers == right.registers) {
+      result.registers = left.registers + 1;
+    } else {
+      result.registers = max(left.registers, right.registers);
+    }
+
+    if (pins_registers(node))
+      result.registers = max(result.registers, DIV_REGISTERS);
+
+    if (!result.assigns && right.registers > left.registers) {
+      enum scanner_token_type op = expr->token.type;
+
+      if (op == TOKEN_PLUS || op == TOKEN_STAR) {
+        struct ast_node *tmp = expr->left;
+        expr->left = expr->right;
+        expr->right = tmp;
+      } else {
+        expr->right_first = true;
+      }
+    }
+
+    return result;
+  }
+
+  default:
+    UNREACHABLE();
+    return (struct label){0, false};
+  }
+}
+
+void order(struct ast_node *root) {
+  assert(root && root->type == AST_PROGRAM);
+
+  for (int i = 0; i < root->as.program.num_statements; i++) {
+    struct ast_node *stmt = root->as.program.statements[i];
+
+    switch (stmt->type) {
+    case AST_VARIABLE_DECL:
+      if (stmt->as.variable_decl.initialiser)
+        label(stmt->as.variable_decl.initialiser);
+      break;
+
+    case AST_PRINT_STMT:
+      label(stmt->as.print_stmt.expr);
+      break;
+
+    default:
+      // An assignment, or any other expression evaluated for its effects.
+      label(stmt);
+      break;
+    }
+  }
+}
@@ -0,0 +1,11 @@
+#ifndef order_h
+#define order_h
+
+#include "ast.h"
+
+// Sethi-Ullman evaluation ordering: labels every expression with the number
+// of registers it needs and makes the lowering evaluate the heavier operand
+// of each binary expression first.
+void order(struct ast_node *root);
+
+#endif
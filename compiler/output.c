@@ -0,0 +1,88 @@
+#include <string.h>
+
+#include "common.h"
+#include "output.h"
+
+// "-2147483648\n"
+#define MAX_LINE 12
+
+// "00", "01", ..., "99": two digits per division, as in runtime/print.s.
+static const char pairs[200] = {
+#define PAIRS(tens)                                                            \
+  tens, '0', tens, '1', tens, '2', tens, '3', tens, '4', tens, '5', tens, '6', \
+      tens, '7', tens, '8', tens, '9'
+    PAIRS('0'), PAIRS('1'), PAIRS('2'), PAIRS('3'), PAIRS('4'),
+    PAIRS('5'), PAIRS('6'), PAIRS('7'), PAIRS('8'), PAIRS('9'),
+#undef PAIRS
+};
+
+void output_init(struct output *output, FILE *file) {
+  assert(output);
+
+  output->file = file;
+  output->size = 0;
+}
+
+void output_flush(struct output *output) {
+  assert(output);
+
+  if (output->file && output->size > 0)
+    fwrite(output->data, 1, output->size, output->file);
+  output->size = 0;
+}
+
+void output_i32(struct output *output, int value) {
+  assert(output);
+
+  if (output->size > OUTPUT_CAPACITY - MAX_LINE)
+    output_flush(output);
+
+  // Digits are produced backwards, from the newline.
+  char digits[MAX_LINE];
+  char *end = digits + MAX_LINE;
+  char *p = end;
+  *--p = '\n';
+
+  unsigned magnitude = value < 0 ? -(unsigned)value : (unsigned)value;
+  while (magnitude >= 100) {
+    p -= 2;
+    memcpy(p, &pairs[2 * (magnitude % 100)], 2);
+    magnitude /= 100;
+  }
+
+  // The last one or two digits; a pair below 10 starts with '0'.
+  p -= 2;
+  memcpy(p, &pairs[2 * magnitude], 2);
+  p += magnitude < 10;
+
+  if (value < 0)
+    *--p = '-';
+
+  memcpy(output->data + output->size, p, end - p);
+  output->size += end - p;
+}
+
+void output_bool(struct output *output, bool value) {
+  output_string(output, value ? "true" : "false");
+}
+
+void output_string(struct output *output, const char *string) {
+  assert(output && string);
+
+  size_t length = strlen(string);
+  if (output->size + length + 1 > OUTPUT_CAPACITY)
+    output_flush(output);
+
+  // Longer than the buffer: write it through.
+  if (length + 1 > OUTPUT_CAPACITY) {
+    if (output->file) {
+      fwrite(string, 1, length, output->file);
+      fputc('\n', output->file);
+    }
+    return;
+  }
+
+  memcpy(output->data + output->size, string, length);
+  output->data[output->size + length] = '\n';
+  output->size += length + 1;
+}
@@ -0,0 +1,25 @@
+#ifndef output_h
+#define output_h
+
+#include "common.h"
+
+#define OUTPUT_CAPACITY 65536
+
+// Buffered output of programs the compiler runs itself (--run, --interpret),
+// written to the file when the buffer fills and on output_flush(). A NULL
+// file discards everything.
+struct output {
+  FILE *file;
+  size_t size;
+  char data[OUTPUT_CAPACITY];
+};
+
+void output_init(struct output *output, FILE *file);
+void output_flush(struct output *output);
+
+// Each writes one line.
+void output_i32(struct output *output, int value);
+void output_bool(struct output *output, bool value);
+void output_string(struct output *output, const char *string);
+
+#endif
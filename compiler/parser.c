@@ -1,7 +1,8 @@
-#include <string.h>
 
 #include "ast.h"
 #include "common.h"
+#include "diagnostics.h"
+#include "memory.h"
 #include "parser.h"
 #include "scanner.h"
 
@@ -10,11 +11,21 @@
 //   const char *message;
 // };
 
+// How deep a statement's syntax tree may grow. The parser and the passes
+// after it recurse once per level, on whatever stack the compiling thread
+// has, so deeper input is an error rather than a stack overflow.
+#define MAX_DEPTH 10000
+
 struct parser_t {
   scanner_t *scanner;
   struct scanner_token current;
   struct scanner_token previous;
 
+  // Levels of the tree above the expression being parsed: one per
+  // enclosing expression, and one per operator before it in a chain, which
+  // nests what came before one level deeper.
+  int depth;
+
   bool panic_mode;
   bool had_error;
 };
@@ -43,12 +54,16 @@ struct parser_rule {
 parser_t *parser_new(scanner_t *scanner) {
   assert(scanner);
 
-  parser_t *parser = (parser_t *)malloc(sizeof(*parser));
+  parser_t *parser = (parser_t *)memory_alloc(MEMORY_PARSER, sizeof(*parser));
   if (parser == NULL) {
     ERROR_OUT();
   }
 
   parser->scanner = scanner;
+  // Neither the end nor an error, which advance() asserts they are not.
+  parser->current = (struct scanner_token){0};
+  parser->previous = (struct scanner_token){0};
+  parser->depth = 0;
   parser->panic_mode = false;
   parser->had_error = false;
 
@@ -58,7 +73,7 @@ parser_t *parser_new(scanner_t *scanner) {
 void parser_free(parser_t **parser) {
   assert(parser && *parser);
 
-  free(*parser);
+  memory_free(*parser);
   *parser = NULL;
 }
 
@@ -71,17 +86,18 @@ static void error(parser_t *parser, struct scanner_token *token,
     return;
 
   parser->panic_mode = true;
-  fprintf(stderr, "line %d - error", token->line);
+  FILE *err = diagnostics_err();
+  fprintf(err, "line %d - error", token->line);
 
   if (token->type == TOKEN_EOF) {
-    fprintf(stderr, " at end");
+    fprintf(err, " at end");
   } else if (token->type == TOKEN_ERROR) {
 
   } else {
-    fprintf(stderr, " at '%.*s'", token->length, token->start);
+    fprintf(err, " at '%.*s'", token->length, token->start);
   }
 
-  fprintf(stderr, " - %s\n", message);
+  fprintf(err, " - %s\n", message);
   parser->had_error = true;
 }
 
@@ -128,8 +144,11 @@ static void synchronise(parser_t *parser) {
   parser->panic_mode = false;
 
   while (parser->current.type != TOKEN_EOF) {
-    if (parser->current.type == TOKEN_SEMICOLON)
+    // The statement's own ';' is not the start of the next one.
+    if (parser->current.type == TOKEN_SEMICOLON) {
+      advance(parser);
       return;
+    }
 
     switch (parser->current.type) {
     case TOKEN_VAR:
@@ -157,7 +176,7 @@ static struct ast_node *parse_literal_expr(parser_t *parser, bool can_assign);
 static struct ast_node *parse_precedence(parser_t *parser,
                                          enum parser_precedence prec);
 
-struct parser_rule rules[] = {
+static const struct parser_rule rules[] = {
     // Keywords
     [TOKEN_VAR] = {NULL, NULL, PREC_NONE},
     [TOKEN_CONST] = {NULL, NULL, PREC_NONE},
@@ -189,7 +208,7 @@ struct parser_rule rules[] = {
     [TOKEN_EOF] = {NULL, NULL, PREC_NONE},
     [TOKEN_ERROR] = {NULL, NULL, PREC_NONE}};
 
-static struct parser_rule *get_rule(enum scanner_token_type type) {
+static const struct parser_rule *get_rule(enum scanner_token_type type) {
   return &rules[type];
 }
 
@@ -279,11 +298,19 @@ static struct ast_node *parse_literal_expr(parser_t *parser, bool can_assign) {
 
   switch (parser->previous.type) {
   case TOKEN_NUMBER: {
-    char tmp[20];
-    strncpy(tmp, parser->previous.start, parser->previous.length);
-    tmp[parser->previous.length] = '\0';
+    // At most 2^31, which wraps to INT_MIN as the arithmetic does, so that
+    // -2147483648 can be written. The digits are read as they come, since
+    // the token may be of any length.
+    long long value = 0;
+    for (int i = 0; i < parser->previous.length; i++) {
+      value = value * 10 + (parser->previous.start[i] - '0');
+      if (value > 2147483648LL) {
+        error(parser, &parser->previous, "Number literal out of range.");
+        return NULL;
+      }
+    }
 
-    return ast_new_number_expr(atoi(tmp));
+    return ast_new_number_expr((int)(unsigned)value);
   }
 
   case TOKEN_TRUE:
@@ -292,7 +319,7 @@ static struct ast_node *parse_literal_expr(parser_t *parser, bool can_assign) {
 
   default:
     UNREACHABLE();
-    break;
+    return NULL;
   }
 }
 
@@ -335,6 +362,11 @@ static struct ast_node *parse_precedence(parser_t *parser,
 
   advance(parser);
 
+  if (parser->depth == MAX_DEPTH) {
+    error(parser, &parser->previous, "Expression nested too deeply.");
+    return NULL;
+  }
+
   parser_prefix_fn prefix = get_rule(parser->previous.type)->prefix;
   if (prefix == NULL) {
     error(parser, &parser->previous, "Expected an expression.");
@@ -342,6 +374,7 @@ static struct ast_node *parse_precedence(parser_t *parser,
   }
 
   bool can_assign = prec <= PREC_ASSIGNMENT;
+  int depth = parser->depth++;
 
   struct ast_node *left = prefix(parser, can_assign);
   while (prec <= get_rule(parser->current.type)->prec) {
@@ -349,10 +382,18 @@ static struct ast_node *parse_precedence(parser_t *parser,
       break;
 
     advance(parser);
+    if (parser->depth == MAX_DEPTH) {
+      error(parser, &parser->previous, "Expression nested too deeply.");
+      break;
+    }
+    parser->depth++;
+
     parser_infix_fn infix = get_rule(parser->previous.type)->infix;
     left = infix(parser, left, can_assign);
   }
 
+  parser->depth = depth;
+
   if (can_assign && match(parser, TOKEN_EQUAL)) {
     error(parser, &parser->previous, "Invalid assignment target.");
   }
@@ -366,10 +407,19 @@ bool parser_run(parser_t *parser, struct ast_node **output) {
 
   advance(parser);
 
-  struct ast_node *statements[MAX_STATEMENTS];
+  struct ast_node **statements = NULL;
+  int capacity = 0;
 
   int i = 0;
   while (!match(parser, TOKEN_EOF)) {
+    if (i == capacity) {
+      capacity = capacity ? capacity * 2 : 64;
+      statements = memory_realloc(MEMORY_AST, statements,
+                                  capacity * sizeof(*statements));
+      if (statements == NULL)
+        ERROR_OUT();
+    }
+
     statements[i++] = parse_decl(parser);
   }
 
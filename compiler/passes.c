@@ -0,0 +1,258 @@
+#include <string.h>
+#include <time.h>
+
+#include "ast.h"
+#include "common.h"
+#include "dce.h"
+#include "fold.h"
+#include "ir.h"
+#include "memory.h"
+#include "order.h"
+#include "passes.h"
+#include "peephole.h"
+#include "reassociate.h"
+#include "regalloc.h"
+#include "slots.h"
+#include "slp.h"
+#include "timer.h"
+#include "trace.h"
+#include "x86.h"
+
+// Passes run in table order within their kind: every AST pass runs before
+// the program is lowered, every IR pass after, and every x86 pass after
+// instruction selection.
+static const struct pass passes[] = {
+    {"reassociate", PASS_AST, 2, {.ast = reassociate}, NULL},
+    {"order", PASS_AST, 1, {.ast = order}, NULL},
+    {"fold", PASS_IR, 1, {.ir = fold}, NULL},
+    {"dce", PASS_IR, 1, {.ir = dce}, NULL},
+    {"slp", PASS_IR, 2, {.ir = slp}, NULL},
+    {"regalloc", PASS_X86, 1, {.x86 = regalloc}, regalloc_spill_all},
+    {"peephole", PASS_X86, 1, {.x86 = peephole}, NULL},
+    {"slots", PASS_X86, 1, {.x86 = slots}, NULL},
+};
+
+#define NUM_PASSES ((int)(sizeof(passes) / sizeof(passes[0])))
+
+struct pass_result {
+  bool ran;
+  long long nanoseconds;
+  int before;
+  int after;
+};
+
+struct pass_manager_t {
+  int opt_level;
+  bool enabled[NUM_PASSES];
+  struct pass_result results[NUM_PASSES];
+
+  // Virtual registers given stack slots, -1 until the x86 passes have run.
+  int spills;
+  int peephole_hits[NUM_PEEPHOLE_RULES];
+
+  // Packs formed and trees rejected by slp, -1 until the IR passes have run.
+  int packs;
+  int rejected_packs;
+
+  struct timer *timer;
+};
+
+pass_manager_t *pass_manager_new(int opt_level) {
+  assert(0 <= opt_level && opt_level <= MAX_OPT_LEVEL);
+
+  pass_manager_t *manager = memory_alloc(MEMORY_PASSES, sizeof(*manager));
+  if (manager == NULL)
+    ERROR_OUT();
+
+  manager->opt_level = opt_level;
+  manager->spills = -1;
+  manager->packs = -1;
+  manager->rejected_packs = 0;
+  manager->timer = NULL;
+  for (int i = 0; i < NUM_PEEPHOLE_RULES; i++)
+    manager->peephole_hits[i] = 0;
+  for (int i = 0; i < NUM_PASSES; i++) {
+    manager->enabled[i] = passes[i].level <= opt_level;
+    manager->results[i] = (struct pass_result){0};
+  }
+
+  return manager;
+}
+
+void pass_manager_free(pass_manager_t **manager) {
+  assert(manager && *manager);
+
+  memory_free(*manager);
+  *manager = NULL;
+}
+
+bool pass_manager_set_enabled(pass_manager_t *manager, const char *name,
+                              bool enabled) {
+  assert(manager && name);
+
+  for (int i = 0; i < NUM_PASSES; i++) {
+    if (strcmp(passes[i].name, name) == 0) {
+      manager->enabled[i] = enabled;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void pass_manager_set_timer(pass_manager_t *manager, struct timer *timer) {
+  assert(manager);
+
+  manager->timer = timer;
+}
+
+static void begin(pass_manager_t *manager, int pass) {
+  TRACE_BEGIN(passes[pass].name);
+  if (manager->timer)
+    timer_begin(manager->timer, passes[pass].name);
+}
+
+static void end(pass_manager_t *manager, int before, const char *unit) {
+  if (manager->timer)
+    timer_end(manager->timer, before, unit);
+  TRACE_END();
+}
+
+static long long now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void verify(struct ir_program *program, const char *after) {
+#ifndef NDEBUG
+  if (!ir_verify(program)) {
+    fprintf(stderr, "[error] IR verification failed after '%s'.\n", after);
+    abort();
+  }
+#else
+  (void)program;
+  (void)after;
+#endif
+}
+
+void pass_manager_run_ast(pass_manager_t *manager, struct ast_node *root) {
+  assert(manager && root);
+
+  for (int i = 0; i < NUM_PASSES; i++) {
+    if (passes[i].kind != PASS_AST || !manager->enabled[i])
+      continue;
+
+    struct pass_result *result = &manager->results[i];
+    result->before = ast_count(root);
+
+    begin(manager, i);
+    long long start = now();
+    passes[i].run.ast(root);
+    result->nanoseconds = now() - start;
+    end(manager, result->before, "nodes");
+
+    result->after = ast_count(root);
+    result->ran = true;
+  }
+}
+
+void pass_manager_run_ir(pass_manager_t *manager, struct ir_program *program) {
+  assert(manager && program);
+
+  verify(program, "lowering");
+
+  for (int i = 0; i < NUM_PASSES; i++) {
+    if (passes[i].kind != PASS_IR || !manager->enabled[i])
+      continue;
+
+    struct pass_result *result = &manager->results[i];
+    result->before = program->num_instrs;
+
+    begin(manager, i);
+    long long start = now();
+    passes[i].run.ir(program);
+    result->nanoseconds = now() - start;
+    end(manager, result->before, "instrs");
+
+    result->after = program->num_instrs;
+    result->ran = true;
+
+    verify(program, passes[i].name);
+  }
+
+  manager->packs = program->num_packs;
+  manager->rejected_packs = program->num_rejected_packs;
+}
+
+void pass_manager_run_x86(pass_manager_t *manager, struct x86_program *program) {
+  assert(manager && program);
+
+  for (int i = 0; i < NUM_PASSES; i++) {
+    if (passes[i].kind != PASS_X86)
+      continue;
+
+    if (!manager->enabled[i]) {
+      // Timed under the name of the pass it stands in for.
+      if (passes[i].fallback) {
+        int before = program->num_instrs;
+        begin(manager, i);
+        passes[i].fallback(program);
+        end(manager, before, "instrs");
+      }
+      continue;
+    }
+
+    struct pass_result *result = &manager->results[i];
+    result->before = program->num_instrs;
+
+    begin(manager, i);
+    long long start = now();
+    passes[i].run.x86(program);
+    result->nanoseconds = now() - start;
+    end(manager, result->before, "instrs");
+
+    result->after = program->num_instrs;
+    result->ran = true;
+  }
+
+  manager->spills = program->num_spills;
+  for (int i = 0; i < NUM_PEEPHOLE_RULES; i++)
+    manager->peephole_hits[i] = program->peephole_hits[i];
+}
+
+void pass_manager_report(pass_manager_t *manager, FILE *file) {
+  assert(manager && file);
+
+  fprintf(file, "-O%d\n", manager->opt_level);
+  fprintf(file, "%-14s %-4s %12s %10s %10s\n", "pass", "kind", "time (us)",
+          "before", "after");
+
+  for (int i = 0; i < NUM_PASSES; i++) {
+    struct pass_result *result = &manager->results[i];
+    const char *kinds[] = {"ast", "ir", "x86"};
+    const char *kind = kinds[passes[i].kind];
+
+    if (!result->ran) {
+      fprintf(file, "%-14s %-4s %12s %10s %10s\n", passes[i].name, kind,
+              "disabled", "-", "-");
+      continue;
+    }
+
+    fprintf(file, "%-14s %-4s %12.2f %10d %10d\n", passes[i].name, kind,
+            result->nanoseconds / 1000.0, result->before, result->after);
+  }
+
+  if (manager->packs > 0 || manager->rejected_packs > 0)
+    fprintf(file, "slp: %d packs, %d trees rejected\n", manager->packs,
+            manager->rejected_packs);
+
+  if (manager->spills >= 0)
+    fprintf(file, "spills: %d\n", manager->spills);
+
+  for (int i = 0; i < NUM_PEEPHOLE_RULES; i++) {
+    if (manager->peephole_hits[i] > 0)
+      fprintf(file, "peephole %s: %d\n", peephole_rule_name(i),
+              manager->peephole_hits[i]);
+  }
+}
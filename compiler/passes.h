@@ -0,0 +1,50 @@
+#ifndef passes_h
+#define passes_h
+
+#include "ast.h"
+#include "common.h"
+#include "ir.h"
+#include "timer.h"
+#include "x86.h"
+
+#define MAX_OPT_LEVEL 2
+
+typedef struct pass_manager_t pass_manager_t;
+
+enum pass_kind { PASS_AST, PASS_IR, PASS_X86 };
+
+struct pass {
+  const char *name;
+  enum pass_kind kind;
+
+  // Lowest -O level whose pipeline includes the pass.
+  int level;
+
+  union {
+    void (*ast)(struct ast_node *root);
+    void (*ir)(struct ir_program *program);
+    void (*x86)(struct x86_program *program);
+  } run;
+
+  // Runs instead when the pass is disabled, for passes the backend cannot
+  // do without (register allocation).
+  void (*fallback)(struct x86_program *program);
+};
+
+pass_manager_t *pass_manager_new(int opt_level);
+void pass_manager_free(pass_manager_t **manager);
+
+bool pass_manager_set_enabled(pass_manager_t *manager, const char *name,
+                              bool enabled);
+
+// Records each pass that runs as a phase of the timer, with the AST nodes or
+// instructions it started with.
+void pass_manager_set_timer(pass_manager_t *manager, struct timer *timer);
+
+void pass_manager_run_ast(pass_manager_t *manager, struct ast_node *root);
+void pass_manager_run_ir(pass_manager_t *manager, struct ir_program *program);
+void pass_manager_run_x86(pass_manager_t *manager, struct x86_program *program);
+
+void pass_manager_report(pass_manager_t *manager, FILE *file);
+
+#endif
@@ -0,0 +1,190 @@
+#include "peephole.h"
+#include "common.h"
+#include "x86.h"
+
+// Peephole optimisation over the allocated instruction list. A window of up
+// to two instructions slides over the list; the first rule matching at a
+// position rewrites it, and the window backs up one instruction so that the
+// rewrite can enable a match with its predecessor. The list is scanned again
+// until a full scan changes nothing. Every rule removes an instruction or
+// replaces one with a cheaper form that no rule matches again, so this
+// terminates.
+//
+//   self-move      movl x, x                  -> (removed)
+//   store-reload   movl r, m; movl m, x       -> movl r, m; movl r, x
+//   move-back      movl a, b; movl b, a       -> movl a, b
+//   zero-idiom     movl $0, r                 -> xorl r, r
+//   nop-arith      addl/subl/shll/sarl/shrl $0, x -> (removed)
+//
+// Rules that change the flags only apply when no later instruction reads
+// them before they are set again.
+
+_Static_assert(NUM_PEEPHOLE_RULES <= X86_MAX_PEEPHOLE_RULES,
+               "x86_program.peephole_hits is too small");
+
+struct rule {
+  const char *name;
+  int window;
+  bool (*apply)(struct x86_program *program, struct x86_instr *first);
+};
+
+static bool same_operand(struct x86_operand a, struct x86_operand b) {
+  return a.type == b.type && a.value == b.value;
+}
+
+static bool is_move(struct x86_instr *instr) {
+  return instr->op == X86_MOV && instr->size == 4;
+}
+
+static bool sets_flags(struct x86_instr *instr) {
+  switch (instr->op) {
+  case X86_ADD:
+  case X86_SUB:
+  case X86_IMUL:
+  case X86_IMUL3:
+  case X86_IMUL1:
+  case X86_IDIV:
+  case X86_NEG:
+  case X86_SHL:
+  case X86_SAR:
+  case X86_SHR:
+  case X86_XOR:
+  case X86_TEST:
+  case X86_CALL:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static bool flags_live_after(struct x86_instr *instr) {
+  for (instr = instr->next; instr; instr = instr->next) {
+    if (instr->op == X86_CMOVNE)
+      return true;
+    if (sets_flags(instr))
+      return false;
+  }
+
+  return false;
+}
+
+static bool self_move(struct x86_program *program, struct x86_instr *first) {
+  if (!is_move(first) || !same_operand(first->src, first->dst))
+    return false;
+
+  x86_remove(program, first);
+  return true;
+}
+
+static bool store_reload(struct x86_program *program,
+                         struct x86_instr *first) {
+  struct x86_instr *second = first->next;
+
+  if (!is_move(first) || !is_move(second) || first->dst.type != X86_STACK ||
+      first->src.type == X86_STACK ||
+      !same_operand(first->dst, second->src))
+    return false;
+
+  if (same_operand(first->src, second->dst)) {
+    x86_remove(program, second);
+  } else {
+    second->src = first->src;
+  }
+  return true;
+}
+
+static bool move_back(struct x86_program *program, struct x86_instr *first) {
+  struct x86_instr *second = first->next;
+
+  if (!is_move(first) || !is_move(second) ||
+      !same_operand(first->src, second->dst) ||
+      !same_operand(first->dst, second->src))
+    return false;
+
+  x86_remove(program, second);
+  return true;
+}
+
+static bool zero_idiom(struct x86_program *program, struct x86_instr *first) {
+  (void)program;
+
+  if (!is_move(first) || first->src.type != X86_IMM ||
+      first->src.value != 0 || first->dst.type != X86_REG ||
+      flags_live_after(first))
+    return false;
+
+  first->op = X86_XOR;
+  first->src = first->dst;
+  return true;
+}
+
+static bool nop_arith(struct x86_program *program, struct x86_instr *first) {
+  switch (first->op) {
+  case X86_ADD:
+  case X86_SUB:
+  case X86_SHL:
+  case X86_SAR:
+  case X86_SHR:
+    break;
+  default:
+    return false;
+  }
+
+  if (first->size != 4 || first->src.type != X86_IMM ||
+      first->src.value != 0 || flags_live_after(first))
+    return false;
+
+  x86_remove(program, first);
+  return true;
+}
+
+// Indexed by enum peephole_rule.
+static const struct rule rules[NUM_PEEPHOLE_RULES] = {
+    {"self-move", 1, self_move},   {"store-reload", 2, store_reload},
+    {"move-back", 2, move_back},   {"zero-idiom", 1, zero_idiom},
+    {"nop-arith", 1, nop_arith},
+};
+
+const char *peephole_rule_name(enum peephole_rule rule) {
+  assert(0 <= rule && rule < NUM_PEEPHOLE_RULES);
+  return rules[rule].name;
+}
+
+static bool fits(struct x86_instr *instr, int window) {
+  for (int i = 1; i < window; i++) {
+    instr = instr->next;
+    if (instr == NULL)
+      return false;
+  }
+
+  return true;
+}
+
+void peephole(struct x86_program *program) {
+  assert(program);
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+
+    struct x86_instr *instr = program->head;
+    while (instr) {
+      struct x86_instr *prev = instr->prev;
+      bool hit = false;
+
+      for (int i = 0; i < NUM_PEEPHOLE_RULES && !hit; i++) {
+        if (fits(instr, rules[i].window) && rules[i].apply(program, instr)) {
+          program->peephole_hits[i]++;
+          hit = true;
+        }
+      }
+
+      if (hit) {
+        changed = true;
+        instr = prev ? prev : program->head;
+      } else {
+        instr = instr->next;
+      }
+    }
+  }
+}
@@ -0,0 +1,21 @@
+#ifndef peephole_h
+#define peephole_h
+
+#include "x86.h"
+
+enum peephole_rule {
+  PEEPHOLE_SELF_MOVE,
+  PEEPHOLE_STORE_RELOAD,
+  PEEPHOLE_MOVE_BACK,
+  PEEPHOLE_ZERO_IDIOM,
+  PEEPHOLE_NOP_ARITH,
+  NUM_PEEPHOLE_RULES
+};
+
+const char *peephole_rule_name(enum peephole_rule rule);
+
+// Rewrites the allocated instruction list with the rules in peephole.c until
+// none applies. Hits per rule are added to program->peephole_hits.
+void peephole(struct x86_program *program);
+
+#endif
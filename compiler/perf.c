@@ -0,0 +1,109 @@
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "perf.h"
+
+struct perf_config {
+  const char *name;
+  unsigned int type;
+  unsigned long long config;
+};
+
+#define CACHE(cache, op, result)                                               \
+  ((cache) | (PERF_COUNT_HW_CACHE_OP_##op << 8) |                              \
+   (PERF_COUNT_HW_CACHE_RESULT_##result << 16))
+
+static const struct perf_config configs[NUM_PERF_EVENTS] = {
+    [PERF_CYCLES] = {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    [PERF_INSTRUCTIONS] = {"instructions", PERF_TYPE_HARDWARE,
+                           PERF_COUNT_HW_INSTRUCTIONS},
+    [PERF_BRANCH_MISSES] = {"branch-misses", PERF_TYPE_HARDWARE,
+                            PERF_COUNT_HW_BRANCH_MISSES},
+    [PERF_L1D_MISSES] = {"L1D-misses", PERF_TYPE_HW_CACHE,
+                         CACHE(PERF_COUNT_HW_CACHE_L1D, READ, MISS)},
+    // Last-level cache misses on the machines that have the generic event.
+    [PERF_LLC_MISSES] = {"LLC-misses", PERF_TYPE_HARDWARE,
+                         PERF_COUNT_HW_CACHE_MISSES},
+};
+
+// The layout read(2) fills in for the read_format below.
+struct perf_reading {
+  unsigned long long value;
+  unsigned long long enabled;
+  unsigned long long running;
+};
+
+bool perf_open(struct perf *perf) {
+  assert(perf);
+
+  perf->num_open = 0;
+  perf->error = 0;
+
+  for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = configs[i].type;
+    attr.config = configs[i].config;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // Only the compiler's own work, which also keeps the events open to
+    // unprivileged users at the default perf_event_paranoid of 2.
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    perf->fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (perf->fds[i] < 0) {
+      perf->fds[i] = -1;
+      if (perf->error == 0)
+        perf->error = errno;
+      continue;
+    }
+
+    perf->num_open++;
+  }
+
+  return perf->num_open > 0;
+}
+
+void perf_close(struct perf *perf) {
+  assert(perf);
+
+  for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+    if (perf->fds[i] >= 0)
+      close(perf->fds[i]);
+    perf->fds[i] = -1;
+  }
+  perf->num_open = 0;
+}
+
+void perf_read(struct perf *perf, long long values[NUM_PERF_EVENTS]) {
+  assert(perf && values);
+
+  for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+    struct perf_reading reading;
+    values[i] = -1;
+
+    if (perf->fds[i] < 0 ||
+        read(perf->fds[i], &reading, sizeof(reading)) != sizeof(reading) ||
+        reading.running == 0)
+      continue;
+
+    if (reading.running < reading.enabled) {
+      values[i] = (long long)((double)reading.value * reading.enabled /
+                              reading.running);
+    } else {
+      values[i] = reading.value;
+    }
+  }
+}
+
+const char *perf_event_name(enum perf_event event) {
+  assert(0 <= event && event < NUM_PERF_EVENTS);
+
+  return configs[event].name;
+}
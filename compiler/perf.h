@@ -0,0 +1,39 @@
+#ifndef perf_h
+#define perf_h
+
+#include "common.h"
+
+// Hardware performance counters of the compiler's own thread, through
+// perf_event_open(2), for --perf-counters. Each event is opened on its own,
+// so the ones the kernel or the machine does not support are left out
+// rather than failing the rest.
+
+enum perf_event {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_BRANCH_MISSES,
+  PERF_L1D_MISSES,
+  PERF_LLC_MISSES,
+  NUM_PERF_EVENTS,
+};
+
+struct perf {
+  // -1 for the events that could not be opened.
+  int fds[NUM_PERF_EVENTS];
+  int num_open;
+
+  // errno of the first event that could not be opened, 0 if none.
+  int error;
+};
+
+// Opens and starts every event it can. Returns false if none could be.
+bool perf_open(struct perf *perf);
+void perf_close(struct perf *perf);
+
+// Counts since perf_open, scaled up if the kernel had to multiplex the
+// events; -1 for the events that are not open.
+void perf_read(struct perf *perf, long long values[NUM_PERF_EVENTS]);
+
+const char *perf_event_name(enum perf_event event);
+
+#endif
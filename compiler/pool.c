@@ -0,0 +1,121 @@
+#include <pthread.h>
+
+#include "common.h"
+#include "memory.h"
+#include "pool.h"
+
+// The tasks a worker has left, front to back. The lock is taken once per
+// task, which is little next to a task as large as compiling a file.
+struct worker {
+  pool_t *pool;
+  int index;
+  pthread_t thread;
+
+  pthread_mutex_t lock;
+  int front;
+  int back;
+};
+
+struct pool_t {
+  struct worker *workers;
+  int num_workers;
+
+  pool_task run;
+  void *context;
+};
+
+// Takes the back half of the first other worker that has tasks left, and
+// returns the first of them. -1 once every task has been taken.
+static int steal(struct worker *thief) {
+  pool_t *pool = thief->pool;
+
+  for (int i = 1; i < pool->num_workers; i++) {
+    struct worker *victim =
+        &pool->workers[(thief->index + i) % pool->num_workers];
+
+    pthread_mutex_lock(&victim->lock);
+    int back = victim->back;
+    int front = back - (back - victim->front + 1) / 2;
+    victim->back = front;
+    pthread_mutex_unlock(&victim->lock);
+
+    if (front == back)
+      continue;
+
+    pthread_mutex_lock(&thief->lock);
+    thief->front = front + 1;
+    thief->back = back;
+    pthread_mutex_unlock(&thief->lock);
+    return front;
+  }
+
+  return -1;
+}
+
+static int next(struct worker *worker) {
+  pthread_mutex_lock(&worker->lock);
+  int task = worker->front < worker->back ? worker->front++ : -1;
+  pthread_mutex_unlock(&worker->lock);
+
+  return task >= 0 ? task : steal(worker);
+}
+
+static void *work(void *arg) {
+  struct worker *worker = arg;
+  pool_t *pool = worker->pool;
+
+  for (int task = next(worker); task >= 0; task = next(worker))
+    pool->run(pool->context, task, worker->index);
+
+  return NULL;
+}
+
+pool_t *pool_new(int num_workers, int num_tasks, pool_task run,
+                 void *context) {
+  assert(num_workers > 0 && num_tasks >= 0 && run);
+
+  pool_t *pool = memory_alloc(MEMORY_BATCH, sizeof(*pool));
+  if (pool == NULL)
+    ERROR_OUT();
+
+  pool->workers =
+      memory_calloc(MEMORY_BATCH, num_workers, sizeof(*pool->workers));
+  if (pool->workers == NULL)
+    ERROR_OUT();
+
+  pool->num_workers = num_workers;
+  pool->run = run;
+  pool->context = context;
+
+  // Every share is in place before any worker can steal from it.
+  for (int i = 0; i < num_workers; i++) {
+    struct worker *worker = &pool->workers[i];
+    worker->pool = pool;
+    worker->index = i;
+    pthread_mutex_init(&worker->lock, NULL);
+    worker->front = (long long)num_tasks * i / num_workers;
+    worker->back = (long long)num_tasks * (i + 1) / num_workers;
+  }
+
+  for (int i = 0; i < num_workers; i++) {
+    struct worker *worker = &pool->workers[i];
+    if (pthread_create(&worker->thread, NULL, work, worker) != 0)
+      ERROR_OUT();
+  }
+
+  return pool;
+}
+
+void pool_free(pool_t **pool) {
+  assert(pool && *pool);
+
+  // Until the last worker is done, it may still try to steal from any.
+  for (int i = 0; i < (*pool)->num_workers; i++)
+    pthread_join((*pool)->workers[i].thread, NULL);
+  for (int i = 0; i < (*pool)->num_workers; i++)
+    pthread_mutex_destroy(&(*pool)->workers[i].lock);
+
+  memory_free((*pool)->workers);
+  memory_free(*pool);
+  *pool = NULL;
+}
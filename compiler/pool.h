@@ -0,0 +1,25 @@
+#ifndef pool_h
+#define pool_h
+
+#include "common.h"
+
+// A fixed number of worker threads that run each of the tasks 0 to
+// num_tasks - 1 once. Every worker starts with a contiguous share of the
+// tasks and takes them from the front; one that runs out steals the back
+// half of the share of another, so that a few slow tasks do not hold up the
+// rest.
+
+typedef struct pool_t pool_t;
+
+// worker is the index of the thread running the task, below num_workers,
+// for state each thread keeps to itself.
+typedef void (*pool_task)(void *context, int task, int worker);
+
+// Starts the workers, which begin at once.
+pool_t *pool_new(int num_workers, int num_tasks, pool_task run,
+                 void *context);
+
+// Waits until every task has run.
+void pool_free(pool_t **pool);
+
+#endif
@@ -0,0 +1,191 @@
+#include "memory.h"
+#include "reassociate.h"
+#include "ast.h"
+#include "common.h"
+#include "scanner.h"
+
+// Rewrites chains of the same associative and commutative operator (i32 '+'
+// and '*') into balanced trees, so that a left-leaning 'a + b + c + d' is
+// evaluated as '(a + b) + (c + d)' and the two halves can execute in
+// parallel. Literal operands anywhere in a chain are folded into a single
+// literal placed last. Both operators are evaluated modulo 2^32, so any
+// association gives the same result.
+//
+// Multiplication by a folded zero is kept: dropping the other operands could
+// remove a division by zero.
+
+struct chain {
+  enum scanner_token_type op;
+
+  struct ast_node **leaves;
+  int num_leaves;
+  int capacity;
+
+  struct ast_node **spare;
+  int num_spare;
+  int spare_capacity;
+
+  bool has_constant;
+  unsigned int constant;
+};
+
+static struct ast_node *reassociate_expr(struct ast_node *node);
+
+static bool is_chain_op(enum scanner_token_type op) {
+  return op == TOKEN_PLUS || op == TOKEN_STAR;
+}
+
+static void push(struct ast_node ***items, int *length, int *capacity,
+                 struct ast_node *node) {
+  if (*length == *capacity) {
+    *capacity = *capacity ? *capacity * 2 : 8;
+    *items = memory_realloc(MEMORY_PASSES, *items, *capacity * sizeof(**items));
+    if (*items == NULL)
+      ERROR_OUT();
+  }
+
+  (*items)[(*length)++] = node;
+}
+
+static void chain_add_constant(struct chain *chain, int value) {
+  if (!chain->has_constant) {
+    chain->has_constant = true;
+    chain->constant = (unsigned int)value;
+  } else if (chain->op == TOKEN_PLUS) {
+    chain->constant += (unsigned int)value;
+  } else {
+    chain->constant *= (unsigned int)value;
+  }
+}
+
+static void chain_collect(struct chain *chain, struct ast_node *node) {
+  // Parentheses carry no meaning once the tree is built.
+  if (node->type == AST_GROUPING_EXPR) {
+    struct ast_node *inner = node->as.grouping_expr.expr;
+    memory_free(node);
+    chain_collect(chain, inner);
+    return;
+  }
+
+  if (node->type == AST_BINARY_EXPR &&
+      node->as.binary_expr.token.type == chain->op) {
+    chain_collect(chain, node->as.binary_expr.left);
+    chain_collect(chain, node->as.binary_expr.right);
+    push(&chain->spare, &chain->num_spare, &chain->spare_capacity, node);
+    return;
+  }
+
+  node = reassociate_expr(node);
+
+  if (node->type == AST_LITERAL_EXPR) {
+    chain_add_constant(chain, node->as.literal_expr.as.i32);
+    ast_free(&node);
+    return;
+  }
+
+  push(&chain->leaves, &chain->num_leaves, &chain->capacity, node);
+}
+
+static struct ast_node *chain_build(struct chain *chain, int lo, int hi) {
+  if (lo == hi)
+    return chain->leaves[lo];
+
+  int mid = lo + (hi - lo) / 2;
+
+  struct ast_node *node = chain->spare[--chain->num_spare];
+  node->as.binary_expr.left = chain_build(chain, lo, mid);
+  node->as.binary_expr.right = chain_build(chain, mid + 1, hi);
+
+  return node;
+}
+
+static struct ast_node *reassociate_chain(struct ast_node *node) {
+  struct chain chain = {.op = node->as.binary_expr.token.type};
+
+  chain_collect(&chain, node);
+
+  unsigned int identity = chain.op == TOKEN_PLUS ? 0 : 1;
+  if (chain.has_constant &&
+      (chain.constant != identity || chain.num_leaves == 0)) {
+    push(&chain.leaves, &chain.num_leaves, &chain.capacity,
+         ast_new_number_expr((int)chain.constant));
+  }
+
+  if (chain.num_leaves == 0) {
+    // Only identity literals were folded away.
+    push(&chain.leaves, &chain.num_leaves, &chain.capacity,
+         ast_new_number_expr((int)identity));
+  }
+
+  struct ast_node *result = chain_build(&chain, 0, chain.num_leaves - 1);
+
+  for (int i = 0; i < chain.num_spare; i++)
+    memory_free(chain.spare[i]);
+
+  memory_free(chain.leaves);
+  memory_free(chain.spare);
+
+  return result;
+}
+
+static struct ast_node *reassociate_expr(struct ast_node *node) {
+  assert(node);
+
+  switch (node->type) {
+  case AST_BINARY_EXPR:
+    if (is_chain_op(node->as.binary_expr.token.type))
+      return reassociate_chain(node);
+
+    node->as.binary_expr.left = reassociate_expr(node->as.binary_expr.left);
+    node->as.binary_expr.right = reassociate_expr(node->as.binary_expr.right);
+    return node;
+
+  case AST_UNARY_EXPR:
+    node->as.unary_expr.right = reassociate_expr(node->as.unary_expr.right);
+    return node;
+
+  case AST_GROUPING_EXPR:
+    node->as.grouping_expr.expr = reassociate_expr(node->as.grouping_expr.expr);
+    return node;
+
+  case AST_ASSIGNMENT_STMT:
+    node->as.assignment_stmt.expr =
+        reassociate_expr(node->as.assignment_stmt.expr);
+    return node;
+
+  case AST_LITERAL_EXPR:
+  case AST_IDENTIFIER_EXPR:
+    return node;
+
+  default:
+    UNREACHABLE();
+    return node;
+  }
+}
+
+static struct ast_node *reassociate_stmt(struct ast_node *node) {
+  assert(node);
+
+  switch (node->type) {
+  case AST_VARIABLE_DECL:
+    node->as.variable_decl.initialiser =
+        reassociate_expr(node->as.variable_decl.initialiser);
+    return node;
+
+  case AST_PRINT_STMT:
+    node->as.print_stmt.expr = reassociate_expr(node->as.print_stmt.expr);
+    return node;
+
+  default:
+    return reassociate_expr(node);
+  }
+}
+
+void reassociate(struct ast_node *root) {
+  assert(root && root->type == AST_PROGRAM);
+
+  for (int i = 0; i < root->as.program.num_statements; i++) {
+    root->as.program.statements[i] =
+        reassociate_stmt(root->as.program.statements[i]);
+  }
+}
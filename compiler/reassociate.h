@@ -0,0 +1,8 @@
+#ifndef reassociate_h
+#define reassociate_h
+
+#include "ast.h"
+
+void reassociate(struct ast_node *root);
+
+#endif
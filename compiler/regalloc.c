@@ -0,0 +1,455 @@
+#include <limits.h>
+
+#include "common.h"
+#include "memory.h"
+#include "regalloc.h"
+#include "x86.h"
+
+// Each instruction i reads its operands at position 2i and writes its
+// results at 2i + 1, so a value whose last use is instruction i can share a
+// register with one defined by it. A virtual register's interval spans its
+// first to its last reference. Physical registers named by instructions
+// (idivl's %eax/%edx, call arguments and clobbers) become fixed ranges that
+// no overlapping interval may be assigned.
+//
+// Intervals live across a call prefer callee-saved registers, the rest
+// prefer caller-saved ones so the prologue saves as little as possible. When
+// every register is taken, the interval with the fewest references per
+// position is spilled to its own stack slot.
+
+static const enum x86_reg caller_saved_order[] = {
+    REG_RAX, REG_RCX, REG_RDX, REG_RSI, REG_RDI, REG_R8,
+    REG_R9,  REG_RBX, REG_R12, REG_R13, REG_R14, REG_R15};
+
+static const enum x86_reg callee_saved_order[] = {
+    REG_RBX, REG_R12, REG_R13, REG_R14, REG_R15, REG_RAX,
+    REG_RCX, REG_RDX, REG_RSI, REG_RDI, REG_R8,  REG_R9};
+
+#define NUM_ALLOCATABLE                                                        \
+  ((int)(sizeof(caller_saved_order) / sizeof(caller_saved_order[0])))
+
+struct interval {
+  int vreg;
+  int start;
+  int end;
+  int refs;
+
+  int hint_reg;
+  int hint_vreg;
+  bool crosses_call;
+
+  int reg;
+  int slot;
+};
+
+struct range {
+  int start;
+  int end;
+};
+
+struct fixed {
+  struct range *ranges;
+  int count;
+  int capacity;
+};
+
+struct allocator {
+  struct x86_program *program;
+
+  struct interval *intervals;
+  struct fixed fixed[NUM_REGS];
+
+  int *calls;
+  int num_calls;
+
+  struct interval *active[NUM_ALLOCATABLE];
+  int num_active;
+};
+
+static void fixed_def(struct fixed *fixed, int position) {
+  if (fixed->count == fixed->capacity) {
+    fixed->capacity = fixed->capacity ? fixed->capacity * 2 : 8;
+    fixed->ranges =
+        memory_realloc(MEMORY_REGALLOC, fixed->ranges,
+                       fixed->capacity * sizeof(*fixed->ranges));
+    if (fixed->ranges == NULL)
+      ERROR_OUT();
+  }
+
+  fixed->ranges[fixed->count++] = (struct range){position, position};
+}
+
+static void fixed_use(struct fixed *fixed, int position) {
+  if (fixed->count == 0) {
+    fixed_def(fixed, position);
+    return;
+  }
+
+  if (fixed->ranges[fixed->count - 1].end < position)
+    fixed->ranges[fixed->count - 1].end = position;
+}
+
+// Ranges are disjoint and sorted, so the first one ending at or after start
+// is the only candidate for an overlap.
+static bool fixed_conflicts(struct fixed *fixed, int start, int end) {
+  int lo = 0;
+  int hi = fixed->count;
+
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (fixed->ranges[mid].end < start) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo < fixed->count && fixed->ranges[lo].start <= end;
+}
+
+static void reference(struct interval *interval, int position) {
+  if (position < interval->start)
+    interval->start = position;
+  if (position > interval->end)
+    interval->end = position;
+  interval->refs++;
+}
+
+static void build(struct allocator *allocator) {
+  struct x86_program *program = allocator->program;
+
+  allocator->intervals =
+      memory_alloc(MEMORY_REGALLOC, (program->num_vregs + 1) *
+                                        sizeof(*allocator->intervals));
+  allocator->calls =
+      memory_alloc(MEMORY_REGALLOC, (program->num_instrs + 1) * sizeof(int));
+  if (allocator->intervals == NULL || allocator->calls == NULL)
+    ERROR_OUT();
+
+  for (int i = 0; i < program->num_vregs; i++) {
+    allocator->intervals[i] = (struct interval){.vreg = i,
+                                                .start = INT_MAX,
+                                                .end = -1,
+                                                .refs = 0,
+                                                .hint_reg = -1,
+                                                .hint_vreg = -1,
+                                                .crosses_call = false,
+                                                .reg = -1,
+                                                .slot = -1};
+  }
+
+  struct x86_operand operands[X86_MAX_OPERANDS];
+  int index = 0;
+
+  for (struct x86_instr *instr = program->head; instr;
+       instr = instr->next, index++) {
+    int num_uses = x86_uses(instr, operands);
+    for (int i = 0; i < num_uses; i++) {
+      if (operands[i].type == X86_VREG) {
+        reference(&allocator->intervals[operands[i].value], 2 * index);
+      } else {
+        fixed_use(&allocator->fixed[operands[i].value], 2 * index);
+      }
+    }
+
+    int num_defs = x86_defs(instr, operands);
+    for (int i = 0; i < num_defs; i++) {
+      if (operands[i].type == X86_VREG) {
+        reference(&allocator->intervals[operands[i].value], 2 * index + 1);
+      } else {
+        fixed_def(&allocator->fixed[operands[i].value], 2 * index + 1);
+      }
+    }
+
+    if (instr->op == X86_CALL)
+      allocator->calls[allocator->num_calls++] = 2 * index + 1;
+
+    // Moves suggest giving both sides the same register.
+    if (instr->op == X86_MOV && instr->size == 4) {
+      if (instr->dst.type == X86_VREG && instr->src.type == X86_REG) {
+        allocator->intervals[instr->dst.value].hint_reg = instr->src.value;
+      } else if (instr->dst.type == X86_VREG && instr->src.type == X86_VREG) {
+        allocator->intervals[instr->dst.value].hint_vreg = instr->src.value;
+      } else if (instr->src.type == X86_VREG && instr->dst.type == X86_REG) {
+        struct interval *interval = &allocator->intervals[instr->src.value];
+        if (interval->hint_reg < 0)
+          interval->hint_reg = instr->dst.value;
+      }
+    }
+  }
+
+  for (int i = 0; i < program->num_vregs; i++) {
+    struct interval *interval = &allocator->intervals[i];
+    if (interval->end < 0)
+      continue;
+
+    // First call clobbering after the interval starts.
+    int lo = 0;
+    int hi = allocator->num_calls;
+    while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (allocator->calls[mid] <= interval->start) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+
+    interval->crosses_call =
+        lo < allocator->num_calls && allocator->calls[lo] < interval->end;
+  }
+}
+
+static double weight(struct interval *interval) {
+  return (double)interval->refs / (interval->end - interval->start + 1);
+}
+
+static bool is_free(struct allocator *allocator, struct interval *interval,
+                    int reg) {
+  for (int i = 0; i < allocator->num_active; i++) {
+    if (allocator->active[i]->reg == reg)
+      return false;
+  }
+
+  return !fixed_conflicts(&allocator->fixed[reg], interval->start,
+                          interval->end);
+}
+
+static void activate(struct allocator *allocator, struct interval *interval) {
+  int i = allocator->num_active++;
+  while (i > 0 && allocator->active[i - 1]->end > interval->end) {
+    allocator->active[i] = allocator->active[i - 1];
+    i--;
+  }
+  allocator->active[i] = interval;
+}
+
+static void spill(struct allocator *allocator, struct interval *interval) {
+  interval->reg = -1;
+  interval->slot = allocator->program->num_slots++;
+  allocator->program->num_spills++;
+}
+
+static void allocate(struct allocator *allocator, struct interval *interval) {
+  // Expire intervals that ended before this one starts.
+  int kept = 0;
+  for (int i = 0; i < allocator->num_active; i++) {
+    if (allocator->active[i]->end >= interval->start)
+      allocator->active[kept++] = allocator->active[i];
+  }
+  allocator->num_active = kept;
+
+  int hint = interval->hint_reg;
+  if (hint < 0 && interval->hint_vreg >= 0)
+    hint = allocator->intervals[interval->hint_vreg].reg;
+
+  if (hint >= 0 && hint != REG_SCRATCH_A && hint != REG_SCRATCH_B &&
+      hint != REG_RSP && hint != REG_RBP &&
+      !(interval->crosses_call && x86_is_caller_saved(hint)) &&
+      is_free(allocator, interval, hint)) {
+    interval->reg = hint;
+    activate(allocator, interval);
+    return;
+  }
+
+  const enum x86_reg *order =
+      interval->crosses_call ? callee_saved_order : caller_saved_order;
+
+  for (int i = 0; i < NUM_ALLOCATABLE; i++) {
+    if (is_free(allocator, interval, order[i])) {
+      interval->reg = order[i];
+      activate(allocator, interval);
+      return;
+    }
+  }
+
+  // Steal the register of the cheapest active interval, if it is cheaper
+  // than this one and its register is usable here.
+  int victim = -1;
+  for (int i = 0; i < allocator->num_active; i++) {
+    struct interval *active = allocator->active[i];
+    if (fixed_conflicts(&allocator->fixed[active->reg], interval->start,
+                        interval->end))
+      continue;
+
+    if (victim < 0 || weight(active) < weight(allocator->active[victim]))
+      victim = i;
+  }
+
+  if (victim < 0 || weight(allocator->active[victim]) >= weight(interval)) {
+    spill(allocator, interval);
+    return;
+  }
+
+  struct interval *stolen = allocator->active[victim];
+  interval->reg = stolen->reg;
+  spill(allocator, stolen);
+
+  for (int i = victim; i + 1 < allocator->num_active; i++)
+    allocator->active[i] = allocator->active[i + 1];
+  allocator->num_active--;
+
+  activate(allocator, interval);
+}
+
+static int compare_start(const void *a, const void *b) {
+  const struct interval *x = *(struct interval *const *)a;
+  const struct interval *y = *(struct interval *const *)b;
+
+  if (x->start != y->start)
+    return x->start < y->start ? -1 : 1;
+  return x->vreg - y->vreg;
+}
+
+static void rewrite_operand(struct interval *intervals,
+                            struct x86_operand *operand) {
+  if (operand->type != X86_VREG)
+    return;
+
+  struct interval *interval = &intervals[operand->value];
+  if (interval->reg >= 0) {
+    *operand = X86_REG(interval->reg);
+  } else {
+    assert(interval->slot >= 0);
+    *operand = X86_STACK(interval->slot);
+  }
+}
+
+static bool is_memory(struct x86_operand operand) {
+  return operand.type == X86_STACK;
+}
+
+static void load_before(struct x86_program *program, struct x86_instr *instr,
+                        struct x86_operand *operand, enum x86_reg scratch) {
+  x86_insert_before(program, instr,
+                    x86_new_instr(X86_MOV, 4, *operand, X86_REG(scratch)));
+  *operand = X86_REG(scratch);
+}
+
+static void store_after(struct x86_program *program, struct x86_instr *instr,
+                        struct x86_operand *operand, enum x86_reg scratch) {
+  x86_insert_after(program, instr,
+                   x86_new_instr(X86_MOV, 4, X86_REG(scratch), *operand));
+  *operand = X86_REG(scratch);
+}
+
+// Rewrites instructions whose spilled operands x86 cannot encode, going
+// through the reserved scratch registers.
+static void legalise(struct x86_program *program) {
+  for (struct x86_instr *instr = program->head; instr; instr = instr->next) {
+    switch (instr->op) {
+    case X86_MOV:
+    case X86_ADD:
+    case X86_SUB:
+    case X86_XOR:
+    case X86_TEST:
+      if (is_memory(instr->src) && is_memory(instr->dst))
+        load_before(program, instr, &instr->src, REG_SCRATCH_A);
+      break;
+
+    case X86_IMUL:
+    case X86_CMOVNE:
+      if (is_memory(instr->dst)) {
+        struct x86_operand dst = instr->dst;
+        load_before(program, instr, &instr->dst, REG_SCRATCH_B);
+        instr->dst = dst;
+        store_after(program, instr, &instr->dst, REG_SCRATCH_B);
+      }
+      break;
+
+    case X86_IMUL3:
+      if (is_memory(instr->dst))
+        store_after(program, instr, &instr->dst, REG_SCRATCH_B);
+      break;
+
+    case X86_LEA:
+      if (is_memory(instr->src))
+        load_before(program, instr, &instr->src, REG_SCRATCH_A);
+      if (is_memory(instr->index))
+        load_before(program, instr, &instr->index, REG_SCRATCH_B);
+      if (is_memory(instr->dst))
+        store_after(program, instr, &instr->dst, REG_SCRATCH_B);
+      break;
+
+    default:
+      break;
+    }
+  }
+}
+
+static void rewrite(struct x86_program *program, struct interval *intervals) {
+  for (struct x86_instr *instr = program->head; instr; instr = instr->next) {
+    rewrite_operand(intervals, &instr->src);
+    rewrite_operand(intervals, &instr->dst);
+    rewrite_operand(intervals, &instr->index);
+  }
+
+  for (int i = 0; i < program->num_vregs; i++) {
+    if (intervals[i].reg >= 0)
+      program->used_regs[intervals[i].reg] = true;
+  }
+
+  legalise(program);
+}
+
+void regalloc(struct x86_program *program) {
+  assert(program);
+
+  struct allocator allocator = {.program = program};
+  build(&allocator);
+
+  struct interval **sorted = memory_alloc(
+      MEMORY_REGALLOC, (program->num_vregs + 1) * sizeof(*sorted));
+  if (sorted == NULL)
+    ERROR_OUT();
+
+  int num_sorted = 0;
+  for (int i = 0; i < program->num_vregs; i++) {
+    if (allocator.intervals[i].end >= 0)
+      sorted[num_sorted++] = &allocator.intervals[i];
+  }
+
+  qsort(sorted, num_sorted, sizeof(*sorted), compare_start);
+
+  for (int i = 0; i < num_sorted; i++) {
+    allocate(&allocator, sorted[i]);
+  }
+
+  rewrite(program, allocator.intervals);
+
+  for (int i = 0; i < NUM_REGS; i++)
+    memory_free(allocator.fixed[i].ranges);
+  memory_free(allocator.intervals);
+  memory_free(allocator.calls);
+  memory_free(sorted);
+}
+
+void regalloc_spill_all(struct x86_program *program) {
+  assert(program);
+
+  struct interval *intervals = memory_alloc(
+      MEMORY_REGALLOC, (program->num_vregs + 1) * sizeof(*intervals));
+  if (intervals == NULL)
+    ERROR_OUT();
+
+  for (int i = 0; i < program->num_vregs; i++) {
+    intervals[i].reg = -1;
+    intervals[i].slot = -1;
+  }
+
+  struct x86_operand *fields[3];
+  for (struct x86_instr *instr = program->head; instr; instr = instr->next) {
+    fields[0] = &instr->src;
+    fields[1] = &instr->dst;
+    fields[2] = &instr->index;
+
+    for (int i = 0; i < 3; i++) {
+      if (fields[i]->type == X86_VREG && intervals[fields[i]->value].slot < 0)
+        intervals[fields[i]->value].slot = program->num_slots++;
+    }
+  }
+
+  program->num_spills = program->num_slots;
+  rewrite(program, intervals);
+  memory_free(intervals);
+}
@@ -0,0 +1,13 @@
+#ifndef regalloc_h
+#define regalloc_h
+
+#include "x86.h"
+
+// Linear-scan allocation over live intervals (Poletto & Sarkar, 1999).
+void regalloc(struct x86_program *program);
+
+// Gives every virtual register its own stack slot, as the documented
+// codegen does. Used when the allocator is disabled.
+void regalloc_spill_all(struct x86_program *program);
+
+#endif
@@ -1,7 +1,9 @@
 #include "resolver.h"
 #include "ast.h"
 #include "common.h"
+#include "diagnostics.h"
 #include "symbols.h"
+#include "trace.h"
 
 bool resolver_generate_table(struct ast_node *root, symbol_table_t *table) {
   assert(root);
@@ -10,7 +12,11 @@ bool resolver_generate_table(struct ast_node *root, symbol_table_t *table) {
   switch (root->type) {
   case AST_PROGRAM:
     for (int i = 0; i < root->as.program.num_statements; i++) {
-      if (!resolver_generate_table(root->as.program.statements[i], table))
+      TRACE_BEGIN_STATEMENT("resolve statement", i);
+      bool resolved =
+          resolver_generate_table(root->as.program.statements[i], table);
+      TRACE_END_STATEMENT();
+      if (!resolved)
         return false;
     }
     return true;
@@ -32,25 +38,30 @@ bool resolver_generate_table(struct ast_node *root, symbol_table_t *table) {
   case AST_ASSIGNMENT_STMT:
     if (!symbol_table_get(
             table, &root->as.assignment_stmt.identifier->as.identifier)) {
-      printf("[error] Identifier '%.*s' is undeclared at time of reference.\n",
-             root->as.assignment_stmt.identifier->as.identifier.length,
-             root->as.assignment_stmt.identifier->as.identifier.start);
+      fprintf(diagnostics_out(),
+              "[error] Identifier '%.*s' is undeclared at time of reference.\n",
+              root->as.assignment_stmt.identifier->as.identifier.length,
+              root->as.assignment_stmt.identifier->as.identifier.start);
       return false;
     }
-    return true;
+    return resolver_generate_table(root->as.assignment_stmt.expr, table);
 
   case AST_IDENTIFIER_EXPR:
     if (!symbol_table_get(table, &root->as.identifier)) {
-      printf("[error] Identifier '%.*s' is undeclared at time of reference.\n",
-             root->as.identifier.length, root->as.identifier.start);
+      fprintf(diagnostics_out(),
+              "[error] Identifier '%.*s' is undeclared at time of reference.\n",
+              root->as.identifier.length, root->as.identifier.start);
       return false;
     }
     return true;
 
   case AST_VARIABLE_DECL: {
+    if (!resolver_generate_table(root->as.variable_decl.initialiser, table))
+      return false;
+
     if (symbol_table_get(table, &root->as.variable_decl.name)) {
-      printf("[error] Cannot redeclare variable '%.*s'.\n",
-             root->as.identifier.length, root->as.identifier.start);
+      fprintf(diagnostics_out(), "[error] Cannot redeclare variable '%.*s'.\n",
+              root->as.identifier.length, root->as.identifier.start);
       return false;
     }
 
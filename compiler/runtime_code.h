@@ -0,0 +1,101 @@
+// Generated by tools/embed.c from runtime/ - do not edit.
+#ifndef runtime_code_h
+#define runtime_code_h
+
+// A 32-bit field at `offset` in the code, to be set to the address of the
+// .bss section plus `addend` minus the address of the field.
+struct runtime_reloc {
+  unsigned offset;
+  int addend;
+};
+
+#define RUNTIME_MAIN 0x10
+#define RUNTIME_START 0x0
+
+static const unsigned char runtime_start_code[] = {
+    0x31, 0xed, 0xe8, 0x09, 0x00, 0x00, 0x00, 0xb8, 0x3c, 0x00, 0x00, 0x00,
+    0x31, 0xff, 0x0f, 0x05,
+};
+
+#define RUNTIME_PRINT_I32 0x0
+#define RUNTIME_PRINT_FLUSH 0x110
+#define RUNTIME_PRINT_BOOL 0xb0
+#define RUNTIME_PRINT_INIT 0x150
+#define RUNTIME_PRINT_BSS_SIZE 0x10008
+
+static const unsigned char runtime_print_code[] = {
+    0x48, 0x8b, 0x0d, 0x00, 0x00, 0x00, 0x00, 0x48, 0x81, 0xf9, 0xf0, 0xff,
+    0x00, 0x00, 0x0f, 0x87, 0x86, 0x00, 0x00, 0x00, 0x89, 0xf8, 0xf7, 0xd8,
+    0x0f, 0x48, 0xc7, 0x48, 0x8d, 0x74, 0x24, 0xff, 0xc6, 0x06, 0x0a, 0x4c,
+    0x8d, 0x05, 0xd6, 0x01, 0x00, 0x00, 0x83, 0xf8, 0x64, 0x72, 0x28, 0x89,
+    0xc2, 0x48, 0x69, 0xd2, 0x1f, 0x85, 0xeb, 0x51, 0x48, 0xc1, 0xea, 0x25,
+    0x44, 0x6b, 0xca, 0x64, 0x44, 0x29, 0xc8, 0x45, 0x0f, 0xb7, 0x0c, 0x40,
+    0x48, 0x83, 0xee, 0x02, 0x66, 0x44, 0x89, 0x0e, 0x89, 0xd0, 0x83, 0xf8,
+    0x64, 0x73, 0xd8, 0x45, 0x0f, 0xb7, 0x0c, 0x40, 0x48, 0x83, 0xee, 0x02,
+    0x66, 0x44, 0x89, 0x0e, 0x83, 0xf8, 0x0a, 0x48, 0x83, 0xd6, 0x00, 0xc6,
+    0x46, 0xff, 0x2d, 0x48, 0x63, 0xc7, 0x48, 0xc1, 0xf8, 0x3f, 0x48, 0x01,
+    0xc6, 0xf3, 0x0f, 0x6f, 0x06, 0x48, 0x8d, 0x15, 0x00, 0x00, 0x00, 0x00,
+    0xf3, 0x0f, 0x7f, 0x04, 0x0a, 0x48, 0x89, 0xe0, 0x48, 0x29, 0xf0, 0x48,
+    0x01, 0xc1, 0x48, 0x89, 0x0d, 0x00, 0x00, 0x00, 0x00, 0xc3, 0x57, 0xe8,
+    0x70, 0x00, 0x00, 0x00, 0x5f, 0x31, 0xc9, 0xe9, 0x6c, 0xff, 0xff, 0xff,
+    0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x0d, 0x00,
+    0x00, 0x00, 0x00, 0x48, 0x81, 0xf9, 0xf0, 0xff, 0x00, 0x00, 0x77, 0x3c,
+    0x48, 0x8d, 0x05, 0x25, 0x01, 0x00, 0x00, 0x48, 0x8d, 0x15, 0x16, 0x01,
+    0x00, 0x00, 0xbe, 0x06, 0x00, 0x00, 0x00, 0x41, 0xb8, 0x05, 0x00, 0x00,
+    0x00, 0x85, 0xff, 0x48, 0x0f, 0x45, 0xc2, 0x41, 0x0f, 0x45, 0xf0, 0x48,
+    0x8b, 0x10, 0x48, 0x8d, 0x05, 0x00, 0x00, 0x00, 0x00, 0x48, 0x89, 0x14,
+    0x08, 0x48, 0x01, 0xf1, 0x48, 0x89, 0x0d, 0x00, 0x00, 0x00, 0x00, 0xc3,
+    0x57, 0xe8, 0x0e, 0x00, 0x00, 0x00, 0x5f, 0x31, 0xc9, 0xeb, 0xb9, 0x66,
+    0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x15, 0x00,
+    0x00, 0x00, 0x00, 0x48, 0x8d, 0x35, 0x00, 0x00, 0x00, 0x00, 0x48, 0x85,
+    0xd2, 0x74, 0x19, 0xb8, 0x01, 0x00, 0x00, 0x00, 0xbf, 0x01, 0x00, 0x00,
+    0x00, 0x0f, 0x05, 0x48, 0x85, 0xc0, 0x7e, 0x08, 0x48, 0x01, 0xc6, 0x48,
+    0x29, 0xc2, 0xeb, 0xe2, 0x48, 0xc7, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xc3, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x48, 0x8d, 0x05, 0x39, 0x00, 0x00, 0x00, 0x48, 0x89, 0x44, 0x24, 0xe0,
+    0x48, 0xc7, 0x44, 0x24, 0xe8, 0x00, 0x00, 0x00, 0x04, 0x48, 0x89, 0x44,
+    0x24, 0xf0, 0x48, 0xc7, 0x44, 0x24, 0xf8, 0x00, 0x00, 0x00, 0x00, 0xb8,
+    0x0d, 0x00, 0x00, 0x00, 0xbf, 0x08, 0x00, 0x00, 0x00, 0x48, 0x8d, 0x74,
+    0x24, 0xe0, 0x31, 0xd2, 0x41, 0xba, 0x08, 0x00, 0x00, 0x00, 0x0f, 0x05,
+    0xc3, 0x0f, 0x1f, 0x00, 0xe8, 0x7b, 0xff, 0xff, 0xff, 0xb8, 0x01, 0x00,
+    0x00, 0x00, 0xbf, 0x02, 0x00, 0x00, 0x00, 0x48, 0x8d, 0x35, 0x13, 0x00,
+    0x00, 0x00, 0xba, 0x2b, 0x00, 0x00, 0x00, 0x0f, 0x05, 0xb8, 0xe7, 0x00,
+    0x00, 0x00, 0xbf, 0x01, 0x00, 0x00, 0x00, 0x0f, 0x05, 0x5b, 0x65, 0x72,
+    0x72, 0x6f, 0x72, 0x5d, 0x20, 0x54, 0x68, 0x65, 0x20, 0x70, 0x72, 0x6f,
+    0x67, 0x72, 0x61, 0x6d, 0x20, 0x74, 0x72, 0x61, 0x70, 0x70, 0x65, 0x64,
+    0x20, 0x6f, 0x6e, 0x20, 0x61, 0x20, 0x64, 0x69, 0x76, 0x69, 0x73, 0x69,
+    0x6f, 0x6e, 0x2e, 0x0a, 0x74, 0x72, 0x75, 0x65, 0x0a, 0x00, 0x00, 0x00,
+    0x66, 0x61, 0x6c, 0x73, 0x65, 0x0a, 0x00, 0x00, 0x66, 0x66, 0x2e, 0x0f,
+    0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x90, 0x30, 0x30, 0x30, 0x31,
+    0x30, 0x32, 0x30, 0x33, 0x30, 0x34, 0x30, 0x35, 0x30, 0x36, 0x30, 0x37,
+    0x30, 0x38, 0x30, 0x39, 0x31, 0x30, 0x31, 0x31, 0x31, 0x32, 0x31, 0x33,
+    0x31, 0x34, 0x31, 0x35, 0x31, 0x36, 0x31, 0x37, 0x31, 0x38, 0x31, 0x39,
+    0x32, 0x30, 0x32, 0x31, 0x32, 0x32, 0x32, 0x33, 0x32, 0x34, 0x32, 0x35,
+    0x32, 0x36, 0x32, 0x37, 0x32, 0x38, 0x32, 0x39, 0x33, 0x30, 0x33, 0x31,
+    0x33, 0x32, 0x33, 0x33, 0x33, 0x34, 0x33, 0x35, 0x33, 0x36, 0x33, 0x37,
+    0x33, 0x38, 0x33, 0x39, 0x34, 0x30, 0x34, 0x31, 0x34, 0x32, 0x34, 0x33,
+    0x34, 0x34, 0x34, 0x35, 0x34, 0x36, 0x34, 0x37, 0x34, 0x38, 0x34, 0x39,
+    0x35, 0x30, 0x35, 0x31, 0x35, 0x32, 0x35, 0x33, 0x35, 0x34, 0x35, 0x35,
+    0x35, 0x36, 0x35, 0x37, 0x35, 0x38, 0x35, 0x39, 0x36, 0x30, 0x36, 0x31,
+    0x36, 0x32, 0x36, 0x33, 0x36, 0x34, 0x36, 0x35, 0x36, 0x36, 0x36, 0x37,
+    0x36, 0x38, 0x36, 0x39, 0x37, 0x30, 0x37, 0x31, 0x37, 0x32, 0x37, 0x33,
+    0x37, 0x34, 0x37, 0x35, 0x37, 0x36, 0x37, 0x37, 0x37, 0x38, 0x37, 0x39,
+    0x38, 0x30, 0x38, 0x31, 0x38, 0x32, 0x38, 0x33, 0x38, 0x34, 0x38, 0x35,
+    0x38, 0x36, 0x38, 0x37, 0x38, 0x38, 0x38, 0x39, 0x39, 0x30, 0x39, 0x31,
+    0x39, 0x32, 0x39, 0x33, 0x39, 0x34, 0x39, 0x35, 0x39, 0x36, 0x39, 0x37,
+    0x39, 0x38, 0x39, 0x39,
+};
+
+static const struct runtime_reloc runtime_print_relocs[] = {
+    {0x3, 65532},
+    {0x80, -4},
+    {0x95, 65532},
+    {0xb3, 65532},
+    {0xe9, -4},
+    {0xf7, 65532},
+    {0x113, 65532},
+    {0x11a, -4},
+    {0x13f, 65528},
+};
+
+#endif
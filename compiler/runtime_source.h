@@ -0,0 +1,187 @@
+// Generated by tools/embed.c from runtime/ - do not edit.
+#ifndef runtime_source_h
+#define runtime_source_h
+
+static const char runtime_print_source[] =
+    "# Print runtime of the generated code: appends lines to a 64 KiB buffer and\n"
+    "# writes it to stdout with write(2) when the next line may not fit and when\n"
+    "# main returns (the epilogue calls print_flush). Assembled and embedded into\n"
+    "# compiler/runtime_code.h and compiler/runtime_source.h by\n"
+    "#\n"
+    "#   make runtime-code\n"
+    "#\n"
+    "# The code follows main in .text and is called directly; nothing here is\n"
+    "# global, so the same text links into an object, a freestanding executable\n"
+    "# or the output of -S. Only the .bss references need relocating. Clobbers\n"
+    "# what a System V call may, and uses the red zone below %rsp for digits.\n"
+    "\n"
+    "\t.set capacity, 65536\n"
+    "\n"
+    "\t# Longest line either function appends, rounded up to the 16 bytes\n"
+    "\t# print_i32 copies at once.\n"
+    "\t.set max_line, 16\n"
+    "\n"
+    "\t.bss\n"
+    "\t.balign 16\n"
+    "buffer:\n"
+    "\t.zero capacity\n"
+    "length:\n"
+    "\t.zero 8\n"
+    "\n"
+    "\t.text\n"
+    "\t# Filled with int3, the padding compiler/object.c writes after main (GAS\n"
+    "\t# would pick its own multi-byte nops for the default fill).\n"
+    "\t.p2align 4, 0xcc\n"
+    "# print_i32(value): the decimal value and a newline. Two digits at a time\n"
+    "# from `.Lpairs`, backwards into the red zone, then copied with one 16-byte\n"
+    "# move.\n"
+    "print_i32:\n"
+    "\tmovq length(%rip), %rcx\n"
+    "\tcmpq $capacity - max_line, %rcx\n"
+    "\tja 4f\n"
+    "1:\n"
+    "\tmovl %edi, %eax\n"
+    "\tnegl %eax\n"
+    "\tcmovsl %edi, %eax             # |value|, INT_MIN as 2^31 unsigned\n"
+    "\tleaq -1(%rsp), %rsi\n"
+    "\tmovb $'\\n', (%rsi)\n"
+    "\tleaq .Lpairs(%rip), %r8\n"
+    "\tcmpl $100, %eax\n"
+    "\tjb 3f\n"
+    "2:\n"
+    "\tmovl %eax, %edx\n"
+    "\timulq $0x51eb851f, %rdx, %rdx\n"
+    "\tshrq $37, %rdx                # value / 100\n"
+    "\timull $100, %edx, %r9d\n"
+    "\tsubl %r9d, %eax               # value % 100\n"
+    "\tmovzwl (%r8,%rax,2), %r9d\n"
+    "\tsubq $2, %rsi\n"
+    "\tmovw %r9w, (%rsi)\n"
+    "\tmovl %edx, %eax\n"
+    "\tcmpl $100, %eax\n"
+    "\tjae 2b\n"
+    "3:\n"
+    "\t# Below 100: a pair, skipping its leading '0' below 10.\n"
+    "\tmovzwl (%r8,%rax,2), %r9d\n"
+    "\tsubq $2, %rsi\n"
+    "\tmovw %r9w, (%rsi)\n"
+    "\tcmpl $10, %eax\n"
+    "\tadcq $0, %rsi\n"
+    "\t# The sign, kept only for negative values.\n"
+    "\tmovb $'-', -1(%rsi)\n"
+    "\tmovslq %edi, %rax\n"
+    "\tsarq $63, %rax\n"
+    "\taddq %rax, %rsi\n"
+    "\tmovdqu (%rsi), %xmm0\n"
+    "\tleaq buffer(%rip), %rdx\n"
+    "\tmovdqu %xmm0, (%rdx,%rcx)\n"
+    "\tmovq %rsp, %rax\n"
+    "\tsubq %rsi, %rax\n"
+    "\taddq %rax, %rcx\n"
+    "\tmovq %rcx, length(%rip)\n"
+    "\tret\n"
+    "4:\n"
+    "\tpushq %rdi\n"
+    "\tcall print_flush\n"
+    "\tpopq %rdi\n"
+    "\txorl %ecx, %ecx\n"
+    "\tjmp 1b\n"
+    "\n"
+    "\t.p2align 4\n"
+    "# print_bool(value): \"true\" or \"false\" and a newline, selected without a\n"
+    "# branch and copied with one 8-byte move.\n"
+    "print_bool:\n"
+    "\tmovq length(%rip), %rcx\n"
+    "\tcmpq $capacity - max_line, %rcx\n"
+    "\tja 2f\n"
+    "1:\n"
+    "\tleaq .Lfalse(%rip), %rax\n"
+    "\tleaq .Ltrue(%rip), %rdx\n"
+    "\tmovl $6, %esi\n"
+    "\tmovl $5, %r8d\n"
+    "\ttestl %edi, %edi\n"
+    "\tcmovneq %rdx, %rax\n"
+    "\tcmovnel %r8d, %esi\n"
+    "\tmovq (%rax), %rdx\n"
+    "\tleaq buffer(%rip), %rax\n"
+    "\tmovq %rdx, (%rax,%rcx)\n"
+    "\taddq %rsi, %rcx\n"
+    "\tmovq %rcx, length(%rip)\n"
+    "\tret\n"
+    "2:\n"
+    "\tpushq %rdi\n"
+    "\tcall print_flush\n"
+    "\tpopq %rdi\n"
+    "\txorl %ecx, %ecx\n"
+    "\tjmp 1b\n"
+    "\n"
+    "\t.p2align 4\n"
+    "# print_flush(): write(1, buffer, length) until everything is written or an\n"
+    "# error occurs, then empties the buffer.\n"
+    "print_flush:\n"
+    "\tmovq length(%rip), %rdx\n"
+    "\tleaq buffer(%rip), %rsi\n"
+    "1:\n"
+    "\ttestq %rdx, %rdx\n"
+    "\tjz 2f\n"
+    "\tmovl $1, %eax                 # write\n"
+    "\tmovl $1, %edi\n"
+    "\tsyscall\n"
+    "\ttestq %rax, %rax\n"
+    "\tjle 2f\n"
+    "\taddq %rax, %rsi\n"
+    "\tsubq %rax, %rdx\n"
+    "\tjmp 1b\n"
+    "2:\n"
+    "\tmovq $0, length(%rip)\n"
+    "\tret\n"
+    "\n"
+    "\t.p2align 4\n"
+    "# print_init(): installs .Ltrap as the SIGFPE handler, called first by a main\n"
+    "# that divides. The sigaction is built in the red zone.\n"
+    "print_init:\n"
+    "\tleaq .Ltrap(%rip), %rax\n"
+    "\tmovq %rax, -32(%rsp)          # handler\n"
+    "\tmovq $0x04000000, -24(%rsp)   # flags: SA_RESTORER, which x86-64 requires\n"
+    "\tmovq %rax, -16(%rsp)          # restorer, never reached: .Ltrap exits\n"
+    "\tmovq $0, -8(%rsp)             # mask\n"
+    "\tmovl $13, %eax                # rt_sigaction\n"
+    "\tmovl $8, %edi                 # SIGFPE\n"
+    "\tleaq -32(%rsp), %rsi\n"
+    "\txorl %edx, %edx\n"
+    "\tmovl $8, %r10d                # sizeof(sigset_t)\n"
+    "\tsyscall\n"
+    "\tret\n"
+    "\n"
+    "\t.p2align 4\n"
+    "# .Ltrap(signal): a division trapped. Writes what is buffered and the error\n"
+    "# --run reports, then exits with status 1 as --run does.\n"
+    ".Ltrap:\n"
+    "\tcall print_flush\n"
+    "\tmovl $1, %eax                 # write\n"
+    "\tmovl $2, %edi\n"
+    "\tleaq .Ltrapped(%rip), %rsi\n"
+    "\tmovl $.Ltrapped_end - .Ltrapped, %edx\n"
+    "\tsyscall\n"
+    "\tmovl $231, %eax               # exit_group(1)\n"
+    "\tmovl $1, %edi\n"
+    "\tsyscall\n"
+    "\n"
+    ".Ltrapped:\n"
+    "\t.ascii \"[error] The program trapped on a division.\\n\"\n"
+    ".Ltrapped_end:\n"
+    ".Ltrue:\n"
+    "\t.ascii \"true\\n\\0\\0\\0\"\n"
+    ".Lfalse:\n"
+    "\t.ascii \"false\\n\\0\\0\"\n"
+    "\n"
+    "# \"00\", \"01\", ..., \"99\".\n"
+    "\t.p2align 4\n"
+    ".Lpairs:\n"
+    "\t.irp tens, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9\n"
+    "\t.irp ones, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9\n"
+    "\t.ascii \"\\tens\\ones\"\n"
+    "\t.endr\n"
+    "\t.endr\n";
+
+#endif
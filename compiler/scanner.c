@@ -1,6 +1,7 @@
 #include <string.h>
 
 #include "common.h"
+#include "memory.h"
 #include "scanner.h"
 
 struct scanner_t {
@@ -12,7 +13,8 @@ struct scanner_t {
 scanner_t *scanner_new(const char *source) {
   assert(source);
 
-  scanner_t *scanner = (scanner_t *)malloc(sizeof(*scanner));
+  scanner_t *scanner =
+      (scanner_t *)memory_alloc(MEMORY_SCANNER, sizeof(*scanner));
   if (scanner == NULL) {
     ERROR_OUT();
   }
@@ -27,7 +29,7 @@ scanner_t *scanner_new(const char *source) {
 void scanner_free(scanner_t **scanner) {
   assert(scanner && *scanner);
 
-  free(*scanner);
+  memory_free(*scanner);
   *scanner = NULL;
 }
 
@@ -80,12 +82,6 @@ static char peek(scanner_t *scanner) {
   return *scanner->current;
 }
 
-static char previous(scanner_t *scanner) {
-  assert(scanner);
-
-  return *(scanner->current - 1);
-}
-
 static char advance(scanner_t *scanner) {
   assert(scanner);
   assert(!is_at_end(scanner));
@@ -159,7 +155,7 @@ static enum scanner_token_type identifier_type(scanner_t *scanner) {
 
 static struct scanner_token number(scanner_t *scanner) {
   assert(scanner);
-  assert(is_digit(previous(scanner)));
+  assert(is_digit(scanner->current[-1]));
 
   while (is_digit(peek(scanner))) {
     advance(scanner);
@@ -0,0 +1,449 @@
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "compiler.h"
+#include "diagnostics.h"
+#include "memory.h"
+#include "passes.h"
+#include "server.h"
+
+// A request is a request header, the toggled passes one after the other,
+// each a '+' or '-' and the name of the pass ending in a NUL, and then the
+// source. A reply is a reply header, the output and the diagnostics. Both
+// ends run on the same machine, so integers are in its byte order; the
+// version tells a server from a client built from other sources.
+#define SERVER_VERSION 1
+
+#define MAX_PASSES 64
+#define MAX_PASSES_SIZE 4096
+
+// Of each connection's thread, whatever the limit of the process: a compile
+// at the parser's deepest nesting needs under 2 MiB.
+#define CONNECTION_STACK_SIZE ((size_t)8 << 20)
+
+// Checked before anything is allocated for a request, so that a size near
+// SIZE_MAX cannot wrap once the passes and the block header are added.
+#define MAX_SOURCE_SIZE ((uint64_t)256 << 20)
+
+struct request_header {
+  uint32_t version;
+  uint32_t output;
+  uint32_t opt_level;
+  uint32_t num_passes;
+  uint64_t passes_size;
+  uint64_t src_size;
+};
+
+struct reply_header {
+  uint32_t ok;
+  uint32_t reserved;
+  uint64_t output_size;
+  uint64_t diagnostics_size;
+};
+
+struct server {
+  int listener;
+
+  // The contexts not in use. A request takes one until its reply is sent,
+  // and waits for one while all are taken.
+  pthread_mutex_t lock;
+  pthread_cond_t returned;
+  compiler_context_t **contexts;
+  int num_free;
+};
+
+struct connection {
+  struct server *server;
+  int fd;
+
+  // What the last request carried after its header, grown as needed.
+  char *buffer;
+  size_t capacity;
+};
+
+// Send and receive all of size bytes, or fail: when the other end closed
+// the connection, also before the first byte.
+static bool send_all(int fd, const void *data, size_t size) {
+  const char *bytes = data;
+  while (size > 0) {
+    ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR)
+      continue;
+    if (sent <= 0)
+      return false;
+    bytes += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+static bool receive_all(int fd, void *data, size_t size) {
+  char *bytes = data;
+  while (size > 0) {
+    ssize_t received = recv(fd, bytes, size, 0);
+    if (received < 0 && errno == EINTR)
+      continue;
+    if (received <= 0)
+      return false;
+    bytes += received;
+    size -= received;
+  }
+  return true;
+}
+
+static bool send_reply(int fd, bool ok, const char *output,
+                       size_t output_size, const char *diagnostics,
+                       size_t diagnostics_size) {
+  struct reply_header header = {
+      .ok = ok,
+      .output_size = output_size,
+      .diagnostics_size = diagnostics_size,
+  };
+  return send_all(fd, &header, sizeof(header)) &&
+         send_all(fd, output, output_size) &&
+         send_all(fd, diagnostics, diagnostics_size);
+}
+
+// The request failed before it could be compiled. What is left of it is
+// not read, so the connection ends.
+static bool refuse(int fd, const char *diagnostics) {
+  send_reply(fd, false, NULL, 0, diagnostics, strlen(diagnostics));
+  return false;
+}
+
+// Reads the toggles of a request into passes. False if they do not match
+// the header.
+static bool read_passes(const char *names, size_t size, int num_passes,
+                        struct compiler_pass *passes) {
+  const char *end = names + size;
+  for (int i = 0; i < num_passes; i++) {
+    const char *nul = memchr(names, '\0', end - names);
+    if (nul == NULL || nul - names < 2 ||
+        (names[0] != '+' && names[0] != '-'))
+      return false;
+
+    passes[i] = (struct compiler_pass){names + 1, names[0] == '+'};
+    names = nul + 1;
+  }
+  return names == end;
+}
+
+// Serves one request of the connection. False once the connection ends.
+static bool serve(struct connection *connection) {
+  int fd = connection->fd;
+  struct request_header header;
+  if (!receive_all(fd, &header, sizeof(header)))
+    return false;
+
+  if (header.version != SERVER_VERSION)
+    return refuse(fd, "[error] The client and the server were built from "
+                      "different sources.\n");
+  if (header.output > COMPILER_OUTPUT_RUN ||
+      header.opt_level > MAX_OPT_LEVEL || header.num_passes > MAX_PASSES ||
+      header.passes_size > MAX_PASSES_SIZE)
+    return refuse(fd, "[error] The request is malformed.\n");
+  if (header.src_size > MAX_SOURCE_SIZE)
+    return refuse(fd, "[error] The source is larger than the server "
+                      "accepts.\n");
+
+  size_t size = header.passes_size + header.src_size;
+  if (size > connection->capacity) {
+    char *buffer = memory_realloc(MEMORY_SERVER, connection->buffer, size);
+    if (buffer == NULL)
+      return refuse(fd, "[error] Out of memory for the request.\n");
+    connection->buffer = buffer;
+    connection->capacity = size;
+  }
+  if (!receive_all(fd, connection->buffer, size))
+    return false;
+
+  struct compiler_pass passes[MAX_PASSES];
+  if (!read_passes(connection->buffer, header.passes_size, header.num_passes,
+                   passes))
+    return refuse(fd, "[error] The request is malformed.\n");
+
+  struct compiler_options options = {
+      .output = header.output,
+      .opt_level = header.opt_level,
+      .passes = passes,
+      .num_passes = header.num_passes,
+  };
+
+  struct server *server = connection->server;
+  pthread_mutex_lock(&server->lock);
+  while (server->num_free == 0)
+    pthread_cond_wait(&server->returned, &server->lock);
+  compiler_context_t *context = server->contexts[--server->num_free];
+  pthread_mutex_unlock(&server->lock);
+
+  bool ok =
+      compiler_compile(context, connection->buffer + header.passes_size,
+                       header.src_size, &options);
+
+  size_t output_size, diagnostics_size;
+  const char *output = compiler_output(context, &output_size);
+  const char *diagnostics = compiler_diagnostics(context, &diagnostics_size);
+  bool sent = send_reply(fd, ok, output, output_size, diagnostics,
+                         diagnostics_size);
+
+  pthread_mutex_lock(&server->lock);
+  server->contexts[server->num_free++] = context;
+  pthread_cond_signal(&server->returned);
+  pthread_mutex_unlock(&server->lock);
+  return sent;
+}
+
+static void *work(void *arg) {
+  struct connection *connection = arg;
+
+  while (serve(connection))
+    ;
+
+  close(connection->fd);
+  memory_free(connection->buffer);
+  memory_free(connection);
+  return NULL;
+}
+
+static bool socket_address(const char *path, struct sockaddr_un *address) {
+  *address = (struct sockaddr_un){.sun_family = AF_UNIX};
+  if (strlen(path) >= sizeof(address->sun_path)) {
+    fprintf(diagnostics_out(), "[error] The socket path '%s' is too long.\n",
+            path);
+    return false;
+  }
+
+  strcpy(address->sun_path, path);
+  return true;
+}
+
+// A socket left behind by a server that ended without removing it refuses
+// connections, and is replaced; one that accepts them is another server's.
+static bool listen_at(const char *path, int *listener) {
+  struct sockaddr_un address;
+  if (!socket_address(path, &address))
+    return false;
+
+  int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (probe < 0 || fd < 0) {
+    fprintf(diagnostics_out(), "[error] Could not create a socket: %s.\n",
+            strerror(errno));
+    goto fail;
+  }
+
+  if (connect(probe, (struct sockaddr *)&address, sizeof(address)) == 0) {
+    fprintf(diagnostics_out(),
+            "[error] A server is already listening at '%s'.\n", path);
+    goto fail;
+  }
+
+  struct stat status;
+  if (errno == ECONNREFUSED && stat(path, &status) == 0 &&
+      S_ISSOCK(status.st_mode))
+    unlink(path);
+
+  if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    fprintf(diagnostics_out(), "[error] Could not listen at '%s': %s.\n",
+            path, strerror(errno));
+    goto fail;
+  }
+
+  close(probe);
+  *listener = fd;
+  return true;
+
+fail:
+  if (probe >= 0)
+    close(probe);
+  if (fd >= 0)
+    close(fd);
+  return false;
+}
+
+// Gives each connection a thread of its own, so that a connection a client
+// keeps open holds no context while it waits.
+static void *accept_connections(void *arg) {
+  struct server *server = arg;
+
+  pthread_attr_t detached;
+  pthread_attr_init(&detached);
+  pthread_attr_setdetachstate(&detached, PTHREAD_CREATE_DETACHED);
+  pthread_attr_setstacksize(&detached, CONNECTION_STACK_SIZE);
+
+  for (;;) {
+    int fd = accept(server->listener, NULL, NULL);
+    if (fd < 0) {
+      // Until a connection closes, there is no descriptor to accept with.
+      if (errno == EMFILE || errno == ENFILE)
+        usleep(10000);
+      continue;
+    }
+
+    // Without memory or a thread, only this client is turned away.
+    struct connection *connection =
+        memory_calloc(MEMORY_SERVER, 1, sizeof(*connection));
+    pthread_t thread;
+    if (connection == NULL) {
+      close(fd);
+      continue;
+    }
+
+    *connection = (struct connection){.server = server, .fd = fd};
+    if (pthread_create(&thread, &detached, work, connection) != 0) {
+      close(fd);
+      memory_free(connection);
+    }
+  }
+
+  return NULL;
+}
+
+bool server_run(const char *path, int num_workers) {
+  assert(path && num_workers > 0);
+
+  struct server server = {.num_free = num_workers};
+  if (!listen_at(path, &server.listener))
+    return false;
+
+  server.contexts =
+      memory_alloc(MEMORY_SERVER, num_workers * sizeof(*server.contexts));
+  if (server.contexts == NULL)
+    ERROR_OUT();
+  for (int i = 0; i < num_workers; i++) {
+    server.contexts[i] = compiler_context_new();
+    if (server.contexts[i] == NULL)
+      ERROR_OUT();
+  }
+  pthread_mutex_init(&server.lock, NULL);
+  pthread_cond_init(&server.returned, NULL);
+
+  // Only this thread takes the signals that end the server; the others
+  // inherit the mask.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+  pthread_t acceptor;
+  if (pthread_create(&acceptor, NULL, accept_connections, &server) != 0)
+    ERROR_OUT();
+
+  int received;
+  sigwait(&signals, &received);
+
+  // Compiles still running end with the process; new clients find no
+  // socket.
+  unlink(path);
+  return true;
+}
+
+int server_connect(const char *path) {
+  struct sockaddr_un address;
+  if (!socket_address(path, &address))
+    return -1;
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd >= 0 &&
+      connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0)
+    return fd;
+
+  fprintf(diagnostics_out(), "[error] Could not connect to '%s': %s.\n",
+          path, strerror(errno));
+  if (fd >= 0)
+    close(fd);
+  return -1;
+}
+
+// Size bytes from the connection, ending in a NUL. NULL if the connection
+// broke.
+static char *receive_text(int fd, size_t size) {
+  char *text = memory_alloc(MEMORY_SERVER, size + 1);
+  if (text == NULL)
+    ERROR_OUT();
+
+  if (!receive_all(fd, text, size)) {
+    memory_free(text);
+    return NULL;
+  }
+  text[size] = '\0';
+  return text;
+}
+
+bool server_compile(int connection, const char *src, size_t size,
+                    const struct compiler_options *options,
+                    struct server_reply *reply) {
+  assert(connection >= 0 && src && options && reply);
+
+  if (size > MAX_SOURCE_SIZE) {
+    fprintf(diagnostics_out(), "[error] The source is too large to send.\n");
+    return false;
+  }
+
+  char passes[MAX_PASSES_SIZE];
+  size_t passes_size = 0;
+  for (int i = 0; i < options->num_passes; i++) {
+    const struct compiler_pass *pass = &options->passes[i];
+    size_t length = strlen(pass->name) + 1;
+    if (i == MAX_PASSES || passes_size + 1 + length > sizeof(passes)) {
+      fprintf(diagnostics_out(), "[error] Too many passes to send.\n");
+      return false;
+    }
+
+    passes[passes_size++] = pass->enabled ? '+' : '-';
+    memcpy(passes + passes_size, pass->name, length);
+    passes_size += length;
+  }
+
+  struct request_header request = {
+      .version = SERVER_VERSION,
+      .output = options->output,
+      .opt_level = options->opt_level,
+      .num_passes = options->num_passes,
+      .passes_size = passes_size,
+      .src_size = size,
+  };
+  struct reply_header header;
+  if (!send_all(connection, &request, sizeof(request)) ||
+      !send_all(connection, passes, passes_size) ||
+      !send_all(connection, src, size) ||
+      !receive_all(connection, &header, sizeof(header))) {
+    fprintf(diagnostics_out(), "[error] The server closed the connection.\n");
+    return false;
+  }
+
+  char *output = receive_text(connection, header.output_size);
+  char *diagnostics =
+      output ? receive_text(connection, header.diagnostics_size) : NULL;
+  if (diagnostics == NULL) {
+    memory_free(output);
+    fprintf(diagnostics_out(), "[error] The server closed the connection.\n");
+    return false;
+  }
+
+  *reply = (struct server_reply){
+      .ok = header.ok,
+      .output = output,
+      .output_size = header.output_size,
+      .diagnostics = diagnostics,
+      .diagnostics_size = header.diagnostics_size,
+  };
+  return true;
+}
+
+void server_reply_free(struct server_reply *reply) {
+  assert(reply);
+
+  memory_free(reply->output);
+  memory_free(reply->diagnostics);
+  *reply = (struct server_reply){0};
+}
@@ -0,0 +1,44 @@
+#ifndef server_h
+#define server_h
+
+#include "common.h"
+#include "compiler.h"
+
+// A compiler that stays running and compiles what clients send over a Unix
+// domain socket, for callers that compile often and would otherwise pay for
+// starting a process with cold caches and an empty heap on every file. A
+// request carries the source and the options; the reply carries what
+// compiler_compile left: whether it succeeded, the output and the
+// diagnostics.
+
+// Listens at path and compiles up to num_workers requests at a time, each
+// with one of as many compiler contexts that are kept from one request to
+// the next. A client may send any number of requests on a connection.
+// Returns once the process receives SIGINT or SIGTERM, having removed the
+// socket, or false at once if it could not listen.
+bool server_run(const char *path, int num_workers);
+
+struct server_reply {
+  bool ok;
+
+  // Allocated, each ending in a NUL that size does not count.
+  char *output;
+  size_t output_size;
+  char *diagnostics;
+  size_t diagnostics_size;
+};
+
+// A connection to the server listening at path, to be closed with close(2),
+// or -1 if there is none.
+int server_connect(const char *path);
+
+// Sends one compile on the connection and waits for the reply. Returns
+// false, leaving reply untouched, if the connection broke or the source is
+// over the 256 MiB a server accepts.
+bool server_compile(int connection, const char *src, size_t size,
+                    const struct compiler_options *options,
+                    struct server_reply *reply);
+
+void server_reply_free(struct server_reply *reply);
+
+#endif
@@ -0,0 +1,146 @@
+#include "memory.h"
+#include "slots.h"
+#include "common.h"
+#include "x86.h"
+
+// A slot lives from the first to the last instruction referring to it. Two
+// slots can share storage when one's last reference comes strictly before
+// the other's first, which also keeps a slot read and another written by the
+// same instruction apart. Slots are visited in order of first reference and
+// take the colour most recently freed by an expired slot, or a new one.
+//
+// x86_frame() still rounds the frame up to keep %rsp 16-byte aligned.
+
+struct lifetime {
+  int slot;
+  int first;
+  int last;
+};
+
+struct heap {
+  struct lifetime *items;
+  int count;
+};
+
+static void heap_push(struct heap *heap, struct lifetime item) {
+  int i = heap->count++;
+  while (i > 0 && heap->items[(i - 1) / 2].last > item.last) {
+    heap->items[i] = heap->items[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  heap->items[i] = item;
+}
+
+static struct lifetime heap_pop(struct heap *heap) {
+  struct lifetime top = heap->items[0];
+  struct lifetime last = heap->items[--heap->count];
+
+  int i = 0;
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= heap->count)
+      break;
+    if (child + 1 < heap->count &&
+        heap->items[child + 1].last < heap->items[child].last)
+      child++;
+    if (heap->items[child].last >= last.last)
+      break;
+
+    heap->items[i] = heap->items[child];
+    i = child;
+  }
+
+  if (heap->count > 0)
+    heap->items[i] = last;
+  return top;
+}
+
+static void touch(struct lifetime *lifetimes, struct x86_operand operand,
+                  int index) {
+  if (operand.type != X86_STACK)
+    return;
+
+  struct lifetime *lifetime = &lifetimes[operand.value];
+  if (lifetime->first < 0)
+    lifetime->first = index;
+  lifetime->last = index;
+}
+
+static int compare_first(const void *a, const void *b) {
+  const struct lifetime *x = a;
+  const struct lifetime *y = b;
+
+  if (x->first != y->first)
+    return x->first < y->first ? -1 : 1;
+  return x->slot - y->slot;
+}
+
+static void recolour(struct x86_operand *operand, int *colours) {
+  if (operand->type == X86_STACK)
+    operand->value = colours[operand->value];
+}
+
+void slots(struct x86_program *program) {
+  assert(program);
+
+  int num_slots = program->num_slots;
+  if (num_slots == 0)
+    return;
+
+  struct lifetime *lifetimes =
+      memory_alloc(MEMORY_PASSES, num_slots * sizeof(*lifetimes));
+  int *colours = memory_alloc(MEMORY_PASSES, num_slots * sizeof(*colours));
+  int *free_colours =
+      memory_alloc(MEMORY_PASSES, num_slots * sizeof(*free_colours));
+  struct heap active = {
+      memory_alloc(MEMORY_PASSES, num_slots * sizeof(*active.items)), 0};
+  if (lifetimes == NULL || colours == NULL || free_colours == NULL ||
+      active.items == NULL)
+    ERROR_OUT();
+
+  for (int i = 0; i < num_slots; i++) {
+    lifetimes[i] = (struct lifetime){i, -1, -1};
+    colours[i] = -1;
+  }
+
+  int index = 0;
+  for (struct x86_instr *instr = program->head; instr;
+       instr = instr->next, index++) {
+    touch(lifetimes, instr->src, index);
+    touch(lifetimes, instr->dst, index);
+    touch(lifetimes, instr->index, index);
+  }
+
+  qsort(lifetimes, num_slots, sizeof(*lifetimes), compare_first);
+
+  int num_free = 0;
+  int num_colours = 0;
+
+  for (int i = 0; i < num_slots; i++) {
+    struct lifetime *lifetime = &lifetimes[i];
+    if (lifetime->first < 0)
+      continue;
+
+    while (active.count > 0 && active.items[0].last < lifetime->first) {
+      struct lifetime expired = heap_pop(&active);
+      free_colours[num_free++] = colours[expired.slot];
+    }
+
+    colours[lifetime->slot] =
+        num_free > 0 ? free_colours[--num_free] : num_colours++;
+    heap_push(&active, *lifetime);
+  }
+
+  for (struct x86_instr *instr = program->head; instr; instr = instr->next) {
+    recolour(&instr->src, colours);
+    recolour(&instr->dst, colours);
+    recolour(&instr->index, colours);
+  }
+
+  program->num_slots = num_colours;
+
+  memory_free(lifetimes);
+  memory_free(colours);
+  memory_free(free_colours);
+  memory_free(active.items);
+}
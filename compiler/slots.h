@@ -0,0 +1,11 @@
+#ifndef slots_h
+#define slots_h
+
+#include "x86.h"
+
+// Stack slot colouring: slots whose lifetimes are disjoint share storage, so
+// the frame grows with the peak number of live spilled values rather than
+// the total.
+void slots(struct x86_program *program);
+
+#endif
@@ -0,0 +1,439 @@
+#include "memory.h"
+#include "slp.h"
+#include "common.h"
+#include "ir.h"
+#include "mulconst.h"
+
+// Superword-level parallelism: packs IR_PACK_WIDTH independent i32
+// additions, subtractions or multiplications with the same opcode into one
+// vector instruction (paddd, psubd, pmulld over the lanes of an %xmm
+// register).
+//
+// Packs are grown as trees. The roots are instructions whose result is not
+// the only operand of another candidate, taken in program order, four with
+// the same opcode at a time. An operand whose four lanes are each defined by
+// a candidate read nowhere else, with one opcode, becomes a child pack that
+// leaves its result in the register; any other operand is gathered from
+// scalars (or broadcast, if the lanes agree), or read from a constant if
+// they are all immediates. Only the root's results are extracted back into
+// scalars.
+//
+// A tree is moved as one block, children first, to the earliest point
+// between its first and last instruction that each of them can reach: an
+// instruction moving down must not pass one reading its result, and none may
+// pass one redefining an operand. Arithmetic cannot trap, so moving it past
+// prints and divisions is safe. The tree is kept if the cost model below
+// prefers it; otherwise its instructions stay scalar.
+
+// Costs are issue slots on Skylake, four per cycle. A scalar lane takes one
+// (register allocation coalesces most copies), except that imull runs on
+// port 1 alone, so four of them take four cycles. Vector code takes the
+// larger of its micro-ops and four per micro-op on port 5, the only one
+// that moves values between general and %xmm registers.
+#define SCALAR_COST 4       // four addl, subl or leal
+#define SCALAR_IMUL_COST 16 // four imull
+#define VECTOR_OP_COST 1    // paddd, psubd
+#define VECTOR_MUL_COST 2   // pmulld
+#define GATHER_COST 7       // movd, 3 x pinsrd
+#define GATHER_PORT5 7
+#define IMMEDIATE_COST 1    // movl of an immediate lane to gather
+#define BROADCAST_COST 2    // movd, pshufd $0
+#define BROADCAST_PORT5 2
+#define LOAD_COST 1         // movdqa of constant lanes, unless folded
+#define EXTRACT_COST 7      // movd, 3 x pextrd
+#define EXTRACT_PORT5 3
+
+// A pack holds a register while the packs for its second operand run, and
+// the deepest needs two, so a tree never needs more than MAX_TREE_PACKS + 1
+// of the 16 %xmm registers.
+#define MAX_TREE_PACKS 15
+
+struct pack {
+  struct ir_instr *lanes[IR_PACK_WIDTH];
+
+  // Node index of the pack computing operand a and b, or -1 if gathered.
+  int children[2];
+};
+
+struct tree {
+  struct pack packs[MAX_TREE_PACKS];
+  int num_packs;
+};
+
+struct analysis {
+  struct ir_program *program;
+
+  // Instructions in program order.
+  struct ir_instr **instrs;
+  int num_instrs;
+
+  // Per temporary: position of the definition of a temporary defined once,
+  // or -1, the number of reads and the position of the last one.
+  int *def;
+  int *uses;
+  int *user;
+
+  // First roots of trees already rejected, not tried again.
+  struct ir_instr **rejected;
+  int num_rejected;
+
+  // Per position: part of a pack, part of the tree being built.
+  bool *packed;
+  bool *in_tree;
+};
+
+static struct ir_operand *operand(struct ir_instr *instr, int k) {
+  return k == 0 ? &instr->a : &instr->b;
+}
+
+static bool is_temp(struct ir_operand operand) {
+  return operand.type == IR_OPERAND_TEMP;
+}
+
+static void count_use(struct analysis *analysis, struct ir_operand operand,
+                      int at) {
+  if (is_temp(operand)) {
+    analysis->uses[operand.value]++;
+    analysis->user[operand.value] = at;
+  }
+}
+
+static void analyse(struct analysis *analysis) {
+  struct ir_program *program = analysis->program;
+
+  analysis->num_instrs = 0;
+  for (int i = 0; i < program->num_temps; i++) {
+    analysis->def[i] = -1;
+    analysis->uses[i] = 0;
+    analysis->user[i] = -1;
+  }
+
+  int pack_end = 0;
+  for (struct ir_instr *instr = program->head; instr; instr = instr->next) {
+    int at = analysis->num_instrs++;
+    analysis->instrs[at] = instr;
+
+    if (instr->pack != IR_PACK_NONE)
+      pack_end = at + IR_PACK_WIDTH;
+    analysis->packed[at] = at < pack_end;
+    analysis->in_tree[at] = false;
+
+    count_use(analysis, instr->a, at);
+    count_use(analysis, instr->b, at);
+    if (is_temp(instr->dst) && instr->dst.value >= program->num_vars)
+      analysis->def[instr->dst.value] = at;
+  }
+}
+
+static int position(struct analysis *analysis, struct ir_instr *instr) {
+  return analysis->def[instr->dst.value];
+}
+
+static bool is_candidate(struct analysis *analysis, struct ir_instr *instr) {
+  if (instr->op != IR_ADD && instr->op != IR_SUB && instr->op != IR_MUL)
+    return false;
+  if (instr->type != TYPE_I32 || !is_temp(instr->dst) ||
+      instr->dst.value < analysis->program->num_vars)
+    return false;
+
+  int at = position(analysis, instr);
+  return !analysis->packed[at] && !analysis->in_tree[at];
+}
+
+static bool is_root(struct analysis *analysis, struct ir_instr *instr) {
+  if (!is_candidate(analysis, instr))
+    return false;
+
+  int temp = instr->dst.value;
+  return analysis->uses[temp] != 1 ||
+         !is_candidate(analysis, analysis->instrs[analysis->user[temp]]);
+}
+
+static bool was_rejected(struct analysis *analysis, struct ir_instr *instr) {
+  for (int i = 0; i < analysis->num_rejected; i++) {
+    if (analysis->rejected[i] == instr)
+      return true;
+  }
+  return false;
+}
+
+// The definitions of operand k of the lanes, if they can form a child pack.
+static bool child_lanes(struct analysis *analysis, struct ir_instr **lanes,
+                        int k, struct ir_instr **defs) {
+  for (int i = 0; i < IR_PACK_WIDTH; i++) {
+    struct ir_operand value = *operand(lanes[i], k);
+    if (!is_temp(value) || analysis->def[value.value] < 0 ||
+        analysis->uses[value.value] != 1)
+      return false;
+
+    defs[i] = analysis->instrs[analysis->def[value.value]];
+    if (!is_candidate(analysis, defs[i]) || defs[i]->op != defs[0]->op)
+      return false;
+  }
+
+  return true;
+}
+
+static void mark(struct analysis *analysis, struct ir_instr **lanes,
+                 bool in_tree) {
+  for (int i = 0; i < IR_PACK_WIDTH; i++)
+    analysis->in_tree[position(analysis, lanes[i])] = in_tree;
+}
+
+// Adds the pack of `lanes` and the children it can grow to the tree.
+// Returns its index, or -1 if the tree is full.
+static int build(struct analysis *analysis, struct tree *tree,
+                 struct ir_instr **lanes) {
+  if (tree->num_packs == MAX_TREE_PACKS)
+    return -1;
+
+  int index = tree->num_packs++;
+  struct pack *pack = &tree->packs[index];
+  for (int i = 0; i < IR_PACK_WIDTH; i++)
+    pack->lanes[i] = lanes[i];
+  mark(analysis, lanes, true);
+
+  for (int k = 0; k < 2; k++) {
+    struct ir_instr *defs[IR_PACK_WIDTH];
+    pack->children[k] = -1;
+    if (child_lanes(analysis, lanes, k, defs))
+      pack->children[k] = build(analysis, tree, defs);
+  }
+
+  return index;
+}
+
+static bool reads(struct ir_instr *instr, struct ir_operand value) {
+  return is_temp(value) &&
+         ((is_temp(instr->a) && instr->a.value == value.value) ||
+          (is_temp(instr->b) && instr->b.value == value.value));
+}
+
+static bool writes(struct ir_instr *instr, struct ir_operand value) {
+  return is_temp(value) && is_temp(instr->dst) &&
+         instr->dst.value == value.value;
+}
+
+// Whether every instruction of the tree can move to just before the
+// instruction at position `at`, which is not in the tree: down past the
+// instructions in between if it comes before it, up past them otherwise.
+static bool can_move(struct analysis *analysis, struct tree *tree, int at) {
+  for (int p = 0; p < tree->num_packs; p++) {
+    struct pack *pack = &tree->packs[p];
+
+    for (int i = 0; i < IR_PACK_WIDTH; i++) {
+      struct ir_instr *lane = pack->lanes[i];
+      int from = position(analysis, lane);
+
+      // A gathered operand must not come from inside the tree.
+      for (int k = 0; k < 2; k++) {
+        struct ir_operand value = *operand(lane, k);
+        if (pack->children[k] < 0 && is_temp(value) &&
+            analysis->def[value.value] >= 0 &&
+            analysis->in_tree[analysis->def[value.value]])
+          return false;
+      }
+
+      int first = from < at ? from + 1 : at;
+      int last = from < at ? at : from;
+      for (int q = first; q < last; q++) {
+        struct ir_instr *other = analysis->instrs[q];
+        if (analysis->in_tree[q])
+          continue;
+        if ((from < at && reads(other, lane->dst)) || writes(other, lane->a) ||
+            writes(other, lane->b))
+          return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// Scalar multiplications by an immediate become the shifts and additions of
+// compiler/mulconst_table.h where it has an entry.
+static int scalar_cost(struct ir_instr *instr) {
+  if (instr->op != IR_MUL)
+    return SCALAR_COST;
+
+  struct ir_operand constant = instr->a.type == IR_OPERAND_IMM ? instr->a
+                                                              : instr->b;
+  if (constant.type != IR_OPERAND_IMM)
+    return SCALAR_IMUL_COST;
+  if (constant.value >= -1 && constant.value <= 1)
+    return SCALAR_COST;
+
+  const struct mulconst_entry *entry = mulconst_lookup(constant.value);
+  return entry ? entry->num_ops * SCALAR_COST : SCALAR_IMUL_COST;
+}
+
+// Immediates in every lane are a constant in memory, which the second
+// operand reads directly.
+static void operand_cost(struct ir_instr **lanes, int k, int *cost,
+                         int *port5) {
+  bool broadcast = true;
+  int immediates = 0;
+
+  for (int i = 0; i < IR_PACK_WIDTH; i++) {
+    struct ir_operand value = *operand(lanes[i], k);
+    struct ir_operand first = *operand(lanes[0], k);
+    broadcast = broadcast && value.type == first.type &&
+                value.value == first.value;
+    immediates += value.type == IR_OPERAND_IMM;
+  }
+
+  if (immediates == IR_PACK_WIDTH) {
+    *cost += k == 0 ? LOAD_COST : 0;
+  } else if (broadcast) {
+    *cost += BROADCAST_COST;
+    *port5 += BROADCAST_PORT5;
+  } else {
+    *cost += GATHER_COST + immediates * IMMEDIATE_COST;
+    *port5 += GATHER_PORT5;
+  }
+}
+
+static bool pays_off(struct tree *tree) {
+  int scalar = 0;
+  int vector = EXTRACT_COST;
+  int port5 = EXTRACT_PORT5;
+
+  for (int p = 0; p < tree->num_packs; p++) {
+    struct pack *pack = &tree->packs[p];
+    scalar += scalar_cost(pack->lanes[0]);
+    vector +=
+        pack->lanes[0]->op == IR_MUL ? VECTOR_MUL_COST : VECTOR_OP_COST;
+    for (int k = 0; k < 2; k++) {
+      if (pack->children[k] < 0)
+        operand_cost(pack->lanes, k, &vector, &port5);
+    }
+  }
+
+  if (vector < 4 * port5)
+    vector = 4 * port5;
+  return vector < scalar;
+}
+
+// Moves the pack and its children before `next`, children first.
+static void place(struct ir_program *program, struct tree *tree, int index,
+                  struct ir_instr *next) {
+  struct pack *pack = &tree->packs[index];
+  for (int k = 0; k < 2; k++) {
+    if (pack->children[k] >= 0)
+      place(program, tree, pack->children[k], next);
+  }
+
+  for (int i = 0; i < IR_PACK_WIDTH; i++) {
+    ir_unlink(program, pack->lanes[i]);
+    ir_insert_before(program, next, pack->lanes[i]);
+  }
+  pack->lanes[0]->pack = index == 0 ? IR_PACK_ROOT : IR_PACK_INNER;
+}
+
+// Tries the roots starting at `first`, the next three roots with its
+// opcode after it. Returns whether a tree was formed.
+static bool try_roots(struct analysis *analysis, int first) {
+  struct ir_instr *lanes[IR_PACK_WIDTH];
+  lanes[0] = analysis->instrs[first];
+
+  int count = 1;
+  for (int at = first + 1; at < analysis->num_instrs && count < IR_PACK_WIDTH;
+       at++) {
+    struct ir_instr *instr = analysis->instrs[at];
+    if (instr->op == lanes[0]->op && is_root(analysis, instr))
+      lanes[count++] = instr;
+  }
+  if (count < IR_PACK_WIDTH)
+    return false;
+
+  struct tree tree = {.num_packs = 0};
+  build(analysis, &tree, lanes);
+
+  int start = analysis->num_instrs;
+  int end = 0;
+  for (int p = 0; p < tree.num_packs; p++) {
+    for (int i = 0; i < IR_PACK_WIDTH; i++) {
+      int at = position(analysis, tree.packs[p].lanes[i]);
+      start = at < start ? at : start;
+      end = at > end ? at : end;
+    }
+  }
+
+  // The earliest place the whole tree can move to, before an instruction
+  // outside it or after the last one.
+  int at = start;
+  while (at <= end + 1 && ((at <= end && analysis->in_tree[at]) ||
+                           !can_move(analysis, &tree, at)))
+    at++;
+
+  bool legal = at <= end + 1;
+  bool formed = legal && pays_off(&tree);
+
+  for (int p = 0; p < tree.num_packs; p++)
+    mark(analysis, tree.packs[p].lanes, false);
+
+  if (!formed) {
+    analysis->rejected[analysis->num_rejected++] = lanes[0];
+    analysis->program->num_rejected_packs += legal;
+    return false;
+  }
+
+  struct ir_instr *next =
+      at < analysis->num_instrs ? analysis->instrs[at] : NULL;
+  place(analysis->program, &tree, 0, next);
+  analysis->program->num_packs += tree.num_packs;
+  return true;
+}
+
+void slp(struct ir_program *program) {
+  assert(program);
+
+  int size = program->num_instrs + 1;
+  struct analysis analysis = {
+      .program = program,
+      .instrs = memory_alloc(MEMORY_PASSES, size * sizeof(*analysis.instrs)),
+      .def = memory_alloc(MEMORY_PASSES,
+                          (program->num_temps + 1) * sizeof(*analysis.def)),
+      .uses = memory_alloc(MEMORY_PASSES,
+                           (program->num_temps + 1) * sizeof(*analysis.uses)),
+      .user = memory_alloc(MEMORY_PASSES,
+                           (program->num_temps + 1) * sizeof(*analysis.user)),
+      .rejected =
+          memory_alloc(MEMORY_PASSES, size * sizeof(*analysis.rejected)),
+      .num_rejected = 0,
+      .packed = memory_alloc(MEMORY_PASSES, size * sizeof(*analysis.packed)),
+      .in_tree = memory_alloc(MEMORY_PASSES, size * sizeof(*analysis.in_tree)),
+  };
+  if (analysis.instrs == NULL || analysis.def == NULL ||
+      analysis.uses == NULL || analysis.user == NULL ||
+      analysis.rejected == NULL || analysis.packed == NULL ||
+      analysis.in_tree == NULL)
+    ERROR_OUT();
+
+  // Forming a tree changes which instructions are roots, so the roots are
+  // scanned again from the start after each.
+  int first = 0;
+  analyse(&analysis);
+  while (first < analysis.num_instrs) {
+    struct ir_instr *instr = analysis.instrs[first];
+    if (!is_root(&analysis, instr) || was_rejected(&analysis, instr)) {
+      first++;
+      continue;
+    }
+
+    if (try_roots(&analysis, first)) {
+      analyse(&analysis);
+      first = 0;
+    } else {
+      first++;
+    }
+  }
+
+  memory_free(analysis.instrs);
+  memory_free(analysis.def);
+  memory_free(analysis.uses);
+  memory_free(analysis.user);
+  memory_free(analysis.rejected);
+  memory_free(analysis.packed);
+  memory_free(analysis.in_tree);
+}
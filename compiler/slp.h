@@ -0,0 +1,8 @@
+#ifndef slp_h
+#define slp_h
+
+#include "ir.h"
+
+void slp(struct ir_program *program);
+
+#endif
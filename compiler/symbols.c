@@ -1,5 +1,7 @@
 #include <string.h>
 
+#include "common.h"
+#include "memory.h"
 #include "symbols.h"
 
 struct symbol_table_t {
@@ -7,6 +9,8 @@ struct symbol_table_t {
   int capacity;
 
   struct symbol_entry **items;
+
+  struct symbol_table_stats stats;
 };
 
 static unsigned int hash(const char *key, int length) {
@@ -20,11 +24,16 @@ static unsigned int hash(const char *key, int length) {
 }
 
 symbol_table_t *symbol_table_new(int capacity) {
-  symbol_table_t *table = malloc(sizeof(*table));
+  symbol_table_t *table = memory_alloc(MEMORY_SYMBOLS, sizeof(*table));
+  if (table == NULL)
+    ERROR_OUT();
 
   table->capacity = capacity;
   table->length = 0;
-  table->items = malloc(capacity * sizeof(table->items));
+  table->stats = (struct symbol_table_stats){0, 0, 0};
+  table->items = memory_alloc(MEMORY_SYMBOLS, capacity * sizeof(table->items));
+  if (table->items == NULL)
+    ERROR_OUT();
 
   for (int i = 0; i < table->capacity; i++)
     table->items[i] = NULL;
@@ -40,12 +49,12 @@ void symbol_table_free(symbol_table_t **table) {
   for (int i = 0; i < (*table)->capacity; i++) {
     for (cur = (*table)->items[i]; cur; cur = next) {
       next = cur->next;
-      free(cur);
+      memory_free(cur);
     }
   }
 
-  free((*table)->items);
-  free(*table);
+  memory_free((*table)->items);
+  memory_free(*table);
   *table = NULL;
 }
 
@@ -54,13 +63,16 @@ void symbol_table_add(symbol_table_t *table, struct scanner_token *name,
   assert(table && name);
 
   int i = hash(name->start, name->length) % table->capacity;
-  struct symbol_entry *entry = malloc(sizeof(*entry));
+  struct symbol_entry *entry = memory_alloc(MEMORY_SYMBOLS, sizeof(*entry));
+  if (entry == NULL)
+    ERROR_OUT();
   entry->name = name;
   entry->decl = node;
   entry->next = table->items[i];
 
   table->items[i] = entry;
   table->length++;
+  table->stats.inserts++;
 }
 
 struct ast_node *symbol_table_get(symbol_table_t *table,
@@ -68,8 +80,10 @@ struct ast_node *symbol_table_get(symbol_table_t *table,
   assert(table && name);
   int i = hash(name->start, name->length) % table->capacity;
   struct symbol_entry *entry = table->items[i];
+  table->stats.lookups++;
 
   while (entry) {
+    table->stats.probes++;
     if (entry->name->length == name->length &&
         memcmp(entry->name->start, name->start, name->length) == 0) {
       return entry->decl;
@@ -79,3 +93,9 @@ struct ast_node *symbol_table_get(symbol_table_t *table,
 
   return NULL;
 }
+
+struct symbol_table_stats symbol_table_stats(symbol_table_t *table) {
+  assert(table);
+
+  return table->stats;
+}
@@ -13,6 +13,14 @@ struct symbol_entry {
   struct symbol_entry *next;
 };
 
+// Work done by a table, for --time-passes. A probe compares the name looked
+// up with one entry of its bucket.
+struct symbol_table_stats {
+  int inserts;
+  int lookups;
+  int probes;
+};
+
 symbol_table_t *symbol_table_new(int capacity);
 void symbol_table_free(symbol_table_t **table);
 
@@ -21,4 +29,6 @@ void symbol_table_add(symbol_table_t *table, struct scanner_token *name,
 struct ast_node *symbol_table_get(symbol_table_t *table,
                                   struct scanner_token *name);
 
+struct symbol_table_stats symbol_table_stats(symbol_table_t *table);
+
 #endif
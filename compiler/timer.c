@@ -0,0 +1,288 @@
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "common.h"
+#include "memory.h"
+#include "timer.h"
+
+static long long clock_ns(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void timer_init(struct timer *timer, bool enabled) {
+  assert(timer);
+
+  timer->enabled = enabled;
+  timer->num_phases = 0;
+  timer->num_counters = 0;
+  timer->counting = false;
+  timer->perf.error = 0;
+  timer->wall_start = 0;
+  timer->cpu_start = 0;
+}
+
+void timer_free(struct timer *timer) {
+  assert(timer);
+
+  if (timer->counting)
+    perf_close(&timer->perf);
+  timer->counting = false;
+}
+
+bool timer_enable_perf(struct timer *timer) {
+  assert(timer);
+
+  if (!timer->enabled || timer->counting)
+    return timer->counting;
+
+  timer->counting = perf_open(&timer->perf);
+  return timer->counting;
+}
+
+void timer_begin(struct timer *timer, const char *name) {
+  assert(timer && name);
+
+  if (!timer->enabled)
+    return;
+
+  assert(timer->num_phases < TIMER_MAX_PHASES);
+  timer->phases[timer->num_phases].name = name;
+  memory_reset_peak();
+  timer->wall_start = clock_ns(CLOCK_MONOTONIC);
+  timer->cpu_start = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+  if (timer->counting)
+    perf_read(&timer->perf, timer->events_start);
+}
+
+void timer_end(struct timer *timer, long long count, const char *unit) {
+  assert(timer);
+
+  if (!timer->enabled)
+    return;
+
+  // In the reverse order of timer_begin, so that no reading counts the
+  // others.
+  long long events[NUM_PERF_EVENTS];
+  if (timer->counting)
+    perf_read(&timer->perf, events);
+  long long cpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+  long long wall = clock_ns(CLOCK_MONOTONIC);
+
+  struct timer_phase *phase = &timer->phases[timer->num_phases++];
+  phase->wall = wall - timer->wall_start;
+  phase->cpu = cpu - timer->cpu_start;
+  phase->count = count;
+  phase->unit = unit;
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  phase->max_rss = usage.ru_maxrss;
+  phase->heap_live = memory_live();
+  phase->heap_peak = memory_peak();
+
+  for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+    bool counted = timer->counting && events[i] >= 0 &&
+                   timer->events_start[i] >= 0;
+    phase->events[i] = counted ? events[i] - timer->events_start[i] : -1;
+  }
+}
+
+void timer_count(struct timer *timer, const char *name, long long value) {
+  assert(timer && name);
+
+  if (!timer->enabled)
+    return;
+
+  assert(timer->num_counters < TIMER_MAX_COUNTERS);
+  timer->counters[timer->num_counters++] =
+      (struct timer_counter){name, value};
+}
+
+// Units per second of wall time, 0 if unknown.
+static double rate(struct timer_phase *phase) {
+  if (phase->unit == NULL || phase->wall <= 0)
+    return 0;
+  return phase->count / (phase->wall / 1e9);
+}
+
+void timer_report(struct timer *timer, FILE *file) {
+  assert(timer && file);
+
+  if (!timer->enabled)
+    return;
+
+  long long wall = 0;
+  long long cpu = 0;
+
+  fprintf(file, "%-14s %12s %12s %7s %10s %14s\n", "phase", "wall (us)",
+          "cpu (us)", "wall %", "count", "per second");
+
+  for (int i = 0; i < timer->num_phases; i++) {
+    wall += timer->phases[i].wall;
+    cpu += timer->phases[i].cpu;
+  }
+
+  for (int i = 0; i < timer->num_phases; i++) {
+    struct timer_phase *phase = &timer->phases[i];
+    fprintf(file, "%-14s %12.2f %12.2f %6.1f%%", phase->name,
+            phase->wall / 1000.0, phase->cpu / 1000.0,
+            wall > 0 ? 100.0 * phase->wall / wall : 0.0);
+
+    if (phase->unit) {
+      fprintf(file, " %10lld %14.0f %s/s\n", phase->count, rate(phase),
+              phase->unit);
+    } else {
+      fprintf(file, " %10s %14s\n", "-", "-");
+    }
+  }
+
+  fprintf(file, "%-14s %12.2f %12.2f %6.1f%%\n", "total", wall / 1000.0,
+          cpu / 1000.0, 100.0);
+
+  for (int i = 0; i < timer->num_counters; i++)
+    fprintf(file, "%s: %lld\n", timer->counters[i].name,
+            timer->counters[i].value);
+}
+
+void timer_report_json(struct timer *timer, FILE *file) {
+  assert(timer && file);
+
+  if (!timer->enabled)
+    return;
+
+  long long wall = 0;
+  long long cpu = 0;
+
+  fprintf(file, "{\"phases\": [");
+  for (int i = 0; i < timer->num_phases; i++) {
+    struct timer_phase *phase = &timer->phases[i];
+    wall += phase->wall;
+    cpu += phase->cpu;
+
+    fprintf(file,
+            "%s\n  {\"name\": \"%s\", \"wall_ns\": %lld, \"cpu_ns\": %lld",
+            i > 0 ? "," : "", phase->name, phase->wall, phase->cpu);
+    if (phase->unit) {
+      fprintf(file,
+              ", \"count\": %lld, \"unit\": \"%s\", \"per_second\": %.0f",
+              phase->count, phase->unit, rate(phase));
+    }
+    for (int j = 0; j < NUM_PERF_EVENTS; j++) {
+      if (phase->events[j] >= 0)
+        fprintf(file, ", \"%s\": %lld", perf_event_name(j), phase->events[j]);
+    }
+    fprintf(file, "}");
+  }
+
+  fprintf(file, "],\n \"total\": {\"wall_ns\": %lld, \"cpu_ns\": %lld},\n",
+          wall, cpu);
+
+  // Why events are missing, if they were asked for.
+  if (timer->perf.error != 0)
+    fprintf(file, " \"perf_error\": \"%s\",\n", strerror(timer->perf.error));
+
+  fprintf(file, " \"counters\": {");
+  for (int i = 0; i < timer->num_counters; i++) {
+    fprintf(file, "%s\"%s\": %lld", i > 0 ? ", " : "",
+            timer->counters[i].name, timer->counters[i].value);
+  }
+  fprintf(file, "}}\n");
+}
+
+static void print_event(FILE *file, int width, long long value) {
+  if (value < 0)
+    fprintf(file, " %*s", width, "-");
+  else
+    fprintf(file, " %*lld", width, value);
+}
+
+static void print_ratio(FILE *file, int width, const char *format,
+                        long long numerator, long long denominator) {
+  if (numerator < 0 || denominator <= 0)
+    fprintf(file, " %*s", width, "-");
+  else
+    fprintf(file, format, width, (double)numerator / denominator);
+}
+
+static void print_events(FILE *file, const char *name, long long *events,
+                         long long count, const char *unit) {
+  fprintf(file, "%-14s", name);
+  for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+    print_event(file, 14, events[i]);
+    if (i == PERF_INSTRUCTIONS)
+      print_ratio(file, 6, " %*.2f", events[PERF_INSTRUCTIONS],
+                  events[PERF_CYCLES]);
+  }
+
+  if (unit == NULL) {
+    fprintf(file, "\n");
+    return;
+  }
+
+  for (int i = PERF_BRANCH_MISSES; i <= PERF_LLC_MISSES; i++)
+    print_ratio(file, 9, " %*.3f", events[i], count);
+  fprintf(file, "  %s\n", unit);
+}
+
+void timer_report_events(struct timer *timer, FILE *file) {
+  assert(timer && file);
+
+  if (!timer->counting)
+    return;
+
+  long long total[NUM_PERF_EVENTS];
+  for (int i = 0; i < NUM_PERF_EVENTS; i++)
+    total[i] = -1;
+
+  fprintf(file, "%-14s", "phase");
+  for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+    fprintf(file, " %14s", perf_event_name(i));
+    if (i == PERF_INSTRUCTIONS)
+      fprintf(file, " %6s", "IPC");
+  }
+  fprintf(file, " %9s %9s %9s  %s\n", "br/unit", "L1D/unit", "LLC/unit",
+          "unit");
+
+  for (int i = 0; i < timer->num_phases; i++) {
+    struct timer_phase *phase = &timer->phases[i];
+    print_events(file, phase->name, phase->events, phase->count, phase->unit);
+
+    for (int j = 0; j < NUM_PERF_EVENTS; j++) {
+      if (phase->events[j] >= 0)
+        total[j] = (total[j] < 0 ? 0 : total[j]) + phase->events[j];
+    }
+  }
+
+  print_events(file, "total", total, 0, NULL);
+
+  // Name what is missing, so that a column of dashes is not a mystery.
+  bool missing = false;
+  for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+    if (timer->perf.fds[i] >= 0)
+      continue;
+    fprintf(file, "%s%s", missing ? ", " : "not counted: ",
+            perf_event_name(i));
+    missing = true;
+  }
+  if (missing)
+    fprintf(file, " (%s)\n", strerror(timer->perf.error));
+}
+
+void timer_report_memory(struct timer *timer, FILE *file) {
+  assert(timer && file);
+
+  if (!timer->enabled)
+    return;
+
+  fprintf(file, "%-14s %14s %14s %14s\n", "phase", "max RSS (KiB)",
+          "heap live", "heap peak");
+
+  for (int i = 0; i < timer->num_phases; i++) {
+    struct timer_phase *phase = &timer->phases[i];
+    fprintf(file, "%-14s %14lld %14lld %14lld\n", phase->name, phase->max_rss,
+            phase->heap_live, phase->heap_peak);
+  }
+}
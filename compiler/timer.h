@@ -0,0 +1,85 @@
+#ifndef timer_h
+#define timer_h
+
+#include "common.h"
+#include "perf.h"
+
+// Wall and CPU time and memory of each phase of a compilation, and counters
+// of the work done, for --time-passes and --mem-stats. Phases are recorded
+// in the order they end. None of the functions does anything unless the
+// timer is enabled. With timer_enable_perf, each phase also counts hardware
+// events.
+
+#define TIMER_MAX_PHASES 32
+#define TIMER_MAX_COUNTERS 16
+
+struct timer_phase {
+  const char *name;
+
+  // Nanoseconds of CLOCK_MONOTONIC and CLOCK_PROCESS_CPUTIME_ID.
+  long long wall;
+  long long cpu;
+
+  // Units the phase processed, such as tokens or AST nodes, for its rate;
+  // unit is NULL if it has none.
+  long long count;
+  const char *unit;
+
+  // Only with timer_enable_perf; -1 for the events that were not counted.
+  long long events[NUM_PERF_EVENTS];
+
+  // The process's peak resident set in KiB at the end of the phase, and the
+  // bytes of heap live at its end and at most during it.
+  long long max_rss;
+  long long heap_live;
+  long long heap_peak;
+};
+
+struct timer_counter {
+  const char *name;
+  long long value;
+};
+
+struct timer {
+  bool enabled;
+
+  struct timer_phase phases[TIMER_MAX_PHASES];
+  int num_phases;
+
+  struct timer_counter counters[TIMER_MAX_COUNTERS];
+  int num_counters;
+
+  bool counting;
+  struct perf perf;
+
+  // Start of the open phase.
+  long long wall_start;
+  long long cpu_start;
+  long long events_start[NUM_PERF_EVENTS];
+};
+
+void timer_init(struct timer *timer, bool enabled);
+void timer_free(struct timer *timer);
+
+// Counts hardware events in the phases to come. Returns false, leaving the
+// timer as it was, if none of them can be counted; timer->perf.error says
+// why.
+bool timer_enable_perf(struct timer *timer);
+
+void timer_begin(struct timer *timer, const char *name);
+void timer_end(struct timer *timer, long long count, const char *unit);
+
+void timer_count(struct timer *timer, const char *name, long long value);
+
+// A table, or one JSON object for tools.
+void timer_report(struct timer *timer, FILE *file);
+void timer_report_json(struct timer *timer, FILE *file);
+
+// The hardware events of each phase, with instructions per cycle and misses
+// per unit of work.
+void timer_report_events(struct timer *timer, FILE *file);
+
+// The memory of each phase.
+void timer_report_memory(struct timer *timer, FILE *file);
+
+#endif
@@ -0,0 +1,54 @@
+#include <spawn.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "diagnostics.h"
+#include "object.h"
+#include "toolchain.h"
+#include "x86.h"
+
+extern char **environ;
+
+static bool run(char *const argv[]) {
+  pid_t pid;
+  if (posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ) != 0)
+    return false;
+
+  int status;
+  if (waitpid(pid, &status, 0) < 0)
+    return false;
+
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool toolchain_link(struct x86_program *program, const char *output) {
+  assert(program && output);
+
+  char path[] = "/tmp/compilerXXXXXX.o";
+  int fd = mkstemps(path, 2);
+  if (fd < 0) {
+    fprintf(diagnostics_out(), "[error] Could not create a temporary file.\n");
+    return false;
+  }
+  close(fd);
+
+  if (!object_write(program, path)) {
+    unlink(path);
+    return false;
+  }
+
+  const char *cc = getenv("CC");
+  if (cc == NULL || cc[0] == '\0')
+    cc = "cc";
+
+  char *argv[] = {(char *)cc, "-o", (char *)output, path, NULL};
+  bool ok = run(argv);
+  if (!ok)
+    fprintf(diagnostics_out(), "[error] '%s' failed to link '%s'.\n", cc,
+            output);
+
+  unlink(path);
+  return ok;
+}
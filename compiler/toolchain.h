@@ -0,0 +1,11 @@
+#ifndef toolchain_h
+#define toolchain_h
+
+#include "common.h"
+#include "x86.h"
+
+// Writes the program as an object to a temporary file and links it into an
+// executable with the system C compiler ($CC, or cc).
+bool toolchain_link(struct x86_program *program, const char *output);
+
+#endif
@@ -0,0 +1,185 @@
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "diagnostics.h"
+#include "memory.h"
+#include "trace.h"
+
+_Thread_local bool trace_enabled = false;
+_Thread_local bool trace_statements = false;
+
+struct trace_event {
+  const char *name;
+  const char *arg_name;
+  long long arg;
+  long long time;
+  char phase;
+};
+
+// The events of one thread, in the order they happened.
+struct trace_buffer {
+  long tid;
+  struct trace_event *events;
+  int num_events;
+  int capacity;
+
+  // Spans begun and not yet ended.
+  int depth;
+
+  struct trace_buffer *next;
+};
+
+static pthread_mutex_t buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct trace_buffer *buffers;
+
+// Set by the first trace_start of a trace, which every later one waits on
+// through the lock.
+static bool started;
+static long long start;
+
+// A thread's buffer is only its own until trace_write takes the buffers of
+// the generation it belongs to.
+static int generation;
+static _Thread_local struct trace_buffer *buffer;
+static _Thread_local int buffer_generation;
+
+static long long now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static struct trace_buffer *thread_buffer(void) {
+  if (buffer && buffer_generation == generation)
+    return buffer;
+
+  // Outside any region, as the buffer outlives the compile.
+  struct memory_region *region = memory_enter(NULL);
+  buffer = memory_calloc(MEMORY_TRACE, 1, sizeof(*buffer));
+  memory_enter(region);
+  if (buffer == NULL)
+    ERROR_OUT();
+  buffer->tid = syscall(SYS_gettid);
+
+  pthread_mutex_lock(&buffers_lock);
+  buffer_generation = generation;
+  buffer->next = buffers;
+  buffers = buffer;
+  pthread_mutex_unlock(&buffers_lock);
+
+  return buffer;
+}
+
+static void record(char phase, const char *name, const char *arg_name,
+                   long long arg) {
+  struct trace_buffer *events = thread_buffer();
+
+  if (events->num_events == events->capacity) {
+    events->capacity = events->capacity ? events->capacity * 2 : 256;
+    struct memory_region *region = memory_enter(NULL);
+    events->events =
+        memory_realloc(MEMORY_TRACE, events->events,
+                       events->capacity * sizeof(*events->events));
+    memory_enter(region);
+    if (events->events == NULL)
+      ERROR_OUT();
+  }
+
+  events->events[events->num_events++] =
+      (struct trace_event){name, arg_name, arg, now() - start, phase};
+}
+
+void trace_start(bool statements) {
+  pthread_mutex_lock(&buffers_lock);
+  if (!started) {
+    start = now();
+    started = true;
+  }
+  pthread_mutex_unlock(&buffers_lock);
+
+  trace_enabled = true;
+  trace_statements = statements;
+}
+
+void trace_begin(const char *name, const char *arg_name, long long arg) {
+  assert(name);
+
+  record('B', name, arg_name, arg);
+  thread_buffer()->depth++;
+}
+
+void trace_end(void) {
+  struct trace_buffer *events = thread_buffer();
+  assert(events->depth > 0);
+
+  record('E', NULL, NULL, 0);
+  events->depth--;
+}
+
+static void write_event(FILE *file, struct trace_event *event, long tid,
+                        bool first) {
+  fprintf(file, "%s\n{\"ph\": \"%c\", \"pid\": %d, \"tid\": %ld, ",
+          first ? "" : ",", event->phase, (int)getpid(), tid);
+  fprintf(file, "\"ts\": %lld.%03lld", event->time / 1000, event->time % 1000);
+
+  if (event->name)
+    fprintf(file, ", \"name\": \"%s\"", event->name);
+  if (event->arg_name)
+    fprintf(file, ", \"args\": {\"%s\": %lld}", event->arg_name, event->arg);
+  fprintf(file, "}");
+}
+
+bool trace_write(const char *path) {
+  assert(path);
+
+  trace_enabled = false;
+  trace_statements = false;
+
+  pthread_mutex_lock(&buffers_lock);
+  struct trace_buffer *list = buffers;
+  buffers = NULL;
+  generation++;
+  started = false;
+  pthread_mutex_unlock(&buffers_lock);
+
+  FILE *file = fopen(path, "w");
+  if (file == NULL)
+    fprintf(diagnostics_out(), "[error] Could not open '%s' for writing.\n",
+            path);
+
+  long long end = now() - start;
+  bool first = true;
+
+  if (file)
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+  while (list) {
+    struct trace_buffer *next = list->next;
+
+    for (int i = 0; file && i < list->num_events; i++) {
+      write_event(file, &list->events[i], list->tid, first);
+      first = false;
+    }
+
+    // Spans left open by a failure end with the trace.
+    for (int i = 0; file && i < list->depth; i++) {
+      struct trace_event event = {NULL, NULL, 0, end, 'E'};
+      write_event(file, &event, list->tid, first);
+      first = false;
+    }
+
+    memory_free(list->events);
+    memory_free(list);
+    list = next;
+  }
+
+  if (file == NULL)
+    return false;
+
+  fprintf(file, "\n]}\n");
+  fclose(file);
+  return true;
+}
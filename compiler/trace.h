@@ -0,0 +1,58 @@
+#ifndef trace_h
+#define trace_h
+
+#include "common.h"
+
+// Spans of the compilation in the Chrome trace event format, for --trace,
+// to be opened in chrome://tracing or Perfetto. Each thread records into a
+// buffer of its own under its kernel thread id; trace_write merges them.
+//
+// Spans nest and are recorded through the macros below, which cost one
+// branch on a flag of the thread while tracing is off. Tracing is on only
+// for the threads that start it, so a program compiling with libcompiler.a
+// on other threads records nothing.
+
+extern _Thread_local bool trace_enabled;
+extern _Thread_local bool trace_statements;
+
+#define TRACE_BEGIN(name)                                                      \
+  do {                                                                         \
+    if (trace_enabled)                                                         \
+      trace_begin((name), NULL, 0);                                            \
+  } while (0)
+
+#define TRACE_END()                                                            \
+  do {                                                                         \
+    if (trace_enabled)                                                         \
+      trace_end();                                                             \
+  } while (0)
+
+// A span of one top-level statement, with its index as an argument, only
+// when statements are traced as well.
+#define TRACE_BEGIN_STATEMENT(name, index)                                     \
+  do {                                                                         \
+    if (trace_statements)                                                      \
+      trace_begin((name), "statement", (index));                               \
+  } while (0)
+
+#define TRACE_END_STATEMENT()                                                  \
+  do {                                                                         \
+    if (trace_statements)                                                      \
+      trace_end();                                                             \
+  } while (0)
+
+// Turns tracing on for the calling thread, with a span per statement if
+// statements is true. The first call since the last trace_write starts the
+// clock of the trace; threads that join it later call it as well.
+void trace_start(bool statements);
+
+// Writes every span recorded so far by any thread, closing those still
+// open, and turns tracing off for the calling thread. Returns false if the
+// file cannot be written.
+bool trace_write(const char *path);
+
+// Called through the macros. name must outlive the trace.
+void trace_begin(const char *name, const char *arg_name, long long arg);
+void trace_end(void);
+
+#endif
@@ -1,8 +1,10 @@
 #include "typechecker.h"
 #include "ast.h"
 #include "common.h"
+#include "diagnostics.h"
 #include "scanner.h"
 #include "symbols.h"
+#include "trace.h"
 
 static const char *op_to_string(enum scanner_token_type op) {
   switch (op) {
@@ -41,7 +43,11 @@ enum ast_data_type typecheck(struct ast_node *root, symbol_table_t *table) {
   switch (root->type) {
   case AST_PROGRAM:
     for (int i = 0; i < root->as.program.num_statements; i++) {
-      if (typecheck(root->as.program.statements[i], table) == TYPE_ERROR)
+      TRACE_BEGIN_STATEMENT("typecheck statement", i);
+      enum ast_data_type type =
+          typecheck(root->as.program.statements[i], table);
+      TRACE_END_STATEMENT();
+      if (type == TYPE_ERROR)
         return TYPE_ERROR;
     }
     return TYPE_I32; // placeholder
@@ -61,11 +67,12 @@ enum ast_data_type typecheck(struct ast_node *root, symbol_table_t *table) {
       return target;
     }
 
-    printf("[error] Cannot assign %s to variable '%.*s' of type %s.\n",
-           type_to_string(expr),
-           root->as.assignment_stmt.identifier->as.identifier.length,
-           root->as.assignment_stmt.identifier->as.identifier.start,
-           type_to_string(target));
+    fprintf(diagnostics_out(),
+            "[error] Cannot assign %s to variable '%.*s' of type %s.\n",
+            type_to_string(expr),
+            root->as.assignment_stmt.identifier->as.identifier.length,
+            root->as.assignment_stmt.identifier->as.identifier.start,
+            type_to_string(target));
     return TYPE_ERROR;
   }
 
@@ -81,9 +88,10 @@ enum ast_data_type typecheck(struct ast_node *root, symbol_table_t *table) {
       return TYPE_I32;
     }
 
-    printf("[error] Type mismatch for binary expression '%s %s %s'\n",
-           type_to_string(left), op_to_string(root->as.binary_expr.token.type),
-           type_to_string(right));
+    fprintf(diagnostics_out(),
+            "[error] Type mismatch for binary expression '%s %s %s'\n",
+            type_to_string(left), op_to_string(root->as.binary_expr.token.type),
+            type_to_string(right));
     return TYPE_ERROR;
   }
 
@@ -96,8 +104,10 @@ enum ast_data_type typecheck(struct ast_node *root, symbol_table_t *table) {
     if (right == TYPE_I32)
       return TYPE_I32;
 
-    printf("[error] Type mismatch for unary expression '%s %s'\n",
-           op_to_string(root->as.unary_expr.token.type), type_to_string(right));
+    fprintf(diagnostics_out(),
+            "[error] Type mismatch for unary expression '%s %s'\n",
+            op_to_string(root->as.unary_expr.token.type),
+            type_to_string(right));
     return TYPE_ERROR;
   }
 
@@ -117,10 +127,11 @@ enum ast_data_type typecheck(struct ast_node *root, symbol_table_t *table) {
     if (root->as.variable_decl.type == initialiser)
       return initialiser;
 
-    printf("[error] Cannot assign %s to variable '%.*s' of type %s.\n",
-           type_to_string(initialiser), root->as.variable_decl.name.length,
-           root->as.variable_decl.name.start,
-           type_to_string(root->as.variable_decl.type));
+    fprintf(diagnostics_out(),
+            "[error] Cannot assign %s to variable '%.*s' of type %s.\n",
+            type_to_string(initialiser), root->as.variable_decl.name.length,
+            root->as.variable_decl.name.start,
+            type_to_string(root->as.variable_decl.type));
     return TYPE_ERROR;
   }
 
@@ -0,0 +1,138 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "bytecode.h"
+#include "common.h"
+#include "memory.h"
+#include "output.h"
+#include "vm.h"
+
+// Operand i of the current instruction, as a register.
+#define R(i) registers[pc[i]]
+
+#define DISPATCH() goto *labels[*pc]
+
+// Arithmetic wraps, as in the generated code.
+#define WRAP(a, op, b) ((int32_t)((uint32_t)(a)op(uint32_t)(b)))
+
+#define ADD(dst, a, b) dst = WRAP(a, +, b)
+#define SUB(dst, a, b) dst = WRAP(a, -, b)
+#define MUL(dst, a, b) dst = WRAP(a, *, b)
+#define DIV(dst, a, b)                                                         \
+  do {                                                                         \
+    int32_t dividend = (a);                                                    \
+    int32_t divisor = (b);                                                     \
+    if (divisor == 0 || (dividend == INT32_MIN && divisor == -1))              \
+      goto trap;                                                               \
+    dst = dividend / divisor;                                                  \
+  } while (0)
+
+// a <- b op c
+#define ARITH(label, OP)                                                       \
+  label:                                                                       \
+  OP(R(1), R(2), R(3));                                                        \
+  pc += 4;                                                                     \
+  DISPATCH()
+
+// a <- b; c <- d op e
+#define MOVE_ARITH(label, OP)                                                  \
+  label:                                                                       \
+  R(1) = R(2);                                                                 \
+  OP(R(3), R(4), R(5));                                                        \
+  pc += 6;                                                                     \
+  DISPATCH()
+
+// a <- b op c; d <- e
+#define ARITH_MOVE(label, OP)                                                  \
+  label:                                                                       \
+  OP(R(1), R(2), R(3));                                                        \
+  R(4) = R(5);                                                                 \
+  pc += 6;                                                                     \
+  DISPATCH()
+
+bool vm_run(struct bytecode *code, struct output *output) {
+  assert(code && output);
+
+  static void *const labels[NUM_BYTECODE_OPS] = {
+      [BC_HALT] = &&halt,
+      [BC_MOVE_I32] = &&move,
+      [BC_MOVE_BOOL] = &&move,
+      [BC_ADD_I32] = &&add,
+      [BC_SUB_I32] = &&sub,
+      [BC_MUL_I32] = &&mul,
+      [BC_DIV_I32] = &&div,
+      [BC_NEG_I32] = &&neg,
+      [BC_PRINT_I32] = &&print_i32,
+      [BC_PRINT_BOOL] = &&print_bool,
+      [BC_MOVE_ADD_I32] = &&move_add,
+      [BC_MOVE_SUB_I32] = &&move_sub,
+      [BC_MOVE_MUL_I32] = &&move_mul,
+      [BC_MOVE_DIV_I32] = &&move_div,
+      [BC_ADD_MOVE_I32] = &&add_move,
+      [BC_SUB_MOVE_I32] = &&sub_move,
+      [BC_MUL_MOVE_I32] = &&mul_move,
+      [BC_DIV_MOVE_I32] = &&div_move,
+      [BC_MOVE_MOVE_I32] = &&move_move,
+  };
+
+  int32_t *registers =
+      memory_calloc(MEMORY_VM, code->num_registers, sizeof(*registers));
+  if (registers == NULL && code->num_registers > 0)
+    ERROR_OUT();
+
+  if (code->num_constants > 0)
+    memcpy(registers + code->first_constant, code->constants,
+           code->num_constants * sizeof(*registers));
+
+  const uint16_t *pc = code->code;
+  bool ok = true;
+  DISPATCH();
+
+move:
+  R(1) = R(2);
+  pc += 3;
+  DISPATCH();
+
+  ARITH(add, ADD);
+  ARITH(sub, SUB);
+  ARITH(mul, MUL);
+  ARITH(div, DIV);
+
+neg:
+  R(1) = WRAP(0, -, R(2));
+  pc += 3;
+  DISPATCH();
+
+print_i32:
+  output_i32(output, R(1));
+  pc += 2;
+  DISPATCH();
+
+print_bool:
+  output_bool(output, R(1));
+  pc += 2;
+  DISPATCH();
+
+  MOVE_ARITH(move_add, ADD);
+  MOVE_ARITH(move_sub, SUB);
+  MOVE_ARITH(move_mul, MUL);
+  MOVE_ARITH(move_div, DIV);
+
+  ARITH_MOVE(add_move, ADD);
+  ARITH_MOVE(sub_move, SUB);
+  ARITH_MOVE(mul_move, MUL);
+  ARITH_MOVE(div_move, DIV);
+
+move_move:
+  R(1) = R(2);
+  R(3) = R(4);
+  pc += 5;
+  DISPATCH();
+
+trap:
+  ok = false;
+
+halt:
+  memory_free(registers);
+  return ok;
+}
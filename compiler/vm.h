@@ -0,0 +1,14 @@
+#ifndef vm_h
+#define vm_h
+
+#include "bytecode.h"
+#include "common.h"
+#include "output.h"
+
+// Interprets bytecode, dispatching with GCC's computed goto: every handler
+// jumps straight to the next one through a table of label addresses, so each
+// instruction ends in its own indirect branch. Returns false if a division
+// traps.
+bool vm_run(struct bytecode *code, struct output *output);
+
+#endif
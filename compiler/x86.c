@@ -0,0 +1,659 @@
+#include <string.h>
+
+#include "memory.h"
+#include "x86.h"
+#include "common.h"
+#include "runtime_source.h"
+
+struct x86_program *x86_new(void) {
+  struct x86_program *program = memory_alloc(MEMORY_X86, sizeof(*program));
+  if (program == NULL)
+    ERROR_OUT();
+
+  program->head = NULL;
+  program->tail = NULL;
+  program->num_instrs = 0;
+  program->num_vregs = 0;
+  program->num_slots = 0;
+  program->constants = NULL;
+  program->num_constants = 0;
+  program->constants_capacity = 0;
+  program->num_spills = 0;
+  program->slot_base = 0;
+
+  for (int i = 0; i < NUM_REGS; i++)
+    program->used_regs[i] = false;
+  for (int i = 0; i < X86_MAX_PEEPHOLE_RULES; i++)
+    program->peephole_hits[i] = 0;
+
+  return program;
+}
+
+void x86_free(struct x86_program **program) {
+  assert(program && *program);
+
+  struct x86_instr *instr = (*program)->head;
+  while (instr) {
+    struct x86_instr *next = instr->next;
+    memory_free(instr);
+    instr = next;
+  }
+
+  memory_free((*program)->constants);
+  memory_free(*program);
+  *program = NULL;
+}
+
+int x86_new_constant(struct x86_program *program, const int *lanes) {
+  assert(program && lanes);
+
+  for (int i = 0; i < program->num_constants; i++) {
+    if (memcmp(program->constants[i].lanes, lanes,
+               sizeof(program->constants[i].lanes)) == 0)
+      return i;
+  }
+
+  if (program->num_constants == program->constants_capacity) {
+    program->constants_capacity =
+        program->constants_capacity ? program->constants_capacity * 2 : 4;
+    program->constants =
+        memory_realloc(MEMORY_X86, program->constants,
+                program->constants_capacity * sizeof(*program->constants));
+    if (program->constants == NULL)
+      ERROR_OUT();
+  }
+
+  struct x86_constant *constant = &program->constants[program->num_constants];
+  memcpy(constant->lanes, lanes, sizeof(constant->lanes));
+  return program->num_constants++;
+}
+
+int x86_new_vreg(struct x86_program *program) {
+  assert(program);
+  return program->num_vregs++;
+}
+
+struct x86_instr *x86_new_instr(enum x86_opcode op, int size,
+                                struct x86_operand src,
+                                struct x86_operand dst) {
+  struct x86_instr *instr = memory_alloc(MEMORY_X86, sizeof(*instr));
+  if (instr == NULL)
+    ERROR_OUT();
+
+  instr->op = op;
+  instr->size = size;
+  instr->src = src;
+  instr->dst = dst;
+  instr->index = X86_NONE();
+  instr->imm = 0;
+  instr->prev = NULL;
+  instr->next = NULL;
+
+  return instr;
+}
+
+void x86_append(struct x86_program *program, struct x86_instr *instr) {
+  assert(program && instr);
+
+  instr->prev = program->tail;
+  instr->next = NULL;
+
+  if (program->tail) {
+    program->tail->next = instr;
+  } else {
+    program->head = instr;
+  }
+  program->tail = instr;
+  program->num_instrs++;
+}
+
+void x86_insert_before(struct x86_program *program, struct x86_instr *at,
+                       struct x86_instr *instr) {
+  assert(program && at && instr);
+
+  instr->prev = at->prev;
+  instr->next = at;
+
+  if (at->prev) {
+    at->prev->next = instr;
+  } else {
+    program->head = instr;
+  }
+  at->prev = instr;
+  program->num_instrs++;
+}
+
+void x86_insert_after(struct x86_program *program, struct x86_instr *at,
+                      struct x86_instr *instr) {
+  assert(program && at && instr);
+
+  if (at->next == NULL) {
+    x86_append(program, instr);
+    return;
+  }
+
+  x86_insert_before(program, at->next, instr);
+}
+
+void x86_remove(struct x86_program *program, struct x86_instr *instr) {
+  assert(program && instr);
+
+  if (instr->prev) {
+    instr->prev->next = instr->next;
+  } else {
+    program->head = instr->next;
+  }
+
+  if (instr->next) {
+    instr->next->prev = instr->prev;
+  } else {
+    program->tail = instr->prev;
+  }
+
+  program->num_instrs--;
+  memory_free(instr);
+}
+
+struct x86_instr *x86_emit_op(struct x86_program *program, enum x86_opcode op,
+                              struct x86_operand src, struct x86_operand dst) {
+  struct x86_instr *instr = x86_new_instr(op, 4, src, dst);
+  x86_append(program, instr);
+  return instr;
+}
+
+bool x86_is_caller_saved(enum x86_reg reg) {
+  switch (reg) {
+  case REG_RAX:
+  case REG_RCX:
+  case REG_RDX:
+  case REG_RSI:
+  case REG_RDI:
+  case REG_R8:
+  case REG_R9:
+  case REG_R10:
+  case REG_R11:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static const enum x86_reg argument_regs[] = {REG_RDI, REG_RSI, REG_RDX,
+                                             REG_RCX, REG_R8,  REG_R9};
+
+static bool is_register(struct x86_operand operand) {
+  return operand.type == X86_REG || operand.type == X86_VREG;
+}
+
+static int add(struct x86_operand *operands, int count,
+               struct x86_operand operand) {
+  if (!is_register(operand))
+    return count;
+
+  assert(count < X86_MAX_OPERANDS);
+  operands[count] = operand;
+  return count + 1;
+}
+
+static bool is_zero_idiom(struct x86_instr *instr) {
+  return instr->op == X86_XOR && is_register(instr->src) &&
+         instr->src.type == instr->dst.type &&
+         instr->src.value == instr->dst.value;
+}
+
+int x86_uses(struct x86_instr *instr, struct x86_operand *uses) {
+  assert(instr && uses);
+
+  int count = 0;
+
+  switch (instr->op) {
+  case X86_MOV:
+  case X86_IMUL3:
+  case X86_PUSH:
+  case X86_MOVD:
+  case X86_PINSRD:
+    count = add(uses, count, instr->src);
+    break;
+
+  case X86_LEA:
+    count = add(uses, count, instr->src);
+    count = add(uses, count, instr->index);
+    break;
+
+  case X86_XOR:
+    if (is_zero_idiom(instr))
+      break;
+    // fallthrough
+  case X86_ADD:
+  case X86_SUB:
+  case X86_IMUL:
+  case X86_TEST:
+  case X86_CMOVNE:
+  case X86_SHL:
+  case X86_SAR:
+  case X86_SHR:
+    count = add(uses, count, instr->src);
+    count = add(uses, count, instr->dst);
+    break;
+
+  case X86_NEG:
+    count = add(uses, count, instr->dst);
+    break;
+
+  case X86_IMUL1:
+    count = add(uses, count, instr->src);
+    count = add(uses, count, X86_REG(REG_RAX));
+    break;
+
+  case X86_IDIV:
+    count = add(uses, count, instr->src);
+    count = add(uses, count, X86_REG(REG_RAX));
+    count = add(uses, count, X86_REG(REG_RDX));
+    break;
+
+  case X86_CDQ:
+    count = add(uses, count, X86_REG(REG_RAX));
+    break;
+
+  case X86_CALL:
+    for (int i = 0; i < instr->imm; i++) {
+      count = add(uses, count, X86_REG(argument_regs[i]));
+    }
+    break;
+
+  case X86_RET:
+    count = add(uses, count, X86_REG(REG_RAX));
+    break;
+
+  case X86_POP:
+  case X86_MOVDQA:
+  case X86_PEXTRD:
+  case X86_PSHUFD:
+  case X86_PADDD:
+  case X86_PSUBD:
+  case X86_PMULLD:
+    break;
+
+  default:
+    UNREACHABLE();
+  }
+
+  return count;
+}
+
+int x86_defs(struct x86_instr *instr, struct x86_operand *defs) {
+  assert(instr && defs);
+
+  int count = 0;
+
+  switch (instr->op) {
+  case X86_MOV:
+  case X86_LEA:
+  case X86_IMUL3:
+  case X86_ADD:
+  case X86_SUB:
+  case X86_IMUL:
+  case X86_XOR:
+  case X86_NEG:
+  case X86_SHL:
+  case X86_SAR:
+  case X86_SHR:
+  case X86_CMOVNE:
+  case X86_POP:
+  case X86_MOVD:
+  case X86_PEXTRD:
+    count = add(defs, count, instr->dst);
+    break;
+
+  case X86_IMUL1:
+  case X86_IDIV:
+    count = add(defs, count, X86_REG(REG_RAX));
+    count = add(defs, count, X86_REG(REG_RDX));
+    break;
+
+  case X86_CDQ:
+    count = add(defs, count, X86_REG(REG_RDX));
+    break;
+
+  case X86_CALL:
+    for (int reg = 0; reg < NUM_REGS; reg++) {
+      if (x86_is_caller_saved(reg))
+        count = add(defs, count, X86_REG(reg));
+    }
+    break;
+
+  case X86_TEST:
+  case X86_PUSH:
+  case X86_RET:
+  case X86_MOVDQA:
+  case X86_PINSRD:
+  case X86_PSHUFD:
+  case X86_PADDD:
+  case X86_PSUBD:
+  case X86_PMULLD:
+    break;
+
+  default:
+    UNREACHABLE();
+  }
+
+  return count;
+}
+
+static const enum x86_reg callee_saved[] = {REG_RBX, REG_R12, REG_R13,
+                                            REG_R14, REG_R15};
+
+#define NUM_CALLEE_SAVED ((int)(sizeof(callee_saved) / sizeof(callee_saved[0])))
+
+// Lays out the frame once every virtual register has been replaced:
+//
+//   8(%rbp)    return address
+//   0(%rbp)    saved %rbp
+//   -8(%rbp)   callee-saved registers written by the body
+//   ...        4-byte slots, the frame rounded up to keep %rsp 16-aligned
+void x86_frame(struct x86_program *program) {
+  assert(program);
+
+  bool saved[NUM_REGS] = {false};
+  bool prints = false;
+  bool divides = false;
+  struct x86_operand defs[X86_MAX_OPERANDS];
+
+  for (struct x86_instr *instr = program->head; instr; instr = instr->next) {
+    prints |= instr->op == X86_CALL;
+    divides |= instr->op == X86_IDIV;
+    int num_defs = x86_defs(instr, defs);
+    for (int i = 0; i < num_defs; i++) {
+      assert(defs[i].type == X86_REG);
+      saved[defs[i].value] = true;
+    }
+  }
+
+  int num_saved = 0;
+  for (int i = 0; i < NUM_CALLEE_SAVED; i++) {
+    if (saved[callee_saved[i]])
+      num_saved++;
+  }
+
+  program->slot_base = 8 * num_saved;
+  int frame = (program->slot_base + 4 * program->num_slots + 15) / 16 * 16 -
+              program->slot_base;
+
+  struct x86_instr *body = program->head;
+  struct x86_instr *prologue[4 + NUM_CALLEE_SAVED];
+  int num_prologue = 0;
+
+  prologue[num_prologue++] =
+      x86_new_instr(X86_PUSH, 8, X86_REG(REG_RBP), X86_NONE());
+  prologue[num_prologue++] =
+      x86_new_instr(X86_MOV, 8, X86_REG(REG_RSP), X86_REG(REG_RBP));
+  for (int i = 0; i < NUM_CALLEE_SAVED; i++) {
+    if (saved[callee_saved[i]]) {
+      prologue[num_prologue++] = x86_new_instr(
+          X86_PUSH, 8, X86_REG(callee_saved[i]), X86_NONE());
+    }
+  }
+  if (frame > 0) {
+    prologue[num_prologue++] =
+        x86_new_instr(X86_SUB, 8, X86_IMM(frame), X86_REG(REG_RSP));
+  }
+  // A division that traps flushes the output and exits as under --run.
+  if (divides) {
+    prologue[num_prologue++] =
+        x86_new_instr(X86_CALL, 4, X86_SYMBOL(SYM_PRINT_INIT), X86_NONE());
+  }
+
+  for (int i = 0; i < num_prologue; i++) {
+    if (body) {
+      x86_insert_before(program, body, prologue[i]);
+    } else {
+      x86_append(program, prologue[i]);
+    }
+  }
+
+  // Whatever the print runtime still buffers is written before returning.
+  if (prints) {
+    x86_append(program, x86_new_instr(X86_CALL, 4, X86_SYMBOL(SYM_PRINT_FLUSH),
+                                      X86_NONE()));
+  }
+  x86_append(program, x86_new_instr(X86_MOV, 4, X86_IMM(0), X86_REG(REG_RAX)));
+  if (frame > 0) {
+    x86_append(program,
+               x86_new_instr(X86_ADD, 8, X86_IMM(frame), X86_REG(REG_RSP)));
+  }
+  for (int i = NUM_CALLEE_SAVED - 1; i >= 0; i--) {
+    if (saved[callee_saved[i]]) {
+      x86_append(program, x86_new_instr(X86_POP, 8, X86_NONE(),
+                                        X86_REG(callee_saved[i])));
+    }
+  }
+  x86_append(program,
+             x86_new_instr(X86_POP, 8, X86_NONE(), X86_REG(REG_RBP)));
+  x86_append(program, x86_new_instr(X86_RET, 8, X86_NONE(), X86_NONE()));
+}
+
+static const char *reg_to_string(enum x86_reg reg, int size) {
+  static const char *names64[NUM_REGS] = {
+      "%rax", "%rcx", "%rdx", "%rbx", "%rsp", "%rbp", "%rsi", "%rdi",
+      "%r8",  "%r9",  "%r10", "%r11", "%r12", "%r13", "%r14", "%r15"};
+  static const char *names32[NUM_REGS] = {
+      "%eax", "%ecx", "%edx", "%ebx", "%esp", "%ebp", "%esi",  "%edi",
+      "%r8d", "%r9d", "%r10d", "%r11d", "%r12d", "%r13d", "%r14d", "%r15d"};
+
+  assert(0 <= reg && reg < NUM_REGS);
+  return size == 8 ? names64[reg] : names32[reg];
+}
+
+const char *x86_symbol_name(enum x86_symbol symbol) {
+  switch (symbol) {
+  case SYM_PRINT_I32:
+    return "print_i32";
+  case SYM_PRINT_BOOL:
+    return "print_bool";
+  case SYM_PRINT_FLUSH:
+    return "print_flush";
+  case SYM_PRINT_INIT:
+    return "print_init";
+  default:
+    UNREACHABLE();
+    return NULL;
+  }
+}
+
+static void emit_operand(struct x86_program *program,
+                         struct x86_operand operand, int size, FILE *file) {
+  switch (operand.type) {
+  case X86_IMM:
+    fprintf(file, "$%d", operand.value);
+    break;
+  case X86_REG:
+    fprintf(file, "%s", reg_to_string(operand.value, size));
+    break;
+  case X86_VREG:
+    fprintf(file, "%%v%d", operand.value);
+    break;
+  case X86_STACK:
+    fprintf(file, "-%d(%%rbp)", program->slot_base + 4 * (operand.value + 1));
+    break;
+  case X86_SYMBOL:
+    fprintf(file, "%s(%%rip)", x86_symbol_name(operand.value));
+    break;
+  case X86_XMM:
+    fprintf(file, "%%xmm%d", operand.value);
+    break;
+  case X86_CONSTANT:
+    fprintf(file, ".Lconstant%d(%%rip)", operand.value);
+    break;
+  default:
+    UNREACHABLE();
+  }
+}
+
+static const char *opcode_to_string(enum x86_opcode op) {
+  switch (op) {
+  case X86_MOV:
+    return "mov";
+  case X86_ADD:
+    return "add";
+  case X86_SUB:
+    return "sub";
+  case X86_IMUL:
+  case X86_IMUL3:
+  case X86_IMUL1:
+    return "imul";
+  case X86_IDIV:
+    return "idiv";
+  case X86_NEG:
+    return "neg";
+  case X86_SHL:
+    return "shl";
+  case X86_SAR:
+    return "sar";
+  case X86_SHR:
+    return "shr";
+  case X86_XOR:
+    return "xor";
+  case X86_LEA:
+    return "lea";
+  case X86_TEST:
+    return "test";
+  case X86_CMOVNE:
+    return "cmovne";
+  case X86_PUSH:
+    return "push";
+  case X86_POP:
+    return "pop";
+  case X86_MOVD:
+    return "movd";
+  case X86_MOVDQA:
+    return "movdqa";
+  case X86_PINSRD:
+    return "pinsrd";
+  case X86_PEXTRD:
+    return "pextrd";
+  case X86_PSHUFD:
+    return "pshufd";
+  case X86_PADDD:
+    return "paddd";
+  case X86_PSUBD:
+    return "psubd";
+  case X86_PMULLD:
+    return "pmulld";
+  default:
+    UNREACHABLE();
+    return NULL;
+  }
+}
+
+static void emit_instr(struct x86_program *program, struct x86_instr *instr,
+                       FILE *file) {
+  char suffix = instr->size == 8 ? 'q' : 'l';
+
+  switch (instr->op) {
+  case X86_CDQ:
+    fprintf(file, "\tcltd\n");
+    return;
+
+  case X86_RET:
+    fprintf(file, "\tret\n");
+    return;
+
+  case X86_CALL:
+    assert(instr->src.type == X86_SYMBOL);
+    fprintf(file, "\tcall %s\n", x86_symbol_name(instr->src.value));
+    return;
+
+  case X86_IMUL1:
+  case X86_IDIV:
+  case X86_PUSH:
+    fprintf(file, "\t%s%c ", opcode_to_string(instr->op), suffix);
+    emit_operand(program, instr->src, instr->size, file);
+    fprintf(file, "\n");
+    return;
+
+  case X86_NEG:
+  case X86_POP:
+    fprintf(file, "\t%s%c ", opcode_to_string(instr->op), suffix);
+    emit_operand(program, instr->dst, instr->size, file);
+    fprintf(file, "\n");
+    return;
+
+  case X86_MOVD:
+  case X86_MOVDQA:
+  case X86_PADDD:
+  case X86_PSUBD:
+  case X86_PMULLD:
+    fprintf(file, "\t%s ", opcode_to_string(instr->op));
+    emit_operand(program, instr->src, 4, file);
+    fprintf(file, ", ");
+    emit_operand(program, instr->dst, 4, file);
+    fprintf(file, "\n");
+    return;
+
+  case X86_PINSRD:
+  case X86_PEXTRD:
+  case X86_PSHUFD:
+    fprintf(file, "\t%s $%d, ", opcode_to_string(instr->op), instr->imm);
+    emit_operand(program, instr->src, 4, file);
+    fprintf(file, ", ");
+    emit_operand(program, instr->dst, 4, file);
+    fprintf(file, "\n");
+    return;
+
+  case X86_IMUL3:
+    fprintf(file, "\timul%c $%d, ", suffix, instr->imm);
+    emit_operand(program, instr->src, instr->size, file);
+    fprintf(file, ", ");
+    emit_operand(program, instr->dst, instr->size, file);
+    fprintf(file, "\n");
+    return;
+
+  case X86_LEA:
+    fprintf(file, "\tlea%c ", suffix);
+    if (instr->src.type == X86_SYMBOL) {
+      emit_operand(program, instr->src, 8, file);
+    } else {
+      fprintf(file, "(");
+      emit_operand(program, instr->src, 8, file);
+      fprintf(file, ", ");
+      emit_operand(program, instr->index, 8, file);
+      fprintf(file, ", %d)", instr->imm);
+    }
+    fprintf(file, ", ");
+    emit_operand(program, instr->dst, instr->size, file);
+    fprintf(file, "\n");
+    return;
+
+  default:
+    fprintf(file, "\t%s%c ", opcode_to_string(instr->op), suffix);
+    emit_operand(program, instr->src, instr->size, file);
+    fprintf(file, ", ");
+    emit_operand(program, instr->dst, instr->size, file);
+    fprintf(file, "\n");
+    return;
+  }
+}
+
+void x86_emit(struct x86_program *program, FILE *file) {
+  assert(program && file);
+
+  fprintf(file, "\t.text\n\t.globl main\n\t.type main, @function\n");
+  fprintf(file, "main:\n");
+
+  for (struct x86_instr *instr = program->head; instr; instr = instr->next) {
+    emit_instr(program, instr, file);
+  }
+
+  // Padded like the runtime after it, so that encode() matches GAS.
+  if (program->num_constants > 0)
+    fprintf(file, "\t.p2align 4, 0xcc\n");
+  for (int i = 0; i < program->num_constants; i++) {
+    const int *lanes = program->constants[i].lanes;
+    fprintf(file, ".Lconstant%d:\n\t.long %d, %d, %d, %d\n", i, lanes[0],
+            lanes[1], lanes[2], lanes[3]);
+  }
+
+  fprintf(file, "\t.size main, .-main\n\n");
+  fputs(runtime_print_source, file);
+  fprintf(file, "\t.section .note.GNU-stack,\"\",@progbits\n");
+}
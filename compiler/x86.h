@@ -0,0 +1,191 @@
+#ifndef x86_h
+#define x86_h
+
+#include "common.h"
+
+// x86-64 machine instructions. Instruction selection produces virtual
+// registers; register allocation replaces them with physical registers and
+// stack slots, after which the frame is laid out and the list is emitted.
+
+// Hardware encoding order.
+enum x86_reg {
+  REG_RAX,
+  REG_RCX,
+  REG_RDX,
+  REG_RBX,
+  REG_RSP,
+  REG_RBP,
+  REG_RSI,
+  REG_RDI,
+  REG_R8,
+  REG_R9,
+  REG_R10,
+  REG_R11,
+  REG_R12,
+  REG_R13,
+  REG_R14,
+  REG_R15,
+  NUM_REGS
+};
+
+// Never allocated: used to legalise instructions with spilled operands.
+#define REG_SCRATCH_A REG_R10
+#define REG_SCRATCH_B REG_R11
+
+// Functions of the print runtime (runtime/print.s), which follows main.
+enum x86_symbol {
+  SYM_PRINT_I32,
+  SYM_PRINT_BOOL,
+  SYM_PRINT_FLUSH,
+  SYM_PRINT_INIT,
+  NUM_SYMBOLS
+};
+
+enum x86_operand_type {
+  X86_NONE,
+  X86_IMM,
+  X86_REG,
+  X86_VREG,
+  X86_STACK,  // 4-byte spill slot, value is the slot index
+  X86_SYMBOL, // rip-relative address or call target
+  X86_XMM,      // %xmm register, value is its number; never allocated
+  X86_CONSTANT, // 16-byte constant after main, value is its index
+};
+
+struct x86_operand {
+  enum x86_operand_type type;
+  int value;
+};
+
+enum x86_opcode {
+  X86_MOV,   // dst <- src
+  X86_ADD,   // dst <- dst + src
+  X86_SUB,   // dst <- dst - src
+  X86_IMUL,  // dst <- dst * src
+  X86_IMUL3, // dst <- src * imm
+  X86_IMUL1, // edx:eax <- eax * src
+  X86_IDIV,  // eax, edx <- edx:eax / src, edx:eax % src
+  X86_CDQ,   // edx <- sign of eax
+  X86_NEG,   // dst <- -dst
+  X86_SHL,   // dst <- dst << src
+  X86_SAR,   // dst <- dst >> src (arithmetic)
+  X86_SHR,   // dst <- dst >> src (logical)
+  X86_XOR,   // dst <- dst ^ src
+  X86_LEA,   // dst <- src + index * imm, or the address of a symbol
+  X86_TEST,  // flags <- src & dst
+  X86_CMOVNE, // dst <- src if not zero
+  X86_CALL,  // call src with imm integer arguments in registers
+  X86_PUSH,
+  X86_POP,
+  X86_RET,
+
+  // Four 32-bit lanes of %xmm registers, from vectorised IR packs.
+  X86_MOVD,   // dst <- src, lane 0 of the %xmm one, the others zeroed
+  X86_MOVDQA, // dst <- src, all lanes
+  X86_PINSRD, // lane imm of dst <- src
+  X86_PEXTRD, // dst <- lane imm of src
+  X86_PSHUFD, // lane i of dst <- lane (imm >> 2i) & 3 of src
+  X86_PADDD,  // dst <- dst + src, per lane
+  X86_PSUBD,  // dst <- dst - src, per lane
+  X86_PMULLD, // dst <- dst * src, per lane, low 32 bits (SSE4.1)
+};
+
+struct x86_instr {
+  enum x86_opcode op;
+
+  // Operand size in bytes: 4, or 8 for pointers and the frame.
+  int size;
+
+  struct x86_operand src;
+  struct x86_operand dst;
+  struct x86_operand index;
+  int imm;
+
+  struct x86_instr *prev;
+  struct x86_instr *next;
+};
+
+// Lanes of an %xmm register.
+#define X86_LANES 4
+
+// Read by vector instructions from after the end of main, 16-byte aligned.
+struct x86_constant {
+  int lanes[X86_LANES];
+};
+
+// Upper bound on the rules in peephole.c.
+#define X86_MAX_PEEPHOLE_RULES 8
+
+struct x86_program {
+  struct x86_instr *head;
+  struct x86_instr *tail;
+  int num_instrs;
+
+  int num_vregs;
+  int num_slots;
+
+  struct x86_constant *constants;
+  int num_constants;
+  int constants_capacity;
+
+  // Filled in by register allocation.
+  int num_spills;
+  bool used_regs[NUM_REGS];
+
+  // Filled in by peephole(), indexed by enum peephole_rule.
+  int peephole_hits[X86_MAX_PEEPHOLE_RULES];
+
+  // Filled in by x86_frame(): bytes between %rbp and the first slot.
+  int slot_base;
+};
+
+#define X86_IMM(n) ((struct x86_operand){.type = X86_IMM, .value = (n)})
+#define X86_REG(r) ((struct x86_operand){.type = X86_REG, .value = (r)})
+#define X86_VREG(n) ((struct x86_operand){.type = X86_VREG, .value = (n)})
+#define X86_STACK(n) ((struct x86_operand){.type = X86_STACK, .value = (n)})
+#define X86_SYMBOL(s) ((struct x86_operand){.type = X86_SYMBOL, .value = (s)})
+#define X86_XMM(n) ((struct x86_operand){.type = X86_XMM, .value = (n)})
+#define X86_CONSTANT(n)                                                        \
+  ((struct x86_operand){.type = X86_CONSTANT, .value = (n)})
+#define X86_NONE() ((struct x86_operand){.type = X86_NONE, .value = 0})
+
+#define X86_NUM_XMM 16
+
+// Upper bound on the registers an instruction reads or writes.
+#define X86_MAX_OPERANDS 12
+
+struct x86_program *x86_new(void);
+void x86_free(struct x86_program **program);
+
+int x86_new_vreg(struct x86_program *program);
+
+// Index of a constant with these lanes, shared with any equal one.
+int x86_new_constant(struct x86_program *program, const int *lanes);
+struct x86_instr *x86_new_instr(enum x86_opcode op, int size,
+                                struct x86_operand src,
+                                struct x86_operand dst);
+
+void x86_append(struct x86_program *program, struct x86_instr *instr);
+void x86_insert_before(struct x86_program *program, struct x86_instr *at,
+                       struct x86_instr *instr);
+void x86_insert_after(struct x86_program *program, struct x86_instr *at,
+                      struct x86_instr *instr);
+void x86_remove(struct x86_program *program, struct x86_instr *instr);
+
+struct x86_instr *x86_emit_op(struct x86_program *program, enum x86_opcode op,
+                              struct x86_operand src, struct x86_operand dst);
+
+bool x86_is_caller_saved(enum x86_reg reg);
+
+// Label of the function in runtime/print.s.
+const char *x86_symbol_name(enum x86_symbol symbol);
+
+// Register and virtual register operands read and written by an instruction,
+// including implicit ones. Returns the number written to uses/defs.
+int x86_uses(struct x86_instr *instr, struct x86_operand *uses);
+int x86_defs(struct x86_instr *instr, struct x86_operand *defs);
+
+void x86_frame(struct x86_program *program);
+void x86_emit(struct x86_program *program, FILE *file);
+
+#endif
@@ -1,24 +1,105 @@
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "compiler/ast.h"
+#include "compiler/bytecode.h"
+#include "compiler/cgen.h"
 #include "compiler/common.h"
+#include "compiler/compiler.h"
+#include "compiler/diagnostics.h"
+#include "compiler/eval.h"
+#include "compiler/ir.h"
+#include "compiler/isel.h"
+#include "compiler/jit.h"
+#include "compiler/memory.h"
+#include "compiler/object.h"
+#include "compiler/output.h"
 #include "compiler/parser.h"
+#include "compiler/passes.h"
+#include "compiler/pool.h"
 #include "compiler/resolver.h"
 #include "compiler/scanner.h"
+#include "compiler/server.h"
 #include "compiler/symbols.h"
+#include "compiler/timer.h"
+#include "compiler/toolchain.h"
+#include "compiler/trace.h"
 #include "compiler/typechecker.h"
+#include "compiler/vm.h"
+#include "compiler/x86.h"
+
+enum interpreter { INTERPRET_NONE, INTERPRET_AST, INTERPRET_BYTECODE };
+
+enum time_passes { TIME_PASSES_NONE, TIME_PASSES_TABLE, TIME_PASSES_JSON };
+
+struct options {
+  bool dump_ast;
+  bool dump_ir;
+  bool pass_stats;
+  bool emit_asm;
+  bool emit_object;
+  bool emit_c;
+  bool freestanding;
+  bool run;
+  bool dump_bytecode;
+  enum interpreter interpreter;
+  enum time_passes time_passes;
+  bool perf_counters;
+  bool mem_stats;
+  const char *trace;
+  bool trace_each_statement;
+  const char *output;
+  int opt_level;
+
+  // Compiling more than one file.
+  const char *manifest;
+  int jobs;
+
+  // Compiling in a server, or serving.
+  const char *connect;
+  const char *serve;
+};
+
+// A file of a batch. What its compile reports is kept until the files
+// before it have been reported.
+struct batch_file {
+  const char *path;
+  char *out;
+  size_t out_size;
+  char *err;
+  size_t err_size;
+  int status;
+  bool done;
+};
+
+struct batch {
+  struct options *options;
+  struct batch_file *files;
+  pass_manager_t **managers;
+
+  pthread_mutex_t lock;
+  pthread_cond_t done;
+};
+
+// Program output of --run and --interpret.
+static struct output program_output;
 
 char *read_file(const char *path) {
   FILE *file = fopen(path, "rb");
-  if (file == NULL)
-    ERROR_OUT();
+  if (file == NULL) {
+    fprintf(diagnostics_out(), "[error] Could not open '%s'.\n", path);
+    return NULL;
+  }
 
   fseek(file, 0L, SEEK_END);
   size_t size = ftell(file);
   rewind(file);
 
-  char *buffer = (char *)malloc(size + 1);
+  char *buffer = (char *)memory_alloc(MEMORY_SOURCE, size + 1);
   if (buffer == NULL)
     ERROR_OUT();
 
@@ -32,42 +113,761 @@ char *read_file(const char *path) {
   return buffer;
 }
 
-int main(int argc, char *argv[]) {
-  if (argc < 2) {
-    printf("[error] Usage: %s <file> [--dump-ast]\n", argv[0]);
-    return 1;
-  }
+static long long now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
 
-  bool dump_ast = (argc == 3 && strcmp(argv[2], "--dump-ast") == 0);
-  char *src = read_file(argv[1]);
+static void usage(const char *name) {
+  printf("[error] Usage: %s <file>... [--manifest=<path>] [--jobs=<n>] "
+         "[-O0|-O1|-O2] [--enable=<pass>] "
+         "[--disable=<pass>] [--pass-stats] [--time-passes[=json]] "
+         "[--perf-counters] [--mem-stats] [--trace=<path>] "
+         "[--trace-statements] "
+         "[--dump-ast] [--dump-ir] [--dump-bytecode] [-S|-c|--emit=c] "
+         "[--freestanding] [--run] [--interpret[=ast|bytecode]] "
+         "[-o <path>] [--connect=<socket>]\n"
+         "       %s --serve=<socket> [--jobs=<n>]\n"
+         "-O2 emits SSE4.1 instructions (x86-64-v2); --disable=slp avoids "
+         "them.\n",
+         name, name);
+}
 
+// The parser pulls tokens from the scanner as it goes, so for
+// --time-passes the source is also scanned on its own first. Returns the
+// number of tokens, including the end.
+static long long scan(const char *src) {
   scanner_t *scanner = scanner_new(src);
-  parser_t *parser = parser_new(scanner);
+  long long count = 1;
+  while (scanner_read_token(scanner).type != TOKEN_EOF)
+    count++;
+  scanner_free(&scanner);
+  return count;
+}
+
+// A phase, timed and traced.
+static void begin(struct timer *timer, const char *name) {
+  TRACE_BEGIN(name);
+  timer_begin(timer, name);
+}
+
+static void end(struct timer *timer, long long count, const char *unit) {
+  timer_end(timer, count, unit);
+  TRACE_END();
+}
+
+// AST nodes, counted only when they are reported.
+static long long nodes(struct timer *timer, struct ast_node *root) {
+  return timer->enabled ? ast_count(root) : 0;
+}
+
+// Fills options from the arguments and inputs with those that are not
+// options, the files to compile. Returns false on an unknown option.
+static bool parse_options(int argc, char *argv[], struct options *options,
+                          const char **inputs, int *num_inputs) {
+  *options = (struct options){.opt_level = 1};
+  *num_inputs = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] != '-') {
+      inputs[(*num_inputs)++] = argv[i];
+    } else if (strcmp(argv[i], "--dump-ast") == 0) {
+      options->dump_ast = true;
+    } else if (strcmp(argv[i], "--dump-ir") == 0) {
+      options->dump_ir = true;
+    } else if (strcmp(argv[i], "--pass-stats") == 0) {
+      options->pass_stats = true;
+    } else if (strcmp(argv[i], "--time-passes") == 0) {
+      options->time_passes = TIME_PASSES_TABLE;
+    } else if (strcmp(argv[i], "--time-passes=json") == 0) {
+      options->time_passes = TIME_PASSES_JSON;
+    } else if (strcmp(argv[i], "--perf-counters") == 0) {
+      options->perf_counters = true;
+    } else if (strcmp(argv[i], "--mem-stats") == 0) {
+      options->mem_stats = true;
+    } else if (strncmp(argv[i], "--trace=", 8) == 0 && argv[i][8] != '\0') {
+      options->trace = argv[i] + 8;
+    } else if (strcmp(argv[i], "--trace-statements") == 0) {
+      options->trace_each_statement = true;
+    } else if (strcmp(argv[i], "-S") == 0) {
+      options->emit_asm = true;
+    } else if (strcmp(argv[i], "-c") == 0) {
+      options->emit_object = true;
+    } else if (strcmp(argv[i], "--emit=c") == 0) {
+      options->emit_c = true;
+    } else if (strcmp(argv[i], "--freestanding") == 0) {
+      options->freestanding = true;
+    } else if (strcmp(argv[i], "--run") == 0) {
+      options->run = true;
+    } else if (strcmp(argv[i], "--interpret") == 0 ||
+               strcmp(argv[i], "--interpret=bytecode") == 0) {
+      options->interpreter = INTERPRET_BYTECODE;
+    } else if (strcmp(argv[i], "--interpret=ast") == 0) {
+      options->interpreter = INTERPRET_AST;
+    } else if (strcmp(argv[i], "--dump-bytecode") == 0) {
+      options->dump_bytecode = true;
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      options->output = argv[++i];
+    } else if (strncmp(argv[i], "-O", 2) == 0 && strlen(argv[i]) == 3 &&
+               '0' <= argv[i][2] && argv[i][2] <= '0' + MAX_OPT_LEVEL) {
+      options->opt_level = argv[i][2] - '0';
+    } else if (strncmp(argv[i], "--manifest=", 11) == 0 &&
+               argv[i][11] != '\0') {
+      options->manifest = argv[i] + 11;
+    } else if (strncmp(argv[i], "--jobs=", 7) == 0 && atoi(argv[i] + 7) > 0) {
+      options->jobs = atoi(argv[i] + 7);
+    } else if (strncmp(argv[i], "--connect=", 10) == 0 &&
+               argv[i][10] != '\0') {
+      options->connect = argv[i] + 10;
+    } else if (strncmp(argv[i], "--serve=", 8) == 0 && argv[i][8] != '\0') {
+      options->serve = argv[i] + 8;
+    } else if (strncmp(argv[i], "--enable=", 9) != 0 &&
+               strncmp(argv[i], "--disable=", 10) != 0) {
+      return false;
+    }
+  }
 
+  return true;
+}
+
+// The pipeline chosen by -O, with the explicit toggles applied over it in
+// order. NULL if a toggle names no pass.
+static pass_manager_t *new_pass_manager(int opt_level, int argc,
+                                        char *argv[]) {
+  pass_manager_t *manager = pass_manager_new(opt_level);
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-o") == 0) {
+      i++;
+      continue;
+    }
+
+    bool enable = strncmp(argv[i], "--enable=", 9) == 0;
+    bool disable = strncmp(argv[i], "--disable=", 10) == 0;
+    if (!enable && !disable)
+      continue;
+
+    const char *name = strchr(argv[i], '=') + 1;
+    if (!pass_manager_set_enabled(manager, name, enable)) {
+      printf("[error] Unknown pass '%s'.\n", name);
+      pass_manager_free(&manager);
+      return NULL;
+    }
+  }
+
+  return manager;
+}
+
+// Compiles one file to output, or to the default of the output mode if it
+// is NULL. Returns the exit status.
+static int compile(struct options *options, const char *path,
+                   const char *output, pass_manager_t *manager) {
+  struct timer timer;
+  timer_init(&timer, options->time_passes != TIME_PASSES_NONE ||
+                         options->perf_counters || options->mem_stats);
+  pass_manager_set_timer(manager, &timer);
+
+  // Containers and virtual machines often allow no hardware events at all;
+  // the times are reported instead.
+  if (options->perf_counters && !timer_enable_perf(&timer) &&
+      options->time_passes != TIME_PASSES_JSON) {
+    fprintf(stderr,
+            "[warning] Hardware counters are not available (%s), reporting "
+            "times only.\n",
+            strerror(timer.perf.error));
+  }
+
+  long long start = now();
+  TRACE_BEGIN("compile");
+
+  symbol_table_t *table = symbol_table_new(100);
+  scanner_t *scanner = NULL;
+  parser_t *parser = NULL;
+
+  long long tokens = 0;
   struct ast_node *root = NULL;
+  struct ir_program *program = NULL;
+  struct x86_program *machine = NULL;
+  struct bytecode *code = NULL;
+  int status = 1;
+
+  begin(&timer, "read");
+  char *src = read_file(path);
+  if (src == NULL) {
+    goto cleanup;
+  }
+  end(&timer, strlen(src), "bytes");
+
+  if (timer.enabled) {
+    begin(&timer, "scan");
+    tokens = scan(src);
+    end(&timer, tokens, "tokens");
+  }
+
+  scanner = scanner_new(src);
+  parser = parser_new(scanner);
+
+  // Parsing includes scanning again.
+  begin(&timer, "parse");
   if (!parser_run(parser, &root)) {
     goto cleanup;
   }
+  end(&timer, tokens, "tokens");
 
-  symbol_table_t *table = symbol_table_new(100);
+  begin(&timer, "resolve");
   if (!resolver_generate_table(root, table)) {
     goto cleanup;
   }
+  end(&timer, nodes(&timer, root), "nodes");
 
+  begin(&timer, "typecheck");
   if (typecheck(root, table) == TYPE_ERROR) {
     goto cleanup;
   }
+  end(&timer, nodes(&timer, root), "nodes");
+
+  pass_manager_run_ast(manager, root);
 
-  if (dump_ast) {
+  if (options->dump_ast) {
+    begin(&timer, "dump-ast");
     ast_write_mermaid(root, "ast.svg");
+    end(&timer, nodes(&timer, root), "nodes");
+  }
+
+  if (options->interpreter != INTERPRET_AST && !options->emit_c) {
+    begin(&timer, "lower");
+    program = ir_new(root, table);
+    end(&timer, program->num_instrs, "instrs");
+
+    pass_manager_run_ir(manager, program);
+
+    if (options->dump_ir) {
+      ir_print(program, stdout);
+    }
+  }
+
+  if (options->interpreter == INTERPRET_BYTECODE) {
+    begin(&timer, "bytecode");
+    code = bytecode_new(program);
+    if (code == NULL)
+      goto cleanup;
+    end(&timer, program->num_instrs, "instrs");
+
+    if (options->dump_bytecode) {
+      bytecode_print(code, stdout);
+    }
+  } else if (options->interpreter == INTERPRET_NONE && !options->emit_c) {
+    begin(&timer, "isel");
+    machine = isel(program);
+    end(&timer, program->num_instrs, "instrs");
+
+    pass_manager_run_x86(manager, machine);
+
+    begin(&timer, "frame");
+    x86_frame(machine);
+    end(&timer, machine->num_instrs, "instrs");
+  }
+
+  long long compiled = now();
+  struct jit_stats jit_stats = {0};
+  long long executed = compiled;
+
+  if (options->interpreter != INTERPRET_NONE) {
+    begin(&timer, "interpret");
+    output_init(&program_output, stdout);
+    bool ok = options->interpreter == INTERPRET_AST
+                  ? eval(root, &program_output)
+                  : vm_run(code, &program_output);
+    output_flush(&program_output);
+    executed = now();
+    end(&timer, 0, NULL);
+
+    if (!ok) {
+      fprintf(stderr, "[error] The program trapped on a division.\n");
+      goto cleanup;
+    }
+  } else if (options->run) {
+    begin(&timer, "run");
+    output_init(&program_output, stdout);
+    if (!jit_run(machine, &program_output, &jit_stats))
+      goto cleanup;
+    end(&timer, 0, NULL);
+  } else if (options->emit_asm || options->emit_c) {
+    if (output == NULL)
+      output = options->emit_c ? "out.c" : "out.s";
+
+    FILE *file = fopen(output, "w");
+    if (file == NULL) {
+      fprintf(diagnostics_out(), "[error] Could not open '%s' for writing.\n",
+              output);
+      goto cleanup;
+    }
+
+    if (options->emit_c) {
+      begin(&timer, "cgen");
+      cgen(root, table, file);
+      end(&timer, nodes(&timer, root), "nodes");
+    } else {
+      begin(&timer, "emit");
+      x86_emit(machine, file);
+      end(&timer, machine->num_instrs, "instrs");
+    }
+    fclose(file);
+  } else if (options->emit_object) {
+    begin(&timer, "object");
+    if (!object_write(machine, output ? output : "out.o"))
+      goto cleanup;
+    end(&timer, machine->num_instrs, "instrs");
+  } else if (options->freestanding) {
+    begin(&timer, "executable");
+    if (!object_write_executable(machine, output ? output : "a.out"))
+      goto cleanup;
+    end(&timer, machine->num_instrs, "instrs");
+  } else {
+    // Includes running the assembler and linker.
+    begin(&timer, "link");
+    if (!toolchain_link(machine, output ? output : "a.out"))
+      goto cleanup;
+    end(&timer, machine->num_instrs, "instrs");
+  }
+
+  if (options->pass_stats) {
+    pass_manager_report(manager, stderr);
+  }
+
+  if (options->pass_stats && options->run &&
+      options->interpreter == INTERPRET_NONE) {
+    fprintf(stderr, "compile (us): %.2f\n", (compiled - start) / 1000.0);
+    fprintf(stderr, "load (us): %.2f\n", jit_stats.load / 1000.0);
+    fprintf(stderr, "run (us): %.2f\n", jit_stats.execute / 1000.0);
   }
 
+  if (options->pass_stats && options->interpreter == INTERPRET_BYTECODE) {
+    fprintf(stderr, "bytecode: %d instructions, %d fused, %d units\n",
+            code->num_instrs, code->num_superinstrs, code->size);
+  }
+
+  if (options->pass_stats && options->interpreter != INTERPRET_NONE) {
+    fprintf(stderr, "compile (us): %.2f\n", (compiled - start) / 1000.0);
+    fprintf(stderr, "run (us): %.2f\n", (executed - compiled) / 1000.0);
+  }
+
+  TRACE_END();
+  status = 0;
+
 cleanup:
-  free(src);
-  ast_free(&root);
-  parser_free(&parser);
-  scanner_free(&scanner);
+  // Also after a failure, covering the phases that completed.
+  if (timer.enabled) {
+    struct symbol_table_stats symbols = symbol_table_stats(table);
+    timer_count(&timer, "tokens", tokens);
+    timer_count(&timer, "symbol inserts", symbols.inserts);
+    timer_count(&timer, "symbol lookups", symbols.lookups);
+    timer_count(&timer, "symbol probes", symbols.probes);
+
+    // The JSON carries the events of each phase itself.
+    if (options->time_passes == TIME_PASSES_JSON) {
+      timer_report_json(&timer, stderr);
+    } else {
+      bool times_only = options->perf_counters && !timer.counting;
+      if (options->time_passes == TIME_PASSES_TABLE || times_only)
+        timer_report(&timer, stderr);
+      timer_report_events(&timer, stderr);
+    }
+  }
+
+  // Before the compiler's own structures are freed, so that live shows what
+  // they held at the end.
+  if (options->mem_stats) {
+    timer_report_memory(&timer, stderr);
+    memory_report(stderr);
+  }
+  timer_free(&timer);
+
+  memory_free(src);
+  if (machine)
+    x86_free(&machine);
+  if (code)
+    bytecode_free(&code);
+  if (program)
+    ir_free(&program);
+  if (root)
+    ast_free(&root);
+  if (parser)
+    parser_free(&parser);
+  if (scanner)
+    scanner_free(&scanner);
   symbol_table_free(&table);
 
-  return root ? 0 : 1;
+  return status;
+}
+
+// The option of those given that the server cannot honour, if any: it
+// compiles from memory to memory, so it neither runs native code nor walks
+// the syntax tree, and reports nothing but the diagnostics.
+static const char *local_option(struct options *options) {
+  if (options->run)
+    return "--run";
+  if (options->interpreter == INTERPRET_AST)
+    return "--interpret=ast";
+  if (options->dump_ast)
+    return "--dump-ast";
+  if (options->dump_ir)
+    return "--dump-ir";
+  if (options->dump_bytecode)
+    return "--dump-bytecode";
+  if (options->pass_stats)
+    return "--pass-stats";
+  if (options->time_passes != TIME_PASSES_NONE)
+    return "--time-passes";
+  if (options->perf_counters)
+    return "--perf-counters";
+  if (options->mem_stats)
+    return "--mem-stats";
+  if (options->trace)
+    return "--trace";
+  return NULL;
+}
+
+// Writes what the server compiled, executable if it is a program.
+static bool write_output(const char *path, const char *data, size_t size,
+                         bool executable) {
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, executable ? 0777 : 0666);
+  bool ok = fd >= 0 && write(fd, data, size) == (ssize_t)size;
+  ok = fd >= 0 && close(fd) == 0 && ok;
+
+  if (!ok)
+    fprintf(diagnostics_out(), "[error] Could not write '%s'.\n", path);
+  return ok;
+}
+
+// Has the server listening at options->connect compile the file, and
+// writes the output where compile would have, or what the program printed
+// to stdout, followed by the diagnostics. Returns the exit status.
+static int compile_remote(struct options *options, const char *path,
+                          int argc, char *argv[]) {
+  if (local_option(options)) {
+    printf("[error] %s does not work with --connect.\n",
+           local_option(options));
+    return 1;
+  }
+  if (options->interpreter == INTERPRET_NONE && !options->emit_c &&
+      !options->emit_asm && !options->emit_object && !options->freestanding) {
+    printf("[error] --connect does not link, add -c or --freestanding.\n");
+    return 1;
+  }
+
+  // As compile chooses them.
+  struct compiler_options request = {
+      .output = COMPILER_OUTPUT_EXECUTABLE,
+      .opt_level = options->opt_level,
+  };
+  const char *output = "a.out";
+  if (options->interpreter != INTERPRET_NONE) {
+    request.output = COMPILER_OUTPUT_RUN;
+  } else if (options->emit_c) {
+    request.output = COMPILER_OUTPUT_C;
+    output = "out.c";
+  } else if (options->emit_asm) {
+    request.output = COMPILER_OUTPUT_ASSEMBLY;
+    output = "out.s";
+  } else if (options->emit_object) {
+    request.output = COMPILER_OUTPUT_OBJECT;
+    output = "out.o";
+  }
+  if (options->output)
+    output = options->output;
+
+  // The toggles in order, as new_pass_manager applies them.
+  struct compiler_pass *passes =
+      memory_alloc(MEMORY_SERVER, argc * sizeof(*passes));
+  if (passes == NULL)
+    ERROR_OUT();
+  request.passes = passes;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-o") == 0) {
+      i++;
+      continue;
+    }
+
+    bool enable = strncmp(argv[i], "--enable=", 9) == 0;
+    bool disable = strncmp(argv[i], "--disable=", 10) == 0;
+    if (enable || disable)
+      passes[request.num_passes++] =
+          (struct compiler_pass){strchr(argv[i], '=') + 1, enable};
+  }
+
+  int status = 1;
+  char *src = read_file(path);
+  int server = src ? server_connect(options->connect) : -1;
+  struct server_reply reply;
+
+  if (server >= 0 &&
+      server_compile(server, src, strlen(src), &request, &reply)) {
+    if (request.output == COMPILER_OUTPUT_RUN) {
+      fwrite(reply.output, 1, reply.output_size, stdout);
+      fflush(stdout);
+    }
+    fwrite(reply.diagnostics, 1, reply.diagnostics_size, stdout);
+
+    if (reply.ok &&
+        (request.output == COMPILER_OUTPUT_RUN ||
+         write_output(output, reply.output, reply.output_size,
+                      request.output == COMPILER_OUTPUT_EXECUTABLE)))
+      status = 0;
+    server_reply_free(&reply);
+  }
+
+  if (server >= 0)
+    close(server);
+  memory_free(src);
+  memory_free(passes);
+  return status;
+}
+
+// The option of those given that needs a single input file, if any: they
+// write to a fixed place or report on one compile.
+static const char *single_file_option(struct options *options) {
+  if (options->connect)
+    return "--connect";
+  if (options->output)
+    return "-o";
+  if (options->run)
+    return "--run";
+  if (options->interpreter != INTERPRET_NONE)
+    return "--interpret";
+  if (options->dump_ast)
+    return "--dump-ast";
+  if (options->dump_ir)
+    return "--dump-ir";
+  if (options->dump_bytecode)
+    return "--dump-bytecode";
+  if (options->pass_stats)
+    return "--pass-stats";
+  if (options->time_passes != TIME_PASSES_NONE)
+    return "--time-passes";
+  if (options->perf_counters)
+    return "--perf-counters";
+  if (options->mem_stats)
+    return "--mem-stats";
+  return NULL;
+}
+
+// Where a file of a batch is compiled to: its path with the extension
+// replaced by that of the output, or removed for an executable. NULL if
+// that is the file itself.
+static char *batch_output(struct options *options, const char *path) {
+  const char *extension = options->emit_c        ? ".c"
+                          : options->emit_asm    ? ".s"
+                          : options->emit_object ? ".o"
+                                                 : "";
+
+  const char *base = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+  const char *dot = strrchr(base, '.');
+  size_t stem = dot && dot != base ? (size_t)(dot - path) : strlen(path);
+
+  char *output = memory_alloc(MEMORY_BATCH, stem + strlen(extension) + 1);
+  if (output == NULL)
+    ERROR_OUT();
+  memcpy(output, path, stem);
+  strcpy(output + stem, extension);
+
+  if (strcmp(output, path) == 0) {
+    memory_free(output);
+    return NULL;
+  }
+  return output;
+}
+
+// Runs on a worker of the pool. The diagnostics of the file are kept
+// rather than written, for the main thread to write in order.
+static void compile_file(void *context, int task, int worker) {
+  struct batch *batch = context;
+  struct batch_file *file = &batch->files[task];
+
+  if (batch->options->trace)
+    trace_start(batch->options->trace_each_statement);
+
+  FILE *out = open_memstream(&file->out, &file->out_size);
+  FILE *err = open_memstream(&file->err, &file->err_size);
+  if (out == NULL || err == NULL)
+    ERROR_OUT();
+  diagnostics_redirect(out, err);
+
+  int status = 1;
+  char *output = batch_output(batch->options, file->path);
+  if (output == NULL) {
+    fprintf(out, "[error] The output of '%s' would overwrite it.\n",
+            file->path);
+  } else {
+    status = compile(batch->options, file->path, output,
+                     batch->managers[worker]);
+  }
+
+  diagnostics_redirect(NULL, NULL);
+  fclose(out);
+  fclose(err);
+  memory_free(output);
+
+  pthread_mutex_lock(&batch->lock);
+  file->status = status;
+  file->done = true;
+  pthread_cond_broadcast(&batch->done);
+  pthread_mutex_unlock(&batch->lock);
+}
+
+// Adds each line of the manifest to the paths, skipping empty ones. The
+// paths point into the returned text.
+static char *read_manifest(const char *path, const char ***paths,
+                           int *num_paths) {
+  char *text = read_file(path);
+  if (text == NULL)
+    return NULL;
+
+  int lines = 1;
+  for (char *c = text; *c; c++)
+    lines += *c == '\n';
+
+  *paths = memory_realloc(MEMORY_SOURCE, *paths,
+                          (*num_paths + lines) * sizeof(**paths));
+  if (*paths == NULL)
+    ERROR_OUT();
+
+  for (char *line = strtok(text, "\r\n"); line; line = strtok(NULL, "\r\n"))
+    (*paths)[(*num_paths)++] = line;
+
+  return text;
+}
+
+// Compiles every file on a pool of worker threads, each with a pass
+// manager of its own, the first of which is manager, and writes what each
+// compile reported in the order of the files, as soon as the files before
+// it are done.
+static int compile_batch(struct options *options, const char **paths,
+                         int num_paths, pass_manager_t *manager, int argc,
+                         char *argv[]) {
+  int jobs = options->jobs ? options->jobs : sysconf(_SC_NPROCESSORS_ONLN);
+  if (jobs > num_paths)
+    jobs = num_paths;
+  if (jobs < 1)
+    jobs = 1;
+
+  struct batch batch = {.options = options};
+  batch.files = memory_calloc(MEMORY_BATCH, num_paths, sizeof(*batch.files));
+  batch.managers = memory_calloc(MEMORY_BATCH, jobs, sizeof(*batch.managers));
+  if (batch.files == NULL || batch.managers == NULL)
+    ERROR_OUT();
+
+  // The toggles are known to be valid.
+  batch.managers[0] = manager;
+  for (int i = 1; i < jobs; i++)
+    batch.managers[i] = new_pass_manager(options->opt_level, argc, argv);
+
+  for (int i = 0; i < num_paths; i++)
+    batch.files[i].path = paths[i];
+  pthread_mutex_init(&batch.lock, NULL);
+  pthread_cond_init(&batch.done, NULL);
+
+  pool_t *pool = pool_new(jobs, num_paths, compile_file, &batch);
+
+  int status = 0;
+  for (int i = 0; i < num_paths; i++) {
+    struct batch_file *file = &batch.files[i];
+
+    pthread_mutex_lock(&batch.lock);
+    while (!file->done)
+      pthread_cond_wait(&batch.done, &batch.lock);
+    pthread_mutex_unlock(&batch.lock);
+
+    if (file->out_size > 0)
+      printf("%s:\n%s", file->path, file->out);
+    if (file->err_size > 0)
+      fprintf(stderr, "%s:\n%s", file->path, file->err);
+    free(file->out);
+    free(file->err);
+
+    if (file->status != 0)
+      status = 1;
+  }
+
+  pool_free(&pool);
+  pthread_cond_destroy(&batch.done);
+  pthread_mutex_destroy(&batch.lock);
+
+  for (int i = 1; i < jobs; i++)
+    pass_manager_free(&batch.managers[i]);
+  memory_free(batch.managers);
+  memory_free(batch.files);
+  return status;
+}
+
+int main(int argc, char *argv[]) {
+  // Every argument could be a file.
+  const char **paths = memory_alloc(MEMORY_SOURCE, argc * sizeof(*paths));
+  if (paths == NULL)
+    ERROR_OUT();
+
+  struct options options;
+  int num_paths;
+  char *manifest = NULL;
+  pass_manager_t *manager = NULL;
+  int status = 1;
+
+  if (!parse_options(argc, argv, &options, paths, &num_paths) ||
+      (num_paths == 0 && options.manifest == NULL && options.serve == NULL)) {
+    usage(argv[0]);
+    goto cleanup;
+  }
+
+  // Every other option comes with each request.
+  if (options.serve) {
+    if (argc != (options.jobs ? 3 : 2)) {
+      printf("[error] --serve takes no options but --jobs.\n");
+      goto cleanup;
+    }
+
+    int jobs = options.jobs ? options.jobs : sysconf(_SC_NPROCESSORS_ONLN);
+    status = server_run(options.serve, jobs > 0 ? jobs : 1) ? 0 : 1;
+    goto cleanup;
+  }
+
+  if (options.manifest) {
+    manifest = read_manifest(options.manifest, &paths, &num_paths);
+    if (manifest == NULL)
+      goto cleanup;
+  }
+
+  bool batch = options.manifest || num_paths > 1;
+  if (batch && single_file_option(&options)) {
+    printf("[error] %s takes a single input file.\n",
+           single_file_option(&options));
+    goto cleanup;
+  }
+
+  manager = new_pass_manager(options.opt_level, argc, argv);
+  if (manager == NULL)
+    goto cleanup;
+
+  if (options.trace) {
+    trace_start(options.trace_each_statement);
+  }
+
+  if (batch) {
+    status = compile_batch(&options, paths, num_paths, manager, argc, argv);
+  } else if (options.connect) {
+    status = compile_remote(&options, paths[0], argc, argv);
+  } else {
+    status = compile(&options, paths[0], options.output, manager);
+  }
+
+  // Spans a failure left open end here.
+  if (options.trace && !trace_write(options.trace))
+    status = 1;
+
+cleanup:
+  if (manager)
+    pass_manager_free(&manager);
+  memory_free(manifest);
+  memory_free(paths);
+  return status;
 }
@@ -0,0 +1,180 @@
+# Print runtime of the generated code: appends lines to a 64 KiB buffer and
+# writes it to stdout with write(2) when the next line may not fit and when
+# main returns (the epilogue calls print_flush). Assembled and embedded into
+# compiler/runtime_code.h and compiler/runtime_source.h by
+#
+#   make runtime-code
+#
+# The code follows main in .text and is called directly; nothing here is
+# global, so the same text links into an object, a freestanding executable
+# or the output of -S. Only the .bss references need relocating. Clobbers
+# what a System V call may, and uses the red zone below %rsp for digits.
+
+	.set capacity, 65536
+
+	# Longest line either function appends, rounded up to the 16 bytes
+	# print_i32 copies at once.
+	.set max_line, 16
+
+	.bss
+	.balign 16
+buffer:
+	.zero capacity
+length:
+	.zero 8
+
+	.text
+	# Filled with int3, the padding compiler/object.c writes after main (GAS
+	# would pick its own multi-byte nops for the default fill).
+	.p2align 4, 0xcc
+# print_i32(value): the decimal value and a newline. Two digits at a time
+# from `.Lpairs`, backwards into the red zone, then copied with one 16-byte
+# move.
+print_i32:
+	movq length(%rip), %rcx
+	cmpq $capacity - max_line, %rcx
+	ja 4f
+1:
+	movl %edi, %eax
+	negl %eax
+	cmovsl %edi, %eax             # |value|, INT_MIN as 2^31 unsigned
+	leaq -1(%rsp), %rsi
+	movb $'\n', (%rsi)
+	leaq .Lpairs(%rip), %r8
+	cmpl $100, %eax
+	jb 3f
+2:
+	movl %eax, %edx
+	imulq $0x51eb851f, %rdx, %rdx
+	shrq $37, %rdx                # value / 100
+	imull $100, %edx, %r9d
+	subl %r9d, %eax               # value % 100
+	movzwl (%r8,%rax,2), %r9d
+	subq $2, %rsi
+	movw %r9w, (%rsi)
+	movl %edx, %eax
+	cmpl $100, %eax
+	jae 2b
+3:
+	# Below 100: a pair, skipping its leading '0' below 10.
+	movzwl (%r8,%rax,2), %r9d
+	subq $2, %rsi
+	movw %r9w, (%rsi)
+	cmpl $10, %eax
+	adcq $0, %rsi
+	# The sign, kept only for negative values.
+	movb $'-', -1(%rsi)
+	movslq %edi, %rax
+	sarq $63, %rax
+	addq %rax, %rsi
+	movdqu (%rsi), %xmm0
+	leaq buffer(%rip), %rdx
+	movdqu %xmm0, (%rdx,%rcx)
+	movq %rsp, %rax
+	subq %rsi, %rax
+	addq %rax, %rcx
+	movq %rcx, length(%rip)
+	ret
+4:
+	pushq %rdi
+	call print_flush
+	popq %rdi
+	xorl %ecx, %ecx
+	jmp 1b
+
+	.p2align 4
+# print_bool(value): "true" or "false" and a newline, selected without a
+# branch and copied with one 8-byte move.
+print_bool:
+	movq length(%rip), %rcx
+	cmpq $capacity - max_line, %rcx
+	ja 2f
+1:
+	leaq .Lfalse(%rip), %rax
+	leaq .Ltrue(%rip), %rdx
+	movl $6, %esi
+	movl $5, %r8d
+	testl %edi, %edi
+	cmovneq %rdx, %rax
+	cmovnel %r8d, %esi
+	movq (%rax), %rdx
+	leaq buffer(%rip), %rax
+	movq %rdx, (%rax,%rcx)
+	addq %rsi, %rcx
+	movq %rcx, length(%rip)
+	ret
+2:
+	pushq %rdi
+	call print_flush
+	popq %rdi
+	xorl %ecx, %ecx
+	jmp 1b
+
+	.p2align 4
+# print_flush(): write(1, buffer, length) until everything is written or an
+# error occurs, then empties the buffer.
+print_flush:
+	movq length(%rip), %rdx
+	leaq buffer(%rip), %rsi
+1:
+	testq %rdx, %rdx
+	jz 2f
+	movl $1, %eax                 # write
+	movl $1, %edi
+	syscall
+	testq %rax, %rax
+	jle 2f
+	addq %rax, %rsi
+	subq %rax, %rdx
+	jmp 1b
+2:
+	movq $0, length(%rip)
+	ret
+
+	.p2align 4
+# print_init(): installs .Ltrap as the SIGFPE handler, called first by a main
+# that divides. The sigaction is built in the red zone.
+print_init:
+	leaq .Ltrap(%rip), %rax
+	movq %rax, -32(%rsp)          # handler
+	movq $0x04000000, -24(%rsp)   # flags: SA_RESTORER, which x86-64 requires
+	movq %rax, -16(%rsp)          # restorer, never reached: .Ltrap exits
+	movq $0, -8(%rsp)             # mask
+	movl $13, %eax                # rt_sigaction
+	movl $8, %edi                 # SIGFPE
+	leaq -32(%rsp), %rsi
+	xorl %edx, %edx
+	movl $8, %r10d                # sizeof(sigset_t)
+	syscall
+	ret
+
+	.p2align 4
+# .Ltrap(signal): a division trapped. Writes what is buffered and the error
+# --run reports, then exits with status 1 as --run does.
+.Ltrap:
+	call print_flush
+	movl $1, %eax                 # write
+	movl $2, %edi
+	leaq .Ltrapped(%rip), %rsi
+	movl $.Ltrapped_end - .Ltrapped, %edx
+	syscall
+	movl $231, %eax               # exit_group(1)
+	movl $1, %edi
+	syscall
+
+.Ltrapped:
+	.ascii "[error] The program trapped on a division.\n"
+.Ltrapped_end:
+.Ltrue:
+	.ascii "true\n\0\0\0"
+.Lfalse:
+	.ascii "false\n\0\0"
+
+# "00", "01", ..., "99".
+	.p2align 4
+.Lpairs:
+	.irp tens, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9
+	.irp ones, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9
+	.ascii "\tens\ones"
+	.endr
+	.endr
@@ -0,0 +1,23 @@
+# Entry of freestanding executables (--freestanding). Assembled and embedded
+# into compiler/runtime_code.h by
+#
+#   make runtime-code
+#
+# The compiler places the generated main directly after this code, at the
+# `main` label below, followed by the print runtime (runtime/print.s); main
+# flushes the output itself before returning.
+
+	.text
+	.globl _start
+
+# The kernel enters with %rsp 16-byte aligned, which the call keeps as the
+# System V ABI expects. main returns 0.
+_start:
+	xorl %ebp, %ebp
+	call main
+	movl $60, %eax                # exit(0)
+	xorl %edi, %edi
+	syscall
+
+	.p2align 4
+main:
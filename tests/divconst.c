@@ -0,0 +1,136 @@
+// Checks that the sequence the backend emits for a division by a constant
+// (divconst_eval follows it instruction for instruction) gives the quotient
+// idivl gives, truncated towards zero:
+//
+//   - every divisor in [-DENSE, DENSE], every power of two and its
+//     negation, the extremes, and SPARSE divisors spread over the whole
+//     range, each against the dividends around zero, the extremes and the
+//     multiples of the divisor nearest them, and SAMPLES others
+//   - with --exhaustive, also every one of the 2^32 dividends for the
+//     divisors in FULL, which cover each strategy and both signs; this
+//     takes about half a minute per divisor
+//
+// INT_MIN / -1 overflows idivl as well, and is skipped.
+//
+//   divconst [--exhaustive]
+//   make test
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../compiler/divconst.h"
+
+#define DENSE 65536
+#define SPARSE 100000
+#define SAMPLES 512
+
+static const int FULL[] = {2, -2, 3, -3, 7, -7, 1 << 30, INT_MIN, 641};
+
+static int failures;
+
+// splitmix64, so that every run checks the same values.
+static uint64_t next(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void check(const struct divconst_plan *plan, int dividend) {
+  if (dividend == INT_MIN && plan->divisor == -1)
+    return;
+
+  int expected = dividend / plan->divisor;
+  int got = divconst_eval(plan, dividend);
+  if (got != expected && failures++ < 20)
+    printf("divconst: %d / %d gave %d, not %d\n", dividend, plan->divisor,
+           got, expected);
+}
+
+// The dividends around q * divisor, for the quotients q nearest zero and
+// the extremes.
+static void check_multiples(const struct divconst_plan *plan) {
+  long long divisor = plan->divisor;
+  long long quotients[] = {0,
+                           1,
+                           -1,
+                           2,
+                           INT_MAX / divisor,
+                           INT_MIN / divisor,
+                           INT_MAX / divisor - 1,
+                           INT_MIN / divisor + 1};
+
+  for (size_t i = 0; i < sizeof(quotients) / sizeof(quotients[0]); i++) {
+    for (int delta = -2; delta <= 2; delta++) {
+      long long dividend = quotients[i] * divisor + delta;
+      if (dividend >= INT_MIN && dividend <= INT_MAX)
+        check(plan, (int)dividend);
+    }
+  }
+}
+
+static void check_divisor(int divisor, uint64_t *state) {
+  struct divconst_plan plan = divconst_plan(divisor);
+
+  static const int edges[] = {0,       1,           -1,      2,
+                              -2,      INT_MAX,     INT_MIN, INT_MAX - 1,
+                              INT_MIN + 1};
+  for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    check(&plan, edges[i]);
+
+  check_multiples(&plan);
+  for (int i = 0; i < SAMPLES; i++)
+    check(&plan, (int)(uint32_t)next(state));
+}
+
+int main(int argc, char *argv[]) {
+  bool exhaustive = argc == 2 && strcmp(argv[1], "--exhaustive") == 0;
+  if (argc > 1 && !exhaustive) {
+    fprintf(stderr, "usage: %s [--exhaustive]\n", argv[0]);
+    return 1;
+  }
+
+  uint64_t state = 1;
+  long long divisors = 0;
+
+  for (int divisor = -DENSE; divisor <= DENSE; divisor++) {
+    if (divisor != 0) {
+      check_divisor(divisor, &state);
+      divisors++;
+    }
+  }
+
+  for (int k = 0; k < 31; k++) {
+    check_divisor(1 << k, &state);
+    check_divisor(-(1 << k), &state);
+    divisors += 2;
+  }
+  check_divisor(INT_MIN, &state);
+  check_divisor(INT_MAX, &state);
+  check_divisor(INT_MIN + 1, &state);
+  divisors += 3;
+
+  for (int i = 0; i < SPARSE; i++) {
+    int divisor = (int)(uint32_t)next(&state);
+    if (divisor != 0) {
+      check_divisor(divisor, &state);
+      divisors++;
+    }
+  }
+
+  size_t full = exhaustive ? sizeof(FULL) / sizeof(FULL[0]) : 0;
+  for (size_t i = 0; i < full; i++) {
+    struct divconst_plan plan = divconst_plan(FULL[i]);
+    uint32_t dividend = 0;
+    do {
+      check(&plan, (int)dividend);
+    } while (++dividend != 0);
+  }
+
+  printf("divconst: %lld divisors sampled, %zu over every dividend, %d "
+         "failures\n",
+         divisors, full, failures);
+  return failures != 0;
+}
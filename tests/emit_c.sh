@@ -0,0 +1,35 @@
+#!/bin/sh
+# Checks the C that --emit=c writes against the reference: compiled with
+# cc (or $CC) at -O0 and -O2, it must print what --interpret=ast prints and
+# exit as it does, for every program at every level.
+#
+#   tests/emit_c.sh
+#   make test
+
+NAME=emit_c
+. tests/lib.sh
+
+CC=${CC:-cc}
+
+for program in $PROGRAMS; do
+  outcome "$WORK/expected.txt" "$BIN" "$program" --interpret=ast
+  for level in -O0 -O1 -O2; do
+    if ! "$BIN" "$program" $level --emit=c -o "$WORK/out.c"; then
+      fail "$program $level: did not compile"
+      continue
+    fi
+    for cc_level in -O0 -O2; do
+      checks=$((checks + 1))
+      if ! "$CC" $cc_level -o "$WORK/out" "$WORK/out.c"; then
+        fail "$program $level: the C did not compile at $cc_level"
+        continue
+      fi
+      outcome "$WORK/got.txt" "$WORK/out"
+      if ! cmp -s "$WORK/expected.txt" "$WORK/got.txt"; then
+        fail "$program $level: the C at $cc_level differs from the reference"
+      fi
+    done
+  done
+done
+
+check_done
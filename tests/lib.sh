@@ -0,0 +1,50 @@
+# Sourced by the test scripts. Sets WORK to a scratch directory that is
+# removed on exit and PROGRAMS to the programs to check: the examples, the
+# programs in tests/, two of which trap on a division, and SEEDS programs of
+# bench/gen in each of three shapes. check_done prints the count the
+# script's checks and failures left and exits with whether all passed.
+
+BIN=${BIN:-./bin}
+GEN=${GEN:-build/bench/gen}
+SEEDS=${SEEDS:-10}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+PROGRAMS="examples/*.src tests/*.src"
+for seed in $(seq "$SEEDS"); do
+  "$GEN" --seed "$seed" --decls 20 --statements 20 --depth 3 \
+    > "$WORK/small$seed.src" &&
+    "$GEN" --seed "$seed" --decls 5 --statements 40 --depth 8 \
+      > "$WORK/deep$seed.src" &&
+    "$GEN" --seed "$seed" --decls 60 --statements 60 --depth 2 \
+      --assign-ratio 0.9 > "$WORK/assigns$seed.src" || exit 1
+  PROGRAMS="$PROGRAMS $WORK/small$seed.src $WORK/deep$seed.src"
+  PROGRAMS="$PROGRAMS $WORK/assigns$seed.src"
+done
+
+checks=0
+failures=0
+
+# outcome <file> <command>...: runs the command, leaving in file what it
+# printed to stdout, then what it printed to stderr, then its exit status.
+outcome() {
+  file=$1
+  shift
+  "$@" > "$file" 2> "$WORK/stderr.txt"
+  status=$?
+  cat "$WORK/stderr.txt" >> "$file"
+  echo "exit $status" >> "$file"
+}
+
+# fail <message>: counts a failed check, printing the first twenty.
+fail() {
+  failures=$((failures + 1))
+  [ "$failures" -le 20 ] && echo "$NAME: $1"
+}
+
+check_done() {
+  echo "$NAME: $checks checks, $failures failures"
+  [ "$failures" -eq 0 ]
+  exit
+}
@@ -0,0 +1,66 @@
+// Checks that every sequence of the multiply-by-constant table
+// (mulconst_eval follows it instruction for instruction) gives the product
+// imull gives, wrapped to 32 bits, for the multiplicands around zero and
+// the extremes and SAMPLES others. Constants are looked up over all of
+// [-RANGE, RANGE], well past what make mulconst-table generates.
+//
+//   make test
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../compiler/mulconst.h"
+
+#define RANGE 65536
+#define SAMPLES 4096
+
+static int failures;
+
+// splitmix64, so that every run checks the same values.
+static uint64_t next(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void check(const struct mulconst_entry *entry, int x) {
+  int expected = (int)((uint32_t)x * (uint32_t)entry->constant);
+  int got = mulconst_eval(entry, x);
+  if (got != expected && failures++ < 20)
+    printf("mulconst: %d * %d gave %d, not %d\n", x, entry->constant, got,
+           expected);
+}
+
+int main(void) {
+  static const int edges[] = {0,           1,           -1,
+                              2,           -2,          INT_MAX,
+                              INT_MIN,     INT_MAX - 1, INT_MIN + 1,
+                              1 << 16,     -(1 << 16),  0x55555555};
+
+  uint64_t state = 1;
+  int entries = 0;
+
+  for (int constant = -RANGE; constant <= RANGE; constant++) {
+    const struct mulconst_entry *entry = mulconst_lookup(constant);
+    if (entry == NULL)
+      continue;
+    entries++;
+
+    if (entry->constant != constant || entry->num_ops < 1 ||
+        entry->num_ops > MULCONST_MAX_OPS) {
+      if (failures++ < 20)
+        printf("mulconst: the entry for %d is malformed\n", constant);
+      continue;
+    }
+
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+      check(entry, edges[i]);
+    for (int i = 0; i < SAMPLES; i++)
+      check(entry, (int)(uint32_t)next(&state));
+  }
+
+  printf("mulconst: %d table entries, %d failures\n", entries, failures);
+  return failures != 0 || entries == 0;
+}
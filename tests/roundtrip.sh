@@ -0,0 +1,36 @@
+#!/bin/sh
+# Checks the in-process encoder against as(1): the object bin writes with
+# -c must disassemble, relocations included, to what as makes of the
+# assembly bin writes with -S, for every program at every level and with
+# the passes that change the instructions chosen.
+#
+#   tests/roundtrip.sh
+#   make test
+
+NAME=roundtrip
+. tests/lib.sh
+
+# The listing without the file name, comments and symbol annotations.
+dump() {
+  objdump -dr "$1" | tail -n +4 | sed 's|#.*||;s|<[^>]*>||'
+}
+
+for program in $PROGRAMS; do
+  for flags in -O0 -O1 -O2 "-O0 --enable=regalloc" \
+    "-O0 --enable=regalloc --enable=order --enable=peephole"; do
+    checks=$((checks + 1))
+    # shellcheck disable=SC2086
+    if ! "$BIN" "$program" $flags -S -o "$WORK/out.s" ||
+      ! as "$WORK/out.s" -o "$WORK/as.o" ||
+      ! "$BIN" "$program" $flags -c -o "$WORK/bin.o"; then
+      fail "$program $flags: did not compile"
+      continue
+    fi
+    dump "$WORK/as.o" > "$WORK/as.txt"
+    dump "$WORK/bin.o" > "$WORK/bin.txt"
+    cmp -s "$WORK/as.txt" "$WORK/bin.txt" ||
+      fail "$program $flags: -c and as of -S differ"
+  done
+done
+
+check_done
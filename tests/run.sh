@@ -0,0 +1,57 @@
+#!/bin/sh
+# Checks that a program loaded and run in process with --run behaves as the
+# executables bin writes do when they run, both the one linked against the
+# C library and the --freestanding one: the same output, the same error if
+# a division traps and the same exit status, for every program at every
+# level. The programs in tests/rejected/ must instead fail to compile with a
+# diagnostic, run in process or sent to a server, which must keep serving.
+#
+#   tests/run.sh
+#   make test
+
+NAME=run
+. tests/lib.sh
+
+for program in $PROGRAMS; do
+  for level in -O0 -O1 -O2; do
+    checks=$((checks + 1))
+    if ! "$BIN" "$program" $level -o "$WORK/libc" ||
+      ! "$BIN" "$program" $level --freestanding -o "$WORK/freestanding"; then
+      fail "$program $level: did not compile"
+      continue
+    fi
+    outcome "$WORK/run.txt" "$BIN" "$program" $level --run
+    for executable in libc freestanding; do
+      outcome "$WORK/$executable.txt" "$WORK/$executable"
+      cmp -s "$WORK/run.txt" "$WORK/$executable.txt" ||
+        fail "$program $level: --run and the $executable executable differ"
+    done
+  done
+done
+
+"$BIN" --serve="$WORK/bin.sock" &
+server=$!
+for i in $(seq 100); do
+  [ -S "$WORK/bin.sock" ] && break
+  sleep 0.05
+done
+
+for program in tests/rejected/*.src; do
+  for flags in --run --interpret "-c -o $WORK/out.o" \
+    "-c -o $WORK/out.o --connect=$WORK/bin.sock"; do
+    checks=$((checks + 1))
+    # shellcheck disable=SC2086
+    "$BIN" "$program" $flags > "$WORK/rejected.txt" 2>&1
+    status=$?
+    [ "$status" -eq 1 ] && grep -q error "$WORK/rejected.txt" ||
+      fail "$program $flags: exit status $status, not a diagnostic"
+  done
+done
+
+checks=$((checks + 1))
+"$BIN" examples/readme.src -c -o "$WORK/out.o" \
+  --connect="$WORK/bin.sock" || fail "the server stopped serving"
+kill "$server"
+wait "$server"
+
+check_done
@@ -0,0 +1,225 @@
+// Turns the assembled runtime into the headers the compiler includes:
+//
+//   embed <name> <object> [<name> <object> ...] > compiler/runtime_code.h
+//
+// writes, for each object, the bytes of its .text section as
+// runtime_<name>_code, the offset of every named symbol defined in it as a
+// RUNTIME_<SYMBOL> macro and, when it has a .bss section, its size as
+// RUNTIME_<NAME>_BSS_SIZE and the %rip-relative references to it as
+// runtime_<name>_relocs. Any other relocation is rejected.
+//
+//   embed --source <name> <file.s> > compiler/runtime_source.h
+//
+// writes the assembly itself as the string runtime_<name>_source, for -S.
+// Both are run by
+//
+//   make runtime-code
+
+#include <ctype.h>
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned char *read_file(const char *path, size_t *size) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "embed: cannot open '%s'\n", path);
+    exit(1);
+  }
+
+  fseek(file, 0L, SEEK_END);
+  *size = ftell(file);
+  rewind(file);
+
+  unsigned char *data = malloc(*size + 1);
+  if (data == NULL || fread(data, 1, *size, file) != *size) {
+    fprintf(stderr, "embed: cannot read '%s'\n", path);
+    exit(1);
+  }
+  data[*size] = '\0';
+
+  fclose(file);
+  return data;
+}
+
+static void print_upper(const char *name) {
+  while (*name == '_')
+    name++;
+  for (; *name; name++)
+    putchar(toupper((unsigned char)*name));
+}
+
+static void print_macro(const char *prefix, const char *name,
+                        unsigned long long value) {
+  printf("#define RUNTIME_");
+  if (prefix) {
+    print_upper(prefix);
+    putchar('_');
+  }
+  print_upper(name);
+  printf(" 0x%llx\n", value);
+}
+
+static void embed_object(const char *name, const char *path) {
+  size_t size;
+  unsigned char *data = read_file(path, &size);
+
+  Elf64_Ehdr *header = (Elf64_Ehdr *)data;
+  if (size < sizeof(*header) || memcmp(header->e_ident, ELFMAG, SELFMAG) ||
+      header->e_ident[EI_CLASS] != ELFCLASS64 || header->e_type != ET_REL) {
+    fprintf(stderr, "embed: '%s' is not an ELF64 object\n", path);
+    exit(1);
+  }
+
+  Elf64_Shdr *sections = (Elf64_Shdr *)(data + header->e_shoff);
+  const char *section_names =
+      (const char *)data + sections[header->e_shstrndx].sh_offset;
+
+  int text = -1;
+  int bss = -1;
+  int symtab = -1;
+  int rela_text = -1;
+  for (int i = 0; i < header->e_shnum; i++) {
+    const char *section = section_names + sections[i].sh_name;
+
+    if (strcmp(section, ".text") == 0)
+      text = i;
+    if (strcmp(section, ".bss") == 0)
+      bss = i;
+    if (sections[i].sh_type == SHT_SYMTAB)
+      symtab = i;
+    if (sections[i].sh_type == SHT_REL ||
+        (sections[i].sh_type == SHT_RELA && rela_text >= 0)) {
+      fprintf(stderr, "embed: '%s' has unsupported relocations (%s)\n", path,
+              section);
+      exit(1);
+    }
+    if (sections[i].sh_type == SHT_RELA)
+      rela_text = i;
+  }
+
+  if (text < 0 || symtab < 0) {
+    fprintf(stderr, "embed: '%s' has no .text or symbol table\n", path);
+    exit(1);
+  }
+  if (rela_text >= 0 && (int)sections[rela_text].sh_info != text) {
+    fprintf(stderr, "embed: '%s' relocates a section other than .text\n",
+            path);
+    exit(1);
+  }
+
+  Elf64_Sym *symbols = (Elf64_Sym *)(data + sections[symtab].sh_offset);
+  int num_symbols = sections[symtab].sh_size / sizeof(Elf64_Sym);
+  const char *names =
+      (const char *)data + sections[sections[symtab].sh_link].sh_offset;
+
+  printf("\n");
+  for (int i = 0; i < num_symbols; i++) {
+    Elf64_Sym *symbol = &symbols[i];
+    const char *symbol_name = names + symbol->st_name;
+    int type = ELF64_ST_TYPE(symbol->st_info);
+
+    if (symbol_name[0] == '\0' || symbol_name[0] == '.' ||
+        type == STT_SECTION || type == STT_FILE)
+      continue;
+
+    if (symbol->st_shndx == text)
+      print_macro(NULL, symbol_name, symbol->st_value);
+  }
+  if (bss >= 0 && sections[bss].sh_size > 0)
+    print_macro(name, "bss_size", sections[bss].sh_size);
+
+  printf("\nstatic const unsigned char runtime_%s_code[] = {", name);
+  const unsigned char *code = data + sections[text].sh_offset;
+  for (size_t i = 0; i < sections[text].sh_size; i++) {
+    printf(i % 12 == 0 ? "\n    " : " ");
+    printf("0x%02x,", code[i]);
+  }
+  printf("\n};\n");
+
+  if (rela_text < 0) {
+    free(data);
+    return;
+  }
+
+  printf("\nstatic const struct runtime_reloc runtime_%s_relocs[] = {\n",
+         name);
+  Elf64_Rela *relas = (Elf64_Rela *)(data + sections[rela_text].sh_offset);
+  int num_relas = sections[rela_text].sh_size / sizeof(Elf64_Rela);
+  for (int i = 0; i < num_relas; i++) {
+    Elf64_Sym *symbol = &symbols[ELF64_R_SYM(relas[i].r_info)];
+    if (ELF64_R_TYPE(relas[i].r_info) != R_X86_64_PC32 ||
+        ELF64_ST_TYPE(symbol->st_info) != STT_SECTION ||
+        symbol->st_shndx != bss) {
+      fprintf(stderr, "embed: '%s' has a relocation other than to .bss\n",
+              path);
+      exit(1);
+    }
+    printf("    {0x%llx, %lld},\n", (unsigned long long)relas[i].r_offset,
+           (long long)relas[i].r_addend);
+  }
+  printf("};\n");
+
+  free(data);
+}
+
+static void embed_source(const char *name, const char *path) {
+  size_t size;
+  char *source = (char *)read_file(path, &size);
+
+  printf("\nstatic const char runtime_%s_source[] =", name);
+  for (size_t i = 0; i < size; i++) {
+    if (i == 0 || source[i - 1] == '\n')
+      printf("\n    \"");
+
+    switch (source[i]) {
+    case '\n':
+      printf("\\n\"");
+      break;
+    case '\t':
+      printf("\\t");
+      break;
+    case '"':
+    case '\\':
+      printf("\\%c", source[i]);
+      break;
+    default:
+      putchar(source[i]);
+    }
+  }
+  if (size > 0 && source[size - 1] != '\n')
+    putchar('"');
+  printf(";\n");
+
+  free(source);
+}
+
+int main(int argc, char *argv[]) {
+  int source = argc == 4 && strcmp(argv[1], "--source") == 0;
+  if (!source && (argc < 3 || argc % 2 != 1)) {
+    fprintf(stderr,
+            "usage: %s <name> <object> [<name> <object> ...]\n"
+            "       %s --source <name> <file.s>\n",
+            argv[0], argv[0]);
+    return 1;
+  }
+
+  const char *guard = source ? "runtime_source_h" : "runtime_code_h";
+  printf("// Generated by tools/embed.c from runtime/ - do not edit.\n");
+  printf("#ifndef %s\n#define %s\n", guard, guard);
+
+  if (source) {
+    embed_source(argv[2], argv[3]);
+  } else {
+    printf("\n// A 32-bit field at `offset` in the code, to be set to the "
+           "address of the\n// .bss section plus `addend` minus the address "
+           "of the field.\n");
+    printf("struct runtime_reloc {\n  unsigned offset;\n  int addend;\n};\n");
+    for (int i = 1; i < argc; i += 2)
+      embed_object(argv[i], argv[i + 1]);
+  }
+
+  printf("\n#endif\n");
+  return 0;
+}
@@ -0,0 +1,256 @@
+// Throughput of the ways a program's output is printed, in values per
+// second: the print runtime of the generated code (runtime/print.s, loaded
+// from compiler/runtime_code.h), the buffer the interpreters and --run write
+// to (compiler/output.c) and the C library's printf and puts, which the
+// generated code called before. Output goes to /dev/null while timing; a
+// shorter run into temporary files first checks that all three print the
+// same bytes.
+//
+//   make print-bench
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../compiler/output.h"
+#include "../compiler/runtime_code.h"
+
+#define PAGE_SIZE 0x1000
+#define CHECK_COUNT 1000000
+#define RUNS 3
+
+// runtime/print.s, copied into executable memory with its .bss on the
+// following pages.
+static void (*print_i32)(int value);
+static void (*print_bool)(int value);
+static void (*print_flush)(void);
+
+static struct output output;
+
+static void load_runtime(void) {
+  size_t code = (sizeof(runtime_print_code) + PAGE_SIZE - 1) & -PAGE_SIZE;
+  unsigned char *memory =
+      mmap(NULL, code + RUNTIME_PRINT_BSS_SIZE, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    perror("printbench: mmap");
+    exit(1);
+  }
+
+  memcpy(memory, runtime_print_code, sizeof(runtime_print_code));
+  int num_relocs = sizeof(runtime_print_relocs) / sizeof(*runtime_print_relocs);
+  for (int i = 0; i < num_relocs; i++) {
+    const struct runtime_reloc *reloc = &runtime_print_relocs[i];
+    int value = (int)(code + reloc->addend - reloc->offset);
+    memcpy(memory + reloc->offset, &value, sizeof(value));
+  }
+
+  if (mprotect(memory, code, PROT_READ | PROT_EXEC) != 0) {
+    perror("printbench: mprotect");
+    exit(1);
+  }
+
+  print_i32 = (void (*)(int))(memory + RUNTIME_PRINT_I32);
+  print_bool = (void (*)(int))(memory + RUNTIME_PRINT_BOOL);
+  print_flush = (void (*)(void))(memory + RUNTIME_PRINT_FLUSH);
+}
+
+static void runtime_i32(const int *values, int count) {
+  for (int i = 0; i < count; i++)
+    print_i32(values[i]);
+  print_flush();
+}
+
+static void runtime_bool(const int *values, int count) {
+  for (int i = 0; i < count; i++)
+    print_bool(values[i] & 1);
+  print_flush();
+}
+
+static void output_i32s(const int *values, int count) {
+  for (int i = 0; i < count; i++)
+    output_i32(&output, values[i]);
+  output_flush(&output);
+  fflush(stdout);
+}
+
+static void output_bools(const int *values, int count) {
+  for (int i = 0; i < count; i++)
+    output_bool(&output, values[i] & 1);
+  output_flush(&output);
+  fflush(stdout);
+}
+
+static void libc_i32(const int *values, int count) {
+  for (int i = 0; i < count; i++)
+    printf("%d\n", values[i]);
+  fflush(stdout);
+}
+
+static void libc_bool(const int *values, int count) {
+  for (int i = 0; i < count; i++)
+    puts(values[i] & 1 ? "true" : "false");
+  fflush(stdout);
+}
+
+struct printer {
+  const char *name;
+  void (*i32)(const int *values, int count);
+  void (*bool_)(const int *values, int count);
+};
+
+static const struct printer printers[] = {
+    {"runtime/print.s", runtime_i32, runtime_bool},
+    {"compiler/output.c", output_i32s, output_bools},
+    {"printf/puts", libc_i32, libc_bool},
+};
+
+#define NUM_PRINTERS (int)(sizeof(printers) / sizeof(*printers))
+
+static long long now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Every printer writes to file descriptor 1, through stdio or not.
+static void redirect(int fd) {
+  fflush(stdout);
+  if (dup2(fd, STDOUT_FILENO) < 0) {
+    perror("printbench: dup2");
+    exit(1);
+  }
+}
+
+// Values of every length from 1 to 11 characters, signs mixed.
+static int *make_values(int count) {
+  int *values = malloc(count * sizeof(*values));
+  if (values == NULL) {
+    perror("printbench: malloc");
+    exit(1);
+  }
+
+  unsigned state = 12345;
+  for (int i = 0; i < count; i++) {
+    state = state * 1664525u + 1013904223u;
+    unsigned bits = state;
+    state = state * 1664525u + 1013904223u;
+    unsigned value = bits >> (state >> 27);
+    values[i] = (int)(state & 1u << 26 ? 0u - value : value);
+  }
+  return values;
+}
+
+static char *contents(int fd, size_t *size) {
+  *size = lseek(fd, 0, SEEK_END);
+  char *data = malloc(*size + 1);
+  if (data == NULL || pread(fd, data, *size, 0) != (ssize_t)*size) {
+    perror("printbench: read");
+    exit(1);
+  }
+  return data;
+}
+
+static bool check(const int *values, int saved) {
+  char *expected[2] = {NULL, NULL};
+  size_t expected_size[2];
+  bool ok = true;
+
+  for (int i = 0; i < NUM_PRINTERS; i++) {
+    for (int kind = 0; kind < 2; kind++) {
+      FILE *file = tmpfile();
+      if (file == NULL) {
+        perror("printbench: tmpfile");
+        exit(1);
+      }
+
+      redirect(fileno(file));
+      (kind == 0 ? printers[i].i32 : printers[i].bool_)(values, CHECK_COUNT);
+      redirect(saved);
+
+      size_t size;
+      char *data = contents(fileno(file), &size);
+      fclose(file);
+
+      if (expected[kind] == NULL) {
+        expected[kind] = data;
+        expected_size[kind] = size;
+        continue;
+      }
+
+      if (size != expected_size[kind] || memcmp(data, expected[kind], size)) {
+        fprintf(stderr, "printbench: %s prints other %s than %s\n",
+                printers[i].name, kind == 0 ? "integers" : "booleans",
+                printers[0].name);
+        ok = false;
+      }
+      free(data);
+    }
+  }
+
+  free(expected[0]);
+  free(expected[1]);
+  return ok;
+}
+
+// Best of RUNS, in values per second.
+static double throughput(void (*print)(const int *, int), const int *values,
+                         int count, int null, int saved) {
+  long long best = 0;
+  for (int run = 0; run < RUNS; run++) {
+    redirect(null);
+    long long start = now();
+    print(values, count);
+    long long elapsed = now() - start;
+    redirect(saved);
+
+    if (run == 0 || elapsed < best)
+      best = elapsed;
+  }
+  return count / (best / 1e9);
+}
+
+int main(int argc, char *argv[]) {
+  int count = 10000000;
+
+  if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+    count = atoi(argv[2]);
+  } else if (argc > 1) {
+    count = 0;
+  }
+
+  if (count < CHECK_COUNT) {
+    fprintf(stderr, "usage: %s [-n <values, at least %d>]\n", argv[0],
+            CHECK_COUNT);
+    return 1;
+  }
+
+  load_runtime();
+  output_init(&output, stdout);
+
+  int *values = make_values(count);
+  int saved = dup(STDOUT_FILENO);
+  int null = open("/dev/null", O_WRONLY);
+  if (saved < 0 || null < 0) {
+    perror("printbench: /dev/null");
+    return 1;
+  }
+
+  if (!check(values, saved))
+    return 1;
+
+  printf("%d values, best of %d\n", count, RUNS);
+  printf("%-20s %14s %14s\n", "printer", "i32 (M/s)", "bool (M/s)");
+  for (int i = 0; i < NUM_PRINTERS; i++) {
+    double i32 = throughput(printers[i].i32, values, count, null, saved);
+    double bool_ = throughput(printers[i].bool_, values, count, null, saved);
+    printf("%-20s %14.1f %14.1f\n", printers[i].name, i32 / 1e6, bool_ / 1e6);
+  }
+
+  free(values);
+  return 0;
+}
@@ -0,0 +1,214 @@
+// Offline superoptimiser for multiplication by small constants.
+//
+// Enumerates every sequence of up to --max-insns shl/add/sub/lea
+// instructions over the multiplicand and keeps, for each constant in
+// [--min, --max], the sequence with the shortest critical path (ties broken by
+// instruction count). Sequences are treated as three-address code with a
+// latency of one cycle per instruction; only those that beat imull's three
+// cycles (--max-latency) are written out. The output is the table included by
+// compiler/mulconst.c:
+//
+//   make mulconst-table
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../compiler/mulconst.h"
+
+struct candidate {
+  bool found;
+  int latency;
+  int num_ops;
+  struct mulconst_op ops[MULCONST_MAX_OPS];
+};
+
+struct search {
+  int min;
+  int max;
+  int max_latency;
+  int max_insns;
+
+  struct candidate *best;
+
+  unsigned int values[MULCONST_MAX_OPS + 1];
+  int latencies[MULCONST_MAX_OPS + 1];
+  struct mulconst_op ops[MULCONST_MAX_OPS];
+};
+
+static const char *kind_to_string(enum mulconst_op_kind kind) {
+  switch (kind) {
+  case MULCONST_SHL:
+    return "MULCONST_SHL";
+  case MULCONST_ADD:
+    return "MULCONST_ADD";
+  case MULCONST_SUB:
+    return "MULCONST_SUB";
+  case MULCONST_LEA:
+    return "MULCONST_LEA";
+  default:
+    UNREACHABLE();
+    return NULL;
+  }
+}
+
+static void search_run(struct search *search, int depth);
+
+static void try_op(struct search *search, int depth, struct mulconst_op op) {
+  unsigned int a = search->values[op.a];
+  unsigned int b = search->values[op.b];
+  unsigned int value;
+  int latency = search->latencies[op.a];
+
+  switch (op.kind) {
+  case MULCONST_SHL:
+    value = a << op.imm;
+    break;
+  case MULCONST_ADD:
+    value = a + b;
+    break;
+  case MULCONST_SUB:
+    value = a - b;
+    break;
+  case MULCONST_LEA:
+    value = a + b * (unsigned int)op.imm;
+    break;
+  default:
+    UNREACHABLE();
+    return;
+  }
+
+  if (op.kind != MULCONST_SHL && search->latencies[op.b] > latency)
+    latency = search->latencies[op.b];
+  latency++;
+
+  if (latency > search->max_latency)
+    return;
+
+  // A value that is already available can never shorten a sequence.
+  for (int i = 0; i <= depth; i++) {
+    if (search->values[i] == value)
+      return;
+  }
+
+  search->values[depth + 1] = value;
+  search->latencies[depth + 1] = latency;
+  search->ops[depth] = op;
+
+  int constant = (int)value;
+  if (search->min <= constant && constant <= search->max) {
+    struct candidate *best = &search->best[constant - search->min];
+
+    if (!best->found || latency < best->latency ||
+        (latency == best->latency && depth + 1 < best->num_ops)) {
+      best->found = true;
+      best->latency = latency;
+      best->num_ops = depth + 1;
+      memcpy(best->ops, search->ops, sizeof(best->ops[0]) * (depth + 1));
+    }
+  }
+
+  search_run(search, depth + 1);
+}
+
+static void search_run(struct search *search, int depth) {
+  if (depth == search->max_insns)
+    return;
+
+  for (int a = 0; a <= depth; a++) {
+    for (int imm = 1; imm < 32; imm++) {
+      try_op(search, depth, (struct mulconst_op){MULCONST_SHL, a, a, imm});
+    }
+
+    for (int b = a; b <= depth; b++) {
+      try_op(search, depth, (struct mulconst_op){MULCONST_ADD, a, b, 0});
+    }
+
+    for (int b = 0; b <= depth; b++) {
+      try_op(search, depth, (struct mulconst_op){MULCONST_SUB, a, b, 0});
+
+      for (int imm = 1; imm <= 8; imm *= 2) {
+        try_op(search, depth, (struct mulconst_op){MULCONST_LEA, a, b, imm});
+      }
+    }
+  }
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "[error] Usage: %s [--min N] [--max N] [--max-latency N] "
+          "[--max-insns N]\n",
+          name);
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+  struct search search = {
+      .min = -128, .max = 1024, .max_latency = 2, .max_insns = 3};
+
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 == argc)
+      usage(argv[0]);
+
+    int value = atoi(argv[i + 1]);
+
+    if (strcmp(argv[i], "--min") == 0) {
+      search.min = value;
+    } else if (strcmp(argv[i], "--max") == 0) {
+      search.max = value;
+    } else if (strcmp(argv[i], "--max-latency") == 0) {
+      search.max_latency = value;
+    } else if (strcmp(argv[i], "--max-insns") == 0) {
+      search.max_insns = value;
+    } else {
+      usage(argv[0]);
+    }
+
+    i++;
+  }
+
+  if (search.min > search.max || search.max_insns < 1 ||
+      search.max_insns > MULCONST_MAX_OPS)
+    usage(argv[0]);
+
+  search.best = calloc(search.max - search.min + 1, sizeof(*search.best));
+  if (search.best == NULL) {
+    fprintf(stderr, "superopt: out of memory\n");
+    return 1;
+  }
+
+  search.values[0] = 1;
+  search.latencies[0] = 0;
+  search_run(&search, 0);
+
+  printf("// Generated by tools/superopt.c - do not edit.\n");
+  printf("// superopt --min %d --max %d --max-latency %d --max-insns %d\n",
+         search.min, search.max, search.max_latency, search.max_insns);
+  printf("#ifndef mulconst_table_h\n#define mulconst_table_h\n\n");
+  printf("#include \"mulconst.h\"\n\n");
+  printf("static const struct mulconst_entry mulconst_table[] = {\n");
+
+  int count = 0;
+  for (int constant = search.min; constant <= search.max; constant++) {
+    struct candidate *best = &search.best[constant - search.min];
+    if (!best->found)
+      continue;
+
+    printf("    {%d, %d, %d, {", constant, best->latency, best->num_ops);
+    for (int i = 0; i < best->num_ops; i++) {
+      printf("%s{%s, %d, %d, %d}", i ? ", " : "",
+             kind_to_string(best->ops[i].kind), best->ops[i].a,
+             best->ops[i].b, best->ops[i].imm);
+    }
+    printf("}},\n");
+    count++;
+  }
+
+  printf("};\n\n#endif\n");
+
+  fprintf(stderr, "%d of %d constants beat imull\n", count,
+          search.max - search.min + 1);
+
+  free(search.best);
+  return 0;
+}
@@ -0,0 +1,166 @@
+// Compares the bytecode VM (compiler/vm.c) with the reference AST evaluator
+// (compiler/eval.c) on the same programs. The IR is lowered without
+// optimisation, as constant folding would leave only the prints, and output
+// is discarded while timing.
+//
+//   make vm-bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../compiler/ast.h"
+#include "../compiler/bytecode.h"
+#include "../compiler/eval.h"
+#include "../compiler/ir.h"
+#include "../compiler/output.h"
+#include "../compiler/parser.h"
+#include "../compiler/resolver.h"
+#include "../compiler/scanner.h"
+#include "../compiler/symbols.h"
+#include "../compiler/typechecker.h"
+#include "../compiler/vm.h"
+
+#define WARMUP 1000
+
+static struct output output;
+
+static char *read_file(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "vmbench: cannot open '%s'\n", path);
+    exit(1);
+  }
+
+  fseek(file, 0L, SEEK_END);
+  size_t size = ftell(file);
+  rewind(file);
+
+  char *data = malloc(size + 1);
+  if (data == NULL || fread(data, 1, size, file) != size) {
+    fprintf(stderr, "vmbench: cannot read '%s'\n", path);
+    exit(1);
+  }
+
+  fclose(file);
+  data[size] = '\0';
+  return data;
+}
+
+static long long now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Output of one run, to check both interpreters agree.
+static char *capture(struct ast_node *root, struct bytecode *code) {
+  char *data = NULL;
+  size_t size = 0;
+  FILE *file = open_memstream(&data, &size);
+
+  output_init(&output, file);
+  if (code) {
+    vm_run(code, &output);
+  } else {
+    eval(root, &output);
+  }
+  output_flush(&output);
+
+  fclose(file);
+  return data;
+}
+
+static double time_runs(struct ast_node *root, struct bytecode *code,
+                        int iterations) {
+  output_init(&output, NULL);
+
+  for (int i = 0; i < WARMUP; i++) {
+    if (code) {
+      vm_run(code, &output);
+    } else {
+      eval(root, &output);
+    }
+  }
+
+  long long start = now();
+  for (int i = 0; i < iterations; i++) {
+    if (code) {
+      vm_run(code, &output);
+    } else {
+      eval(root, &output);
+    }
+  }
+
+  return (double)(now() - start) / iterations;
+}
+
+static bool bench(const char *path, int iterations) {
+  char *src = read_file(path);
+  scanner_t *scanner = scanner_new(src);
+  parser_t *parser = parser_new(scanner);
+  symbol_table_t *table = symbol_table_new(100);
+  struct ast_node *root = NULL;
+
+  if (!parser_run(parser, &root) || !resolver_generate_table(root, table) ||
+      typecheck(root, table) == TYPE_ERROR) {
+    fprintf(stderr, "vmbench: '%s' does not compile\n", path);
+    return false;
+  }
+
+  struct ir_program *program = ir_new(root, table);
+  struct bytecode *code = bytecode_new(program);
+  if (code == NULL)
+    return false;
+
+  char *expected = capture(root, NULL);
+  char *actual = capture(root, code);
+  bool same = strcmp(expected, actual) == 0;
+
+  if (same) {
+    double ast = time_runs(root, NULL, iterations);
+    double vm = time_runs(root, code, iterations);
+
+    printf("%-24s %6d %6d %6d %10.1f %10.1f %8.2fx\n", path,
+           program->num_instrs, code->num_instrs, code->num_superinstrs, ast,
+           vm, ast / vm);
+  } else {
+    fprintf(stderr, "vmbench: '%s' prints differently\n", path);
+  }
+
+  free(expected);
+  free(actual);
+  bytecode_free(&code);
+  ir_free(&program);
+  ast_free(&root);
+  parser_free(&parser);
+  scanner_free(&scanner);
+  symbol_table_free(&table);
+  free(src);
+  return same;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = 100000;
+  int first = 1;
+
+  if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+    iterations = atoi(argv[2]);
+    first = 3;
+  }
+
+  if (first >= argc || iterations <= 0) {
+    fprintf(stderr, "usage: %s [-n <iterations>] <file>...\n", argv[0]);
+    return 1;
+  }
+
+  printf("%-24s %6s %6s %6s %10s %10s %9s\n", "program", "ir", "bc", "fused",
+         "ast (ns)", "vm (ns)", "speedup");
+
+  bool ok = true;
+  for (int i = first; i < argc; i++)
+    ok = bench(argv[i], iterations) && ok;
+
+  return ok ? 0 : 1;
+}